@@ -51,6 +51,7 @@
 #endif
 #include "cybsp.h"
 #include "cy_ota_flash.h"
+#include "cy_ota_bootloader_abstraction_log.h"
 #include "cyabs_rtos.h"
 
 #if defined(PSE84)
@@ -101,7 +102,8 @@ static cy_stc_smif_mem_info_t smif_mem_info;
 
 #endif /* PSE84 */
 
-#define CY_BOOT_TRAILER_MAX_UPDATE_SIZE             (16)
+/* Largest image trailer update, the end of the trailer written by cy_flash_area_boot_set_pending() */
+#define CY_BOOT_TRAILER_MAX_UPDATE_SIZE             (40)
 
 #define CY_SS0_SMIF_ID         (1U) /* Assume SlaveSelect_0 is used for External Memory */
 
@@ -42,6 +42,7 @@
 
 bool qspi_is_semper_flash(uint8_t const id[], uint16_t length);
 cy_en_smif_status_t qspi_configure_semper_flash(void);
+bool qspi_semper_reset_required(void);
 cy_en_smif_status_t qspi_read_memory_id(uint8_t *id, uint16_t length);
 
 #endif
@@ -64,6 +64,16 @@
 #define SEMPER_CFR2N_ADRBYT     (1U << 7U) /* Address Byte Length selection bit offset in CFR2N register */
 #define SEMPER_CFR3N_UNHYSA     (1U << 3U) /* Uniform or Hybrid Sector Architecture selection bit offset in CFR3N register */
 
+/*
+ * CY_OTA_SEMPER_HYBRID_SECTORS keeps the 4 KB parameter sectors (Hybrid Sector Architecture) so
+ * small updates like image trailers erase 4 KB instead of a 256 KB sector.
+ */
+#ifdef CY_OTA_SEMPER_HYBRID_SECTORS
+#define SEMPER_CFR3N_SECTARCH   (0U)
+#else
+#define SEMPER_CFR3N_SECTARCH   SEMPER_CFR3N_UNHYSA
+#endif
+
 #define SEMPER_WRARG_DATA_INDEX (4U) /* Input data index for WRARG command */
 
 #define SEMPER_WR_NV_TIMEOUT    (500000U) /* Nonvolatile Register Write operation timeout */
@@ -76,6 +86,9 @@
 #define PARAM_ID_MSB_OFFSET     (0x08U)  /* The offset of Parameter ID MSB */
 #define PARAM_ID_LSB_MASK       (0xFFUL) /* The mask of Parameter ID LSB */
 
+/* CFR3N was changed, the sector architecture takes effect at the next reset */
+static bool semper_reset_required = false;
+
 static cy_en_smif_status_t qspi_read_register(uint32_t address, uint8_t *value);
 static cy_en_smif_status_t qspi_write_register(uint32_t address, uint8_t value);
 static cy_en_smif_status_t qspi_enter_4byte_addr_mode(void);
@@ -148,18 +161,26 @@ cy_en_smif_status_t qspi_configure_semper_flash(void)
             status = qspi_write_register(SEMPER_CFR2N_ADDR, regVal);
         }
 
-        /* Enable Uniform Sector Architecture selection */
+        /* Select Uniform or Hybrid Sector Architecture */
         if(CY_SMIF_SUCCESS == status)
         {
             status = qspi_read_register(SEMPER_CFR3N_ADDR, &regVal);
             if((CY_SMIF_SUCCESS == status) &&
-               ((regVal & SEMPER_CFR3N_UNHYSA) == 0U))
+               ((regVal & SEMPER_CFR3N_UNHYSA) != SEMPER_CFR3N_SECTARCH))
             {
-                regVal |= SEMPER_CFR3N_UNHYSA;
+                regVal = (uint8_t)((regVal & ~SEMPER_CFR3N_UNHYSA) | SEMPER_CFR3N_SECTARCH);
                 status = qspi_write_register(SEMPER_CFR3N_ADDR, regVal);
+                /* CFR3N is copied to CFR3V at reset. Until then the flash, its SFDP sector map
+                 * and every memory configuration detected from it keep the previous architecture.
+                 */
+                if(CY_SMIF_SUCCESS == status)
+                {
+                    semper_reset_required = true;
+                }
             }
         }
 
+        /* 256 KB sectors, hybrid regions of the parameter sectors keep their own erase command */
         if(CY_SMIF_SUCCESS == status)
         {
             memCfg = qspi_get_memory_config(0);
@@ -172,6 +193,12 @@ cy_en_smif_status_t qspi_configure_semper_flash(void)
     return status;
 }
 
+/* True when qspi_configure_semper_flash() changed the sector architecture and a reset is needed */
+bool qspi_semper_reset_required(void)
+{
+    return semper_reset_required;
+}
+
 /* Read 6 bytes of Manufacturer and Device ID */
 cy_en_smif_status_t qspi_read_memory_id(uint8_t *id, uint16_t length)
 {
@@ -44,6 +44,11 @@
 #include "cyhal.h"
 #include "cybsp.h"
 #include "cy_ota_flash.h"
+#include "cy_ota_bootloader_abstraction_log.h"
+#include "cy_ota_buffer_scan.h"
+#if defined (CY_RTOS_AWARE)
+#include "cyabs_rtos.h"
+#endif
 
 #if !(defined (CYW20829B0LKML) || defined (CYW20829B1010) || defined (CYW89829B01MKSBG) || defined (CYW89829B1232))
 #include <cycfg_pins.h>
@@ -74,9 +79,60 @@
 #define CY_FLASH_BASE                       0x10000000UL
 #endif /* XMC7100 */
 
-#if !defined (CY_DISABLE_XMC7000_DATA_CACHE) && defined (__DCACHE_PRESENT) && (__DCACHE_PRESENT == 1U)
-#define DCACHE_BYTE_ALIGNEMNT       (__SCB_DCACHE_LINE_SIZE)
+#ifndef CY_INTERNAL_FLASH_ERASE_VALUE
+/* This is the value of internal flash bytes after an erase */
+#define CY_INTERNAL_FLASH_ERASE_VALUE       (0x00u)
+#endif
+
+/* PSoC 6 internal flash erase granularities: 8-row subsector and 256 KB sector */
+#ifndef CY_OTA_PSOC6_FLASH_SUBSECTOR_SIZE
+#define CY_OTA_PSOC6_FLASH_SUBSECTOR_SIZE   (8u * CY_FLASH_SIZEOF_ROW)
+#endif
+#ifndef CY_OTA_PSOC6_FLASH_SECTOR_SIZE
+#define CY_OTA_PSOC6_FLASH_SECTOR_SIZE      (0x40000u)
+#endif
+
+/* Non-blocking (start/check) internal flash operations, PSoC 6 and XMC7000 */
+#if defined (CY_OTA_FLASH_NON_BLOCKING) && !defined (CY_FLASH_RWW_DRV_SUPPORT_DISABLED) && \
+    !( defined (CYW20829B0LKML) || defined (CYW20829B1010) || \
+       defined (CYW89829B01MKSBG) || defined (CYW89829B1232) )
+#define CY_OTA_INTERNAL_FLASH_ASYNC
+#endif
+
+/*
+ * External flash program sessions (cy_ota_mem_session_begin()) share XIP-off windows between
+ * program operations. Only needed when XIP is turned off for every access.
+ */
+#if (defined (CY_IP_MXSMIF) && !defined (XMC7100) && !defined (XMC7200)) && \
+    defined (CY_XIP_SMIF_MODE_CHANGE) && !defined (ENABLE_ON_THE_FLY_ENCRYPTION)
+#define CY_OTA_SMIF_SESSION
+#endif
+
+/* Row buffers handed to the flash driver are aligned to the D-cache line (__SCB_DCACHE_LINE_SIZE on CM7) */
+#define CY_OTA_FLASH_ROW_BUFFER_ALIGNMENT   (32u)
+
+/* Status of Cy_Flash_IsOperationComplete() while the operation is still running */
+#define CY_OTA_FLASH_DRV_IS_BUSY(status)    (((status) == CY_FLASH_DRV_OPCODE_BUSY) || ((status) == CY_FLASH_DRV_PROGRESS_NO_ERROR))
+
+#if defined (XMC7100) || defined (XMC7200)
+/* XMC7000 code flash erase sector size */
+#define CY_OTA_XMC_FLASH_SECTOR_SIZE                (0x8000U)
+
+/*
+ * Longest time interrupts may stay masked by an internal flash erase step, 0 means no limit.
+ * When a sector erase takes longer than that, the erase is started with interrupts masked and
+ * then polled with interrupts enabled. Interrupt handlers must not execute from the flash
+ * bank being erased in that case.
+ */
+#ifndef CY_OTA_XMC_FLASH_ERASE_MAX_MASKED_US
+#define CY_OTA_XMC_FLASH_ERASE_MAX_MASKED_US        (0u)
+#endif
+
+/* Upper bound of one sector erase, override with the value from the device datasheet */
+#ifndef CY_OTA_XMC_FLASH_SECTOR_ERASE_TIME_US
+#define CY_OTA_XMC_FLASH_SECTOR_ERASE_TIME_US       (100000u)
 #endif
+#endif /* XMC7100/XMC7200 */
 
 #if (defined (CY_IP_MXSMIF) && !defined (XMC7100) && !defined (XMC7200))
 /* UN-comment to test the write functionality */
@@ -128,7 +184,153 @@
 #define POST_SMIF_ACCESS_TURN_ON_XIP
 #endif
 
-#define CY_BOOT_TRAILER_MAX_UPDATE_SIZE             (16)
+/*
+ * Longest time XIP may stay off (with interrupts masked) for one external flash program or
+ * erase step, 0 means one program page or one erase sector per step. Longer operations are
+ * split into steps with XIP restored in between. Used with CY_XIP_SMIF_MODE_CHANGE only.
+ */
+#ifndef CY_OTA_SMIF_XIP_OFF_MAX_US
+#define CY_OTA_SMIF_XIP_OFF_MAX_US                  (0u)
+#endif
+
+/*
+ * Bytes programmed per XIP-off window when CY_OTA_SMIF_XIP_OFF_MAX_US is 0. The default takes one
+ * OTA chunk, also when the chunk does not start on a program page boundary.
+ */
+#ifndef CY_OTA_SMIF_XIP_OFF_PROGRAM_SIZE
+#define CY_OTA_SMIF_XIP_OFF_PROGRAM_SIZE            (4096u)
+#endif
+
+/*
+ * Program operations smaller than the free space of the session buffer are copied and queued
+ * until the session ends, up to CY_OTA_SMIF_SESSION_MAX_RUNS of them.
+ */
+#ifndef CY_OTA_SMIF_SESSION_BUFFER_SIZE
+#define CY_OTA_SMIF_SESSION_BUFFER_SIZE             (512u)
+#endif
+#define CY_OTA_SMIF_SESSION_MAX_RUNS                (8u)
+
+/*
+ * Hybrid sector regions of the external flash are flattened into an address sorted table at
+ * cy_ota_mem_init(). Memories with more regions fall back to Cy_SMIF_MemLocateHybridRegion().
+ */
+#ifndef CY_OTA_SMIF_HYBRID_REGIONS_MAX
+#define CY_OTA_SMIF_HYBRID_REGIONS_MAX              (8u)
+#endif
+
+#ifdef ENABLE_ON_THE_FLY_ENCRYPTION
+/*
+ * On-the-fly encryption: data is encrypted for its flash address in a statically reserved
+ * buffer, one Cy_SMIF_Encrypt() call per buffer-full. Must be a multiple of the AES block size.
+ */
+#ifndef CY_OTA_SMIF_ENCRYPT_BUFFER_SIZE
+#define CY_OTA_SMIF_ENCRYPT_BUFFER_SIZE             (2048u)
+#endif
+#define CY_OTA_SMIF_ENCRYPT_BLOCK_SIZE              (16u)   /* AES-128 block */
+#endif
+
+/*
+ * Adaptive status polling: the first poll comes at 3/4 of the learned completion time of the
+ * operation type, then every 1/16 of it. RTOS builds sleep instead of spinning for waits of
+ * at least CY_OTA_SMIF_POLL_SLEEP_MIN_US when XIP stays on.
+ */
+#define CY_OTA_SMIF_POLL_FIRST_NUM                  (3u)
+#define CY_OTA_SMIF_POLL_FIRST_DEN                  (4u)
+#define CY_OTA_SMIF_POLL_STEP_DIV                   (16u)
+#define CY_OTA_SMIF_POLL_MIN_STEP_US                (20u)
+#define CY_OTA_SMIF_POLL_MAX_STEP_US                (20000u)
+#define CY_OTA_SMIF_POLL_SLEEP_MIN_US               (1000u)
+/* Weight of a new sample in the learned completion time, 1/4 */
+#define CY_OTA_SMIF_POLL_LEARN_SHIFT                (2u)
+/* Longest status or configuration register write, MEMORY_BUSY_CHECK_RETRIES polls 5 ms apart */
+#define CY_OTA_SMIF_REGISTER_TIMEOUT_US             (MEMORY_BUSY_CHECK_RETRIES * 5000u)
+
+#if defined (CY_OTA_SMIF_ERASE_SUSPEND) || defined (CY_OTA_SMIF_FAST_CMDS) || defined (CY_OTA_SMIF_ERASE_PLANNER)
+#define CY_OTA_SMIF_SFDP
+/* SFDP (JESD216) header and parameter headers */
+#define CY_OTA_SFDP_READ_CMD                        (0x5AU)
+#define CY_OTA_SFDP_ADDR_LEN                        (3U)
+#define CY_OTA_SFDP_DUMMY_CYCLES                    (8U)
+#define CY_OTA_SFDP_SIGNATURE                       (0x50444653UL)  /* "SFDP" */
+#define CY_OTA_SFDP_HEADER_SIZE                     (8U)
+#define CY_OTA_SFDP_NPH_OFFSET                      (6U)            /* Number of parameter headers - 1 */
+#define CY_OTA_SFDP_PARAM_HEADER_SIZE               (8U)
+#define CY_OTA_SFDP_PARAM_ID_LSB_OFFSET             (0U)
+#define CY_OTA_SFDP_PARAM_LEN_OFFSET                (3U)
+#define CY_OTA_SFDP_PARAM_PTR_OFFSET                (4U)
+#define CY_OTA_SFDP_PARAM_ID_MSB_OFFSET             (7U)
+#define CY_OTA_SFDP_BFPT_ID                         (0xFF00U)       /* Basic Flash Parameter Table */
+#define CY_OTA_SFDP_4BAIT_ID                        (0xFF84U)       /* 4-byte Address Instruction Table */
+#endif
+
+#ifdef CY_OTA_SMIF_ERASE_SUSPEND
+/* BFPT fields of erase suspend/resume */
+#define CY_OTA_SFDP_BFPT_DWORD12_OFFSET             (44U)
+#define CY_OTA_SFDP_BFPT_SUSPEND_DWORDS             (13U)
+#define CY_OTA_SFDP_SUSPEND_NOT_SUPPORTED           (1UL << 31U)
+
+/* Polling step while waiting for the memory to enter erase suspend */
+#define CY_OTA_SMIF_SUSPEND_POLL_US                 (8U)
+
+/* Bytes read per erase suspend, bounds the time interrupts are masked for a read */
+#ifndef CY_OTA_SMIF_SUSPENDED_READ_MAX
+#define CY_OTA_SMIF_SUSPENDED_READ_MAX              (256U)
+#endif
+
+/* Polling step of a read waiting for the erase of the sector it reads */
+#define CY_OTA_SMIF_ERASE_WAIT_US                   (1000U)
+#endif /* CY_OTA_SMIF_ERASE_SUSPEND */
+
+#ifdef CY_OTA_SMIF_ERASE_PLANNER
+/* BFPT erase types (DWORD8-9, size exponent and instruction per type) and erase times (DWORD10) */
+#define CY_OTA_SFDP_BFPT_DWORD8_OFFSET              (28U)
+#define CY_OTA_SFDP_BFPT_ERASE_TYPES_DWORDS         (9U)
+#define CY_OTA_SFDP_BFPT_ERASE_TIMES_DWORDS         (10U)
+#define CY_OTA_SFDP_ERASE_TYPES                     (4U)
+/* 4BAIT DWORD1 bit of erase type 1 with 4 byte address, DWORD2 lists the instructions */
+#define CY_OTA_SFDP_4BAIT_ERASE_TYPE1_BIT           (9U)
+#define CY_OTA_SFDP_4BAIT_DWORD2_OFFSET             (4U)
+#endif /* CY_OTA_SMIF_ERASE_PLANNER */
+
+#ifdef CY_OTA_SMIF_FAST_CMDS
+/* BFPT fields of the fast read commands */
+#define CY_OTA_SFDP_BFPT_DWORD1_OFFSET              (0U)
+#define CY_OTA_SFDP_BFPT_DWORD3_OFFSET              (8U)
+#define CY_OTA_SFDP_BFPT_DWORD17_OFFSET             (64U)
+#define CY_OTA_SFDP_BFPT_OCTAL_DWORDS               (17U)
+#define CY_OTA_SFDP_READ_1_4_4                      (1UL << 21U)    /* DWORD1 */
+#define CY_OTA_SFDP_READ_1_1_4                      (1UL << 22U)    /* DWORD1 */
+
+/* 4-byte Address Instruction Table DWORD1 support bits and the 4-byte address instructions */
+#define CY_OTA_SFDP_4BAIT_READ_1_1_4                (1UL << 4U)
+#define CY_OTA_SFDP_4BAIT_READ_1_4_4                (1UL << 5U)
+#define CY_OTA_SFDP_4BAIT_PP_1_1_4                  (1UL << 7U)
+#define CY_OTA_SFDP_4BAIT_PP_1_4_4                  (1UL << 8U)
+#define CY_OTA_SFDP_4BAIT_READ_1_1_8                (1UL << 20U)
+#define CY_OTA_SFDP_4BAIT_READ_1_8_8                (1UL << 21U)
+#define CY_OTA_SFDP_4BAIT_PP_1_1_8                  (1UL << 23U)
+#define CY_OTA_SFDP_4BAIT_PP_1_8_8                  (1UL << 24U)
+#define CY_OTA_SMIF_4B_READ_1_1_4_CMD               (0x6CU)
+#define CY_OTA_SMIF_4B_READ_1_4_4_CMD               (0xECU)
+#define CY_OTA_SMIF_4B_READ_1_1_8_CMD               (0x7CU)
+#define CY_OTA_SMIF_4B_READ_1_8_8_CMD               (0xCCU)
+#define CY_OTA_SMIF_4B_PP_1_1_4_CMD                 (0x34U)
+#define CY_OTA_SMIF_4B_PP_1_4_4_CMD                 (0x3EU)
+#define CY_OTA_SMIF_4B_PP_1_1_8_CMD                 (0x84U)
+#define CY_OTA_SMIF_4B_PP_1_8_8_CMD                 (0x8EU)
+
+/* Octal commands are only chosen when all eight data lines are connected */
+#ifdef CY_OTA_SMIF_OCTAL
+#define CY_OTA_SMIF_FAST_CMDS_MAX_LINES             (8U)
+#else
+#define CY_OTA_SMIF_FAST_CMDS_MAX_LINES             (4U)
+#endif
+#endif /* CY_OTA_SMIF_FAST_CMDS */
+
+#define CY_OTA_SMIF_MAX_ADDR_LEN                    (4U)
+
+/* Largest image trailer update, the end of the trailer written by cy_flash_area_boot_set_pending() */
+#define CY_BOOT_TRAILER_MAX_UPDATE_SIZE             (40)
 
 #define CY_SS0_SMIF_ID         (1U) /* Assume SlaveSelect_0 is used for External Memory */
 
@@ -167,50 +369,253 @@ static uint8_t read_back_test[1024];
 
 #ifdef ENABLE_ON_THE_FLY_ENCRYPTION
 /**
- * @brief Local buffer for data flash write
+ * @brief Local buffer for data flash write, encrypted in place before it is programmed
  */
-uint8_t *write_buffer = NULL;
+CY_ALIGN(CY_OTA_FLASH_ROW_BUFFER_ALIGNMENT) static uint8_t ota_smif_encrypt_buffer[CY_OTA_SMIF_ENCRYPT_BUFFER_SIZE];
+#endif
+
+#if defined (XMC7100) || defined (XMC7200)
+/* Row buffer of xmc_internal_flash_write(), statically reserved so the write path does not touch the heap */
+CY_ALIGN(CY_OTA_FLASH_ROW_BUFFER_ALIGNMENT) static uint8_t xmc_row_buffer[CY_FLASH_SIZEOF_ROW];
 #endif
 
+#ifdef CY_OTA_INTERNAL_FLASH_ASYNC
+typedef enum
+{
+    OTA_FLASH_ASYNC_IDLE = 0,
+    OTA_FLASH_ASYNC_WRITE,
+    OTA_FLASH_ASYNC_ERASE
+} ota_flash_async_op_t;
+
+typedef struct
+{
+    ota_flash_async_op_t        op;         /* Operation in progress                        */
+    uint32_t                    addr;       /* Absolute address of the next byte to handle  */
+    const uint8_t               *src;       /* Next source byte (write only)                */
+    size_t                      remaining;  /* Bytes left to handle                         */
+    cy_ota_mem_complete_cb_t    cb;
+    void                        *cb_arg;
+} ota_flash_async_t;
+
+static ota_flash_async_t ota_flash_async;
+
+/* Row handed to the flash driver, must stay untouched until the row operation completes */
+CY_ALIGN(CY_OTA_FLASH_ROW_BUFFER_ALIGNMENT) static uint32_t ota_flash_async_row[CY_FLASH_SIZEOF_ROW / sizeof(uint32_t)];
+#endif /* CY_OTA_INTERNAL_FLASH_ASYNC */
+
 /**********************************************************************************************************************************
  * Internal Functions
  **********************************************************************************************************************************/
 #ifdef ENABLE_ON_THE_FLY_ENCRYPTION
-static bool ota_allocate_write_buffer(uint64_t size)
+static uint32_t cy_flash_addr_to_cbus_addr(uint32_t secondary_addr)
+{
+    uint32_t cbus_addr = 0;
+    cbus_addr = CY_XIP_CBUS_BASE + secondary_addr;
+    return cbus_addr;
+}
+#endif
+
+#if (defined (CY_IP_MXSMIF) && !defined (XMC7100) && !defined (XMC7200))
+typedef enum
+{
+    OTA_SMIF_OP_PROGRAM = 0,
+    OTA_SMIF_OP_ERASE,
+    OTA_SMIF_OP_REGISTER,
+#ifdef CY_OTA_SMIF_ERASE_PLANNER
+    OTA_SMIF_OP_ERASE_TYPE,     /* SFDP erase type 1, followed by the other types */
+    OTA_SMIF_OP_COUNT = OTA_SMIF_OP_ERASE_TYPE + CY_OTA_SFDP_ERASE_TYPES
+#else
+    OTA_SMIF_OP_COUNT
+#endif
+} ota_smif_op_t;
+
+/* Status polling of one operation */
+typedef struct
+{
+    ota_smif_op_t   op;
+    uint32_t        elapsed_us;     /* Sum of the delays between polls */
+    uint32_t        next_delay_us;
+} ota_smif_poll_t;
+
+/* Learned completion time per operation type, seeded from the memory configuration */
+static uint32_t ota_smif_poll_estimate_us[OTA_SMIF_OP_COUNT];
+
+#ifdef CY_OTA_SMIF_ERASE_PLANNER
+/* Erase type of the memory from SFDP */
+typedef struct
 {
-    if(write_buffer != NULL)
+    uint32_t                size;
+    uint32_t                typical_us;
+    uint32_t                max_us;
+    uint32_t                best_us;        /* Fastest erase of size bytes with this or smaller types */
+    bool                    device_cmd;     /* Erased with the erase command of the memory configuration */
+    cy_stc_smif_mem_cmd_t   cmd;
+} ota_smif_erase_type_t;
+
+/* Sorted by ascending size */
+static ota_smif_erase_type_t    ota_smif_erase_types[CY_OTA_SFDP_ERASE_TYPES];
+static uint32_t                 ota_smif_erase_type_count;
+static cy_ota_mem_erase_stats_t ota_smif_erase_stats;
+#endif /* CY_OTA_SMIF_ERASE_PLANNER */
+
+/* Erase geometry of one hybrid sector region, [start, end) */
+typedef struct
+{
+    uint32_t    start;
+    uint32_t    end;
+    uint32_t    erase_size;
+    uint32_t    erase_time_ms;
+    uint32_t    erase_cmd;
+} ota_smif_erase_region_t;
+
+/* Sorted by address, count 0 for a uniform memory. Not used until ota_smif_erase_regions_valid is set */
+static ota_smif_erase_region_t  ota_smif_erase_regions[CY_OTA_SMIF_HYBRID_REGIONS_MAX];
+static uint32_t                 ota_smif_erase_region_count;
+static bool                     ota_smif_erase_regions_valid;
+
+static void ota_smif_poll_init(void)
+{
+    cy_stc_smif_mem_device_cfg_t const *device_cfg = smifBlockConfig.memConfig[MEM_SLOT]->deviceCfg;
+
+    /* Typical times are well below the maximum times in the configuration */
+    ota_smif_poll_estimate_us[OTA_SMIF_OP_PROGRAM]  = device_cfg->programTime / 4u;
+    ota_smif_poll_estimate_us[OTA_SMIF_OP_ERASE]    = (device_cfg->eraseTime * 1000u) / 4u;
+    ota_smif_poll_estimate_us[OTA_SMIF_OP_REGISTER] = CY_OTA_SMIF_REGISTER_TIMEOUT_US / 4u;
+}
+
+/* Longest time to wait for an operation, the maximum time from the memory configuration */
+static uint32_t ota_smif_poll_timeout_us(ota_smif_op_t op)
+{
+    cy_stc_smif_mem_device_cfg_t const *device_cfg = smifBlockConfig.memConfig[MEM_SLOT]->deviceCfg;
+    uint32_t timeout_us = 0u;
+
+    if (op == OTA_SMIF_OP_PROGRAM)
+    {
+        timeout_us = device_cfg->programTime;
+    }
+    else if (op == OTA_SMIF_OP_ERASE)
+    {
+        timeout_us = device_cfg->eraseTime * 1000u;
+    }
+    else if (op == OTA_SMIF_OP_REGISTER)
+    {
+        timeout_us = CY_OTA_SMIF_REGISTER_TIMEOUT_US;
+    }
+#ifdef CY_OTA_SMIF_ERASE_PLANNER
+    else if (op >= OTA_SMIF_OP_ERASE_TYPE)
     {
-        free(write_buffer);
-        write_buffer = NULL;
+        timeout_us = ota_smif_erase_types[op - OTA_SMIF_OP_ERASE_TYPE].max_us;
     }
+#endif
 
-    write_buffer = (uint8_t *)malloc(size);
-    if(write_buffer == NULL)
+    if (timeout_us == 0u)
     {
-        return false;
+        timeout_us = MEMORY_BUSY_CHECK_RETRIES * 5000u;
     }
-    else
+    return timeout_us;
+}
+
+static uint32_t ota_smif_poll_step_us(ota_smif_op_t op)
+{
+    uint32_t step_us = ota_smif_poll_estimate_us[op] / CY_OTA_SMIF_POLL_STEP_DIV;
+
+    if (step_us < CY_OTA_SMIF_POLL_MIN_STEP_US)
     {
-        return true;
+        step_us = CY_OTA_SMIF_POLL_MIN_STEP_US;
+    }
+    else if (step_us > CY_OTA_SMIF_POLL_MAX_STEP_US)
+    {
+        step_us = CY_OTA_SMIF_POLL_MAX_STEP_US;
     }
+    return step_us;
 }
 
-static void ota_free_write_buffer(void)
+static void ota_smif_poll_start(ota_smif_poll_t *poll, ota_smif_op_t op)
 {
-    if(write_buffer != NULL)
+    poll->op            = op;
+    poll->elapsed_us    = 0u;
+    poll->next_delay_us = (ota_smif_poll_estimate_us[op] / CY_OTA_SMIF_POLL_FIRST_DEN) * CY_OTA_SMIF_POLL_FIRST_NUM;
+    if (poll->next_delay_us < ota_smif_poll_step_us(op))
     {
-        free(write_buffer);
-        write_buffer = NULL;
+        poll->next_delay_us = ota_smif_poll_step_us(op);
     }
 }
 
-static uint32_t cy_flash_addr_to_cbus_addr(uint32_t secondary_addr)
+/* Delay before the next poll, counted as elapsed */
+static uint32_t ota_smif_poll_next_delay(ota_smif_poll_t *poll)
 {
-    uint32_t cbus_addr = 0;
-    cbus_addr = CY_XIP_CBUS_BASE + secondary_addr;
-    return cbus_addr;
+    uint32_t delay_us = poll->next_delay_us;
+
+    poll->elapsed_us   += delay_us;
+    poll->next_delay_us = ota_smif_poll_step_us(poll->op);
+    return delay_us;
+}
+
+/* The operation completed, learn its completion time */
+static void ota_smif_poll_done(ota_smif_poll_t const *poll)
+{
+    uint32_t estimate_us = ota_smif_poll_estimate_us[poll->op];
+
+    estimate_us -= estimate_us >> CY_OTA_SMIF_POLL_LEARN_SHIFT;
+    estimate_us += poll->elapsed_us >> CY_OTA_SMIF_POLL_LEARN_SHIFT;
+    ota_smif_poll_estimate_us[poll->op] = estimate_us;
+
+#ifdef CY_OTA_SMIF_ERASE_PLANNER
+    if ((poll->op == OTA_SMIF_OP_ERASE) || (poll->op >= OTA_SMIF_OP_ERASE_TYPE))
+    {
+        ota_smif_erase_stats.actual_us += poll->elapsed_us;
+    }
+#endif
 }
+
+/* Delay, sleeping when allowed, running on an RTOS and the delay is long enough */
+static void ota_smif_delay_us(uint32_t delay_us, bool may_sleep)
+{
+#if defined (CY_RTOS_AWARE)
+    if (may_sleep && (delay_us >= CY_OTA_SMIF_POLL_SLEEP_MIN_US))
+    {
+        /* Rounded up, never wake before the delay has passed */
+        (void)cy_rtos_delay_milliseconds((delay_us + 999u) / 1000u);
+        return;
+    }
+#else
+    (void)may_sleep;
 #endif
+    while (delay_us > UINT16_MAX)
+    {
+        Cy_SysLib_DelayUs(UINT16_MAX);
+        delay_us -= UINT16_MAX;
+    }
+    Cy_SysLib_DelayUs((uint16_t)delay_us);
+}
+
+/*
+ * Wait until the memory finishes an operation of type op. Sleeping between polls is only
+ * allowed with XIP on and outside critical sections.
+ */
+static cy_en_smif_status_t ota_smif_wait_ready(cy_stc_smif_mem_config_t const *mem_cfg, ota_smif_op_t op, bool may_sleep)
+{
+    ota_smif_poll_t poll;
+    uint32_t timeout_us = ota_smif_poll_timeout_us(op);
+    bool busy;
+
+    ota_smif_poll_start(&poll, op);
+
+    busy = Cy_SMIF_MemIsBusy(SMIF0, (cy_stc_smif_mem_config_t *)mem_cfg, &ota_QSPI_context);
+    while (busy && (poll.elapsed_us < timeout_us))
+    {
+        ota_smif_delay_us(ota_smif_poll_next_delay(&poll), may_sleep);
+        busy = Cy_SMIF_MemIsBusy(SMIF0, (cy_stc_smif_mem_config_t *)mem_cfg, &ota_QSPI_context);
+    }
+
+    if (busy)
+    {
+        return CY_SMIF_EXCEED_TIMEOUT;
+    }
+    ota_smif_poll_done(&poll);
+    return CY_SMIF_SUCCESS;
+}
+#endif /* CY_IP_MXSMIF & !XMC7100 & !XMC7200 */
 
 #if defined(CY_IP_MXSMIF) && !defined(PSOC_062_1M) && !defined(XMC7100) && !defined(XMC7200)
 #if defined(OTA_USE_EXTERNAL_FLASH)
@@ -231,17 +636,8 @@ static uint32_t cy_flash_addr_to_cbus_addr(uint32_t secondary_addr)
 *******************************************************************************/
 static cy_en_smif_status_t IsMemoryReady(cy_stc_smif_mem_config_t const *memConfig)
 {
-    uint32_t retries = 0;
-    bool isBusy;
-
-    do
-    {
-        isBusy = Cy_SMIF_Memslot_IsBusy(SMIF0, (cy_stc_smif_mem_config_t* )memConfig, &ota_QSPI_context);
-        Cy_SysLib_Delay(5);
-        retries++;
-    }while(isBusy && (retries < MEMORY_BUSY_CHECK_RETRIES));
-
-    return (isBusy ? CY_SMIF_EXCEED_TIMEOUT : CY_SMIF_SUCCESS);
+    /* Called with XIP off, do not sleep */
+    return ota_smif_wait_ready(memConfig, OTA_SMIF_OP_REGISTER, false);
 }
 
 /*******************************************************************************
@@ -331,7 +727,9 @@ static int psoc6_internal_flash_write(uint8_t data[], uint32_t address, size_t l
     uint32_t srcIndex = 0u;
     uint32_t eeOffset;
     uint32_t byteOffset;
+    uint32_t chunkSize;
     uint32_t rowsNotEqual;
+    bool rowErased;
     uint8_t *writeBufferPointer;
 
     eeOffset = (uint32_t)address;
@@ -350,31 +748,38 @@ static int psoc6_internal_flash_write(uint8_t data[], uint32_t address, size_t l
 
         while((srcIndex < len) && (rc == CY_FLASH_DRV_SUCCESS))
         {
-            rowsNotEqual = 0u;
-            /* Copy data to the write buffer either from the source buffer or from the flash */
-            for(dstIndex = 0u; dstIndex < CY_FLASH_SIZEOF_ROW; dstIndex++)
+            /* Offset in the row and number of bytes taken from the source buffer */
+            dstIndex = (eeOffset + srcIndex) - byteOffset;
+            chunkSize = CY_FLASH_SIZEOF_ROW - dstIndex;
+            if(chunkSize > (len - srcIndex))
+            {
+                chunkSize = len - srcIndex;
+            }
+
+            /* Start from the current row contents, then merge in the source buffer */
+            (void)memcpy(writeBufferPointer, (const void *)(CY_FLASH_BASE + byteOffset), CY_FLASH_SIZEOF_ROW);
+
+            /* A blank row (e.g. after cy_ota_storage_open() erased the slot) only needs to be programmed */
+            rowErased = cy_ota_buffer_is_filled(writeBufferPointer, CY_INTERNAL_FLASH_ERASE_VALUE, CY_FLASH_SIZEOF_ROW);
+
+            /* Detect that row programming is required */
+            rowsNotEqual = cy_ota_buffer_differs(&writeBufferPointer[dstIndex], &data[srcIndex], chunkSize) ? 1u : 0u;
+            (void)memcpy(&writeBufferPointer[dstIndex], &data[srcIndex], chunkSize);
+            srcIndex += chunkSize;
+            byteOffset += CY_FLASH_SIZEOF_ROW;
+
+            if(rowsNotEqual != 0u)
             {
-                if((byteOffset >= eeOffset) && (srcIndex < len))
+                if(rowErased)
                 {
-                    writeBufferPointer[dstIndex] = data[srcIndex];
-                    /* Detect that row programming is required */
-                    if((rowsNotEqual == 0u) && ( (CY_GET_REG8(CY_FLASH_BASE + byteOffset) != data[srcIndex]) ) )
-                    {
-                        rowsNotEqual = 1u;
-                    }
-                    srcIndex++;
+                    /* Program flash row, no erase required */
+                    rc = Cy_Flash_ProgramRow((rowId * CY_FLASH_SIZEOF_ROW) + CY_FLASH_BASE, writeBuffer);
                 }
                 else
                 {
-                    writeBufferPointer[dstIndex] = CY_GET_REG8(CY_FLASH_BASE + byteOffset);
+                    /* Write flash row (erase + program) */
+                    rc = Cy_Flash_WriteRow((rowId * CY_FLASH_SIZEOF_ROW) + CY_FLASH_BASE, writeBuffer);
                 }
-                byteOffset++;
-            }
-
-            if(rowsNotEqual != 0u)
-            {
-                /* Write flash row */
-                rc = Cy_Flash_WriteRow((rowId * CY_FLASH_SIZEOF_ROW) + CY_FLASH_BASE, writeBuffer);
             }
 
             /* Go to the next row */
@@ -405,14 +810,58 @@ static int psoc6_internal_flash_write(uint8_t data[], uint32_t address, size_t l
     return(retCode);
 }
 
+/*
+ * Size of the largest erase operation (sector, subsector or row) that starts at the
+ * row aligned address and does not go past the row aligned end address.
+ */
+static uint32_t psoc6_internal_flash_erase_step(uint32_t address, uint32_t addrEnd)
+{
+    uint32_t offset = address - CY_FLASH_BASE;
+
+    if(((offset % CY_OTA_PSOC6_FLASH_SECTOR_SIZE) == 0u) && ((addrEnd - address) >= CY_OTA_PSOC6_FLASH_SECTOR_SIZE))
+    {
+        return CY_OTA_PSOC6_FLASH_SECTOR_SIZE;
+    }
+    if(((offset % CY_OTA_PSOC6_FLASH_SUBSECTOR_SIZE) == 0u) && ((addrEnd - address) >= CY_OTA_PSOC6_FLASH_SUBSECTOR_SIZE))
+    {
+        return CY_OTA_PSOC6_FLASH_SUBSECTOR_SIZE;
+    }
+    return CY_FLASH_SIZEOF_ROW;
+}
+
+/*
+ * Erase [from, to) inside a single row and keep the rest of the row.
+ * The row is rewritten with one Cy_Flash_WriteRow() call (erase + program).
+ */
+static cy_en_flashdrv_status_t psoc6_internal_flash_erase_edge(uint32_t rowAddr, uint32_t from, uint32_t to)
+{
+    uint32_t rowBuffer[CY_FLASH_SIZEOF_ROW / sizeof(uint32_t)];
+    uint8_t *rowPointer = (uint8_t *)rowBuffer;
+
+    (void)memcpy(rowPointer, (const void *)rowAddr, CY_FLASH_SIZEOF_ROW);
+
+    /* Nothing to do if the range is already erased */
+    if(cy_ota_buffer_is_filled(&rowPointer[from - rowAddr], CY_INTERNAL_FLASH_ERASE_VALUE, to - from))
+    {
+        return CY_FLASH_DRV_SUCCESS;
+    }
+
+    (void)memset(&rowPointer[from - rowAddr], CY_INTERNAL_FLASH_ERASE_VALUE, to - from);
+
+    if(cy_ota_buffer_is_filled(rowPointer, CY_INTERNAL_FLASH_ERASE_VALUE, CY_FLASH_SIZEOF_ROW))
+    {
+        return Cy_Flash_EraseRow(rowAddr);
+    }
+    return Cy_Flash_WriteRow(rowAddr, rowBuffer);
+}
+
 static int psoc6_internal_flash_erase(uint32_t addr, size_t size)
 {
-    int rc = 0;
+    cy_en_flashdrv_status_t rc = CY_FLASH_DRV_SUCCESS;
 
     uint32_t addrStart, addrEnd, address;
-    uint32_t remStart, remEnd;
-    uint32_t rowIdxStart, rowIdxEnd, rowNum;
-    uint8_t  buff[CY_FLASH_SIZEOF_ROW];
+    uint32_t rowStart, rowEnd;
+    uint32_t eraseSize;
 
     /* flash_area_write() uses offsets, we need absolute address here */
     addr += CY_FLASH_BASE;
@@ -420,79 +869,99 @@ static int psoc6_internal_flash_erase(uint32_t addr, size_t size)
     addrStart = addr;
     addrEnd   = addrStart + size;
 
-    /* find if area bounds are aligned to rows */
-    remStart = addrStart%CY_FLASH_SIZEOF_ROW;
-    remEnd   = addrEnd%CY_FLASH_SIZEOF_ROW;
-
-    /* find which row numbers are affected for full Erase */
-    rowIdxStart = addrStart/CY_FLASH_SIZEOF_ROW;
-    rowIdxEnd   = addrEnd/CY_FLASH_SIZEOF_ROW;
-
-    if(remStart != 0)
-    {/* first row is fragmented, move to next */
-        rowIdxStart++;
+    if(size == 0u)
+    {
+        return 0;
     }
 
-    /* total number of rows for full erase */
-    rowNum = rowIdxEnd - rowIdxStart;
-    address = rowIdxStart*CY_FLASH_SIZEOF_ROW;
+    /* Row aligned span which can be erased without preserving data */
+    rowStart = ((addrStart + CY_FLASH_SIZEOF_ROW - 1u) / CY_FLASH_SIZEOF_ROW) * CY_FLASH_SIZEOF_ROW;
+    rowEnd   = (addrEnd / CY_FLASH_SIZEOF_ROW) * CY_FLASH_SIZEOF_ROW;
 
-    while(rowNum>0)
+    if(rowStart > rowEnd)
     {
-        rc = Cy_Flash_EraseRow(address);
-        assert(rc == 0);
-        address += CY_FLASH_SIZEOF_ROW;
-        rowNum--;
+        /* Start and end of the erase area are inside the same row */
+        rc = psoc6_internal_flash_erase_edge(rowEnd, addrStart, addrEnd);
+        return (rc == CY_FLASH_DRV_SUCCESS) ? 0 : 1;
     }
 
     /* if Start of erase area is unaligned */
-    if(remStart != 0)
+    if(addrStart != rowStart)
     {
-        /* first row is fragmented, shift left by one*/
-        rowIdxStart--;
-
-        /* find start address of fragmented row */
-        address = rowIdxStart*CY_FLASH_SIZEOF_ROW;
-
-        /* store fragmented row contents first */
-        memcpy((void *)buff, (const void*)address, remStart);
-
-        /* erase fragmented row */
-        rc = Cy_Flash_EraseRow(address);
-        assert(rc == 0);
+        rc = psoc6_internal_flash_erase_edge(rowStart - CY_FLASH_SIZEOF_ROW, addrStart, rowStart);
+    }
 
-        /* write stored back */
-        rc = psoc6_internal_flash_write(buff, address, remStart);
-        assert(rc == 0);
+    /* Use the largest erase operation that fits for the aligned span */
+    address = rowStart;
+    while((address < rowEnd) && (rc == CY_FLASH_DRV_SUCCESS))
+    {
+        eraseSize = psoc6_internal_flash_erase_step(address, rowEnd);
+        if(eraseSize == CY_OTA_PSOC6_FLASH_SECTOR_SIZE)
+        {
+            rc = Cy_Flash_EraseSector(address);
+        }
+        else if(eraseSize == CY_OTA_PSOC6_FLASH_SUBSECTOR_SIZE)
+        {
+            rc = Cy_Flash_EraseSubsector(address);
+        }
+        else
+        {
+            rc = Cy_Flash_EraseRow(address);
+        }
+        address += eraseSize;
     }
+
     /* if End of erase area is unaligned */
-    if(remEnd != 0)
+    if((addrEnd != rowEnd) && (rc == CY_FLASH_DRV_SUCCESS))
     {
-        /* find start address of fragmented row */
-        address = rowIdxEnd*CY_FLASH_SIZEOF_ROW;
+        rc = psoc6_internal_flash_erase_edge(rowEnd, rowEnd, addrEnd);
+    }
+
+    return (rc == CY_FLASH_DRV_SUCCESS) ? 0 : 1;
+}
+
+#endif
 
-        /* store fragmented row contents first */
-        memcpy((void *)buff, (const void*)addrEnd, CY_FLASH_SIZEOF_ROW-remEnd);
+#if defined (XMC7100) || defined (XMC7200)
+/*
+ * Erase one sector. Interrupts are masked for the sector erase only, or just for
+ * issuing it when a sector erase does not fit in CY_OTA_XMC_FLASH_ERASE_MAX_MASKED_US.
+ */
+CY_SECTION_RAMFUNC_BEGIN
+static cy_en_flashdrv_status_t xmc_internal_flash_erase_sector(uint32_t sector_addr)
+{
+    cy_en_flashdrv_status_t status;
+    uint32_t intr_status;
 
-        /* erase fragmented row */
-        rc = Cy_Flash_EraseRow(address);
-        assert(rc == 0);
+#if (CY_OTA_XMC_FLASH_ERASE_MAX_MASKED_US != 0u) && \
+    (CY_OTA_XMC_FLASH_SECTOR_ERASE_TIME_US > CY_OTA_XMC_FLASH_ERASE_MAX_MASKED_US)
+    intr_status = Cy_SysLib_EnterCriticalSection();
+    status = Cy_Flash_StartEraseSector(sector_addr);
+    Cy_SysLib_ExitCriticalSection(intr_status);
 
-        /* write stored back */
-        rc = psoc6_internal_flash_write(buff, addrEnd, CY_FLASH_SIZEOF_ROW-remEnd);
-        assert(rc == 0);
+    if(status == CY_FLASH_DRV_OPERATION_STARTED)
+    {
+        do
+        {
+            status = Cy_Flash_IsOperationComplete();
+        } while(CY_OTA_FLASH_DRV_IS_BUSY(status));
     }
-    return rc;
-}
+#else
+    intr_status = Cy_SysLib_EnterCriticalSection();
+    status = Cy_Flash_EraseSector(sector_addr);
+    Cy_SysLib_ExitCriticalSection(intr_status);
 #endif
 
-#if defined (XMC7100) || defined (XMC7200)
+    return status;
+}
+CY_SECTION_RAMFUNC_END
+
 CY_SECTION_RAMFUNC_BEGIN
 static int xmc_internal_flash_erase(uint32_t addr, size_t size)
 {
     int rc                   = 0;
     uint32_t row_addr        = 0u;
-    uint32_t erase_sz        = 0x8000U; //32KB
+    uint32_t erase_sz        = CY_OTA_XMC_FLASH_SECTOR_SIZE;
     cy_en_flashdrv_status_t flashEraseStatus;
 
     /* flash_area_write() uses offsets, we need absolute address here */
@@ -512,7 +981,8 @@ static int xmc_internal_flash_erase(uint32_t addr, size_t size)
         row_number--;
         row_addr = row_start_addr + row_number * (uint32_t)erase_sz;
 
-        flashEraseStatus = Cy_Flash_EraseSector((uint32_t) row_addr);
+        /* Interrupts are serviced between the sectors */
+        flashEraseStatus = xmc_internal_flash_erase_sector((uint32_t) row_addr);
         if (flashEraseStatus != CY_FLASH_DRV_SUCCESS)
         {
             rc = 1;
@@ -540,27 +1010,13 @@ static int xmc_internal_flash_write(uint8_t data[], uint32_t address, size_t len
     uint32_t srcIndex = 0u;
     uint32_t eeOffset;
     uint32_t byteOffset;
+    uint32_t chunkSize;
     uint32_t rowsNotEqual;
     uint8_t *writeBufferPointer;
     eeOffset = (uint32_t)address;
     bool cond1;
 
-#if !defined (CY_DISABLE_XMC7000_DATA_CACHE) && defined (__DCACHE_PRESENT) && (__DCACHE_PRESENT == 1U)
-    uint8_t *local_buffer = 0, *aligned_local_buffer = 0;
-    bool iscacheable = false;
-
-    local_buffer = (uint8_t *)malloc((CY_FLASH_SIZEOF_ROW) + (2 * DCACHE_BYTE_ALIGNEMNT));
-    if(NULL == local_buffer)
-    {
-        return -1;
-    }
-    aligned_local_buffer = (uint8_t*)((size_t)local_buffer + ((size_t)32 - ((size_t)local_buffer & 0x1F)));
-    writeBufferPointer = aligned_local_buffer;
-    iscacheable = true;
-#else
-    uint32_t writeBuffer[CY_FLASH_SIZEOF_ROW / sizeof(uint32_t)];
-    writeBufferPointer = (uint8_t*)writeBuffer;
-#endif
+    writeBufferPointer = xmc_row_buffer;
 
     /* Make sure, that varFlash[] points to Flash */
     cond1 = ((eeOffset >= CY_FLASH_BASE) && ((eeOffset + len) <= (CY_FLASH_BASE + CY_FLASH_SIZE)));
@@ -573,27 +1029,23 @@ static int xmc_internal_flash_write(uint8_t data[], uint32_t address, size_t len
 
         while((srcIndex < len) && (rc == CY_FLASH_DRV_SUCCESS))
         {
-            rowsNotEqual = 0u;
-            /* Copy data to the write buffer either from the source buffer or from the flash */
-            for(dstIndex = 0u; dstIndex < CY_FLASH_SIZEOF_ROW; dstIndex++)
+            /* Offset in the row and number of bytes taken from the source buffer */
+            dstIndex = (eeOffset + srcIndex) - byteOffset;
+            chunkSize = CY_FLASH_SIZEOF_ROW - dstIndex;
+            if(chunkSize > (len - srcIndex))
             {
-                if((byteOffset >= eeOffset) && (srcIndex < len))
-                {
-                    writeBufferPointer[dstIndex] = data[srcIndex];
-                    /* Detect that row programming is required */
-                    if((rowsNotEqual == 0u) && ( (CY_GET_REG8(CY_FLASH_BASE + byteOffset) != data[srcIndex]) ) )
-                    {
-                        rowsNotEqual = 1u;
-                    }
-                    srcIndex++;
-                }
-                else
-                {
-                    writeBufferPointer[dstIndex] = CY_GET_REG8(CY_FLASH_BASE + byteOffset);
-                }
-                byteOffset++;
+                chunkSize = len - srcIndex;
             }
 
+            /* Start from the current row contents, then merge in the source buffer */
+            cy_ota_buffer_copy(writeBufferPointer, (const void *)(CY_FLASH_BASE + byteOffset), CY_FLASH_SIZEOF_ROW);
+
+            /* Detect that row programming is required */
+            rowsNotEqual = cy_ota_buffer_differs(&writeBufferPointer[dstIndex], &data[srcIndex], chunkSize) ? 1u : 0u;
+            cy_ota_buffer_copy(&writeBufferPointer[dstIndex], &data[srcIndex], chunkSize);
+            srcIndex += chunkSize;
+            byteOffset += CY_FLASH_SIZEOF_ROW;
+
             if(rowsNotEqual != 0u)
             {
                 int intr_status = 0;
@@ -632,42 +1084,1620 @@ static int xmc_internal_flash_write(uint8_t data[], uint32_t address, size_t len
             break;
     }
 
-#if !defined (CY_DISABLE_XMC7000_DATA_CACHE) && defined (__DCACHE_PRESENT) && (__DCACHE_PRESENT == 1U)
-    if(iscacheable == true)
-    {
-        free(local_buffer);
-    }
-#endif
-
     return(retCode);
 }
 CY_SECTION_RAMFUNC_END
 #endif /* XMC7100/XMC7200 */
 
-#if (defined (CY_IP_MXSMIF) && !defined (XMC7100) && !defined (XMC7200))
-static uint32_t ota_smif_get_memory_size(void)
+#ifdef CY_OTA_INTERNAL_FLASH_ASYNC
+/*
+ * End the operation in progress, leave the critical section entered by the caller
+ * and report the result. The callback runs with interrupts enabled again.
+ */
+static void ota_flash_async_finish(cy_rslt_t result, uint32_t intr_status)
 {
-    uint32_t size = 0;
+    cy_ota_mem_complete_cb_t cb = ota_flash_async.cb;
+    void *cb_arg = ota_flash_async.cb_arg;
 
-    if (SMIF0 != NULL)
+    memset(&ota_flash_async, 0x00, sizeof(ota_flash_async));
+    Cy_SysLib_ExitCriticalSection(intr_status);
+
+    if(cb != NULL)
     {
-        size = smifBlockConfig.memConfig[MEM_SLOT]->deviceCfg->memSize;
+        cb(result, cb_arg);
     }
-
-    return size;
 }
-#endif /* CY_IP_MXSMIF & !XMC7100 & !XMC7200 */
 
-/**********************************************************************************************************************************
- * External Functions
- **********************************************************************************************************************************/
-/**
- * @brief Initializes flash, QSPI flash, or any other external memory type
+/*
+ * Start the next row operation of the non-blocking operation in progress.
+ * Rows which already hold the requested data are skipped.
  *
- * @return  CY_RSLT_SUCCESS on success
- *          CY_RSLT_TYPE_ERROR on failure
+ * On XMC7000 the application must not execute from the flash bank being programmed
+ * while the operation is in progress (dual bank mode).
+ *
+ * Returns CY_FLASH_DRV_OPERATION_STARTED if a row operation was started,
+ * CY_FLASH_DRV_SUCCESS if there is nothing left to do, or the driver error.
  */
-cy_rslt_t cy_ota_mem_init( void )
+static cy_en_flashdrv_status_t ota_flash_async_start_next(void)
+{
+    cy_en_flashdrv_status_t rc = CY_FLASH_DRV_SUCCESS;
+    uint8_t *rowPointer = (uint8_t *)ota_flash_async_row;
+    uint32_t rowAddr;
+    uint32_t rowOffset;
+    uint32_t chunkSize;
+    bool rowsNotEqual;
+#if defined (XMC7100) || defined (XMC7200)
+    uint32_t intr_status;
+#else
+    uint32_t eraseSize;
+    bool rowErased;
+#endif
+
+    while((ota_flash_async.remaining > 0u) && (rc == CY_FLASH_DRV_SUCCESS))
+    {
+#if !(defined (XMC7100) || defined (XMC7200))
+        if(ota_flash_async.op == OTA_FLASH_ASYNC_ERASE)
+        {
+            eraseSize = psoc6_internal_flash_erase_step(ota_flash_async.addr, ota_flash_async.addr + ota_flash_async.remaining);
+            if(eraseSize == CY_OTA_PSOC6_FLASH_SECTOR_SIZE)
+            {
+                rc = Cy_Flash_StartEraseSector(ota_flash_async.addr);
+            }
+            else if(eraseSize == CY_OTA_PSOC6_FLASH_SUBSECTOR_SIZE)
+            {
+                rc = Cy_Flash_StartEraseSubsector(ota_flash_async.addr);
+            }
+            else
+            {
+                rc = Cy_Flash_StartEraseRow(ota_flash_async.addr);
+            }
+            ota_flash_async.addr += eraseSize;
+            ota_flash_async.remaining -= eraseSize;
+        }
+        else
+#endif /* !XMC7100 & !XMC7200 */
+        {
+            rowAddr = (ota_flash_async.addr / CY_FLASH_SIZEOF_ROW) * CY_FLASH_SIZEOF_ROW;
+            rowOffset = ota_flash_async.addr - rowAddr;
+            chunkSize = CY_FLASH_SIZEOF_ROW - rowOffset;
+            if(chunkSize > ota_flash_async.remaining)
+            {
+                chunkSize = ota_flash_async.remaining;
+            }
+
+            (void)memcpy(rowPointer, (const void *)rowAddr, CY_FLASH_SIZEOF_ROW);
+#if !(defined (XMC7100) || defined (XMC7200))
+            rowErased = cy_ota_buffer_is_filled(rowPointer, CY_INTERNAL_FLASH_ERASE_VALUE, CY_FLASH_SIZEOF_ROW);
+#endif
+            rowsNotEqual = cy_ota_buffer_differs(&rowPointer[rowOffset], ota_flash_async.src, chunkSize);
+            (void)memcpy(&rowPointer[rowOffset], ota_flash_async.src, chunkSize);
+
+            ota_flash_async.addr += chunkSize;
+            ota_flash_async.src += chunkSize;
+            ota_flash_async.remaining -= chunkSize;
+
+            if(rowsNotEqual)
+            {
+#if defined (XMC7100) || defined (XMC7200)
+                /* Same as xmc_internal_flash_write(): the slot is erased upfront, program only */
+                intr_status = Cy_SysLib_EnterCriticalSection();
+                rc = Cy_Flash_StartProgram(rowAddr, ota_flash_async_row);
+                Cy_SysLib_ExitCriticalSection(intr_status);
+#else
+                rc = rowErased ? Cy_Flash_StartProgram(rowAddr, ota_flash_async_row) :
+                                 Cy_Flash_StartWrite(rowAddr, ota_flash_async_row);
+#endif
+            }
+        }
+    }
+
+    return rc;
+}
+
+/*
+ * Start the first row operation, complete right away if there is nothing to program.
+ * Called in the critical section the operation was set up in, leaves it.
+ */
+static cy_rslt_t ota_flash_async_kick(uint32_t intr_status)
+{
+    cy_en_flashdrv_status_t rc;
+    cy_rslt_t result;
+
+    rc = ota_flash_async_start_next();
+    if(rc == CY_FLASH_DRV_OPERATION_STARTED)
+    {
+        Cy_SysLib_ExitCriticalSection(intr_status);
+        return CY_RSLT_SUCCESS;
+    }
+
+    result = (rc == CY_FLASH_DRV_SUCCESS) ? CY_RSLT_SUCCESS : CY_RSLT_TYPE_ERROR;
+    ota_flash_async_finish(result, intr_status);
+    return result;
+}
+#endif /* CY_OTA_INTERNAL_FLASH_ASYNC */
+
+#if (defined (CY_IP_MXSMIF) && !defined (XMC7100) && !defined (XMC7200))
+#ifndef CY_XIP_SMIF_MODE_CHANGE
+static uint32_t ota_smif_get_memory_size(void)
+{
+    uint32_t size = 0;
+
+    if (SMIF0 != NULL)
+    {
+        size = smifBlockConfig.memConfig[MEM_SLOT]->deviceCfg->memSize;
+    }
+
+    return size;
+}
+#endif /* !CY_XIP_SMIF_MODE_CHANGE */
+
+/*
+ * Flatten the hybrid sector regions of the external flash into ota_smif_erase_regions[].
+ * The regions are walked from address 0 with Cy_SMIF_MemLocateHybridRegion(), which only reads
+ * the memory configuration in RAM. A memory that is not hybrid at address 0 is uniform.
+ */
+static void ota_smif_cache_erase_regions(void)
+{
+    cy_stc_smif_hybrid_region_info_t *hybrid_info = NULL;
+    uint32_t mem_size = smifBlockConfig.memConfig[MEM_SLOT]->deviceCfg->memSize;
+    uint32_t addr = 0;
+    uint32_t count = 0;
+    uint32_t end;
+    bool valid = true;
+
+    ota_smif_erase_regions_valid = false;
+
+    while (valid && (addr < mem_size))
+    {
+        if (Cy_SMIF_MemLocateHybridRegion(smifBlockConfig.memConfig[MEM_SLOT], &hybrid_info, addr) != CY_SMIF_SUCCESS)
+        {
+            /* No region at all is a uniform memory, a gap between regions is not cached */
+            valid = (count == 0u);
+            break;
+        }
+
+        end = hybrid_info->regionAddress + (hybrid_info->sectorsCount * hybrid_info->eraseSize);
+        if ((count == CY_OTA_SMIF_HYBRID_REGIONS_MAX) || (hybrid_info->regionAddress > addr) || (end <= addr))
+        {
+            valid = false;
+            break;
+        }
+
+        ota_smif_erase_regions[count].start         = addr;
+        ota_smif_erase_regions[count].end           = end;
+        ota_smif_erase_regions[count].erase_size    = hybrid_info->eraseSize;
+        ota_smif_erase_regions[count].erase_time_ms = hybrid_info->eraseTime;
+        ota_smif_erase_regions[count].erase_cmd     = hybrid_info->eraseCmd;
+        count++;
+        addr = end;
+    }
+
+    ota_smif_erase_region_count  = count;
+    ota_smif_erase_regions_valid = valid;
+}
+
+/*
+ * Cached hybrid region holding addr, NULL when addr is outside all of them.
+ * Binary search for the last region starting at or below addr.
+ */
+static ota_smif_erase_region_t const *ota_smif_find_erase_region(uint32_t addr)
+{
+    uint32_t low = 0;
+    uint32_t high = ota_smif_erase_region_count;
+    uint32_t mid;
+
+    while (low < high)
+    {
+        mid = low + ((high - low) / 2u);
+        if (ota_smif_erase_regions[mid].start <= addr)
+        {
+            low = mid + 1u;
+        }
+        else
+        {
+            high = mid;
+        }
+    }
+
+    if ((low != 0u) && (addr < ota_smif_erase_regions[low - 1u].end))
+    {
+        return &ota_smif_erase_regions[low - 1u];
+    }
+    return NULL;
+}
+
+/*
+ * Get erase sector size and maximum sector erase time (ms) at addr, and the end of its erase region.
+ * Returns true when addr is in a hybrid region, erase_cmd (when not NULL) is set to its erase instruction.
+ * Uses the geometry cached at cy_ota_mem_init(), or the memory configuration before that.
+ */
+static bool ota_smif_get_erase_region(uint32_t addr, uint32_t *erase_size, uint32_t *erase_time_ms, uint32_t *region_end,
+                                      uint32_t *erase_cmd)
+{
+    cy_stc_smif_hybrid_region_info_t *hybrid_info = NULL;
+    ota_smif_erase_region_t const *region;
+    cy_stc_smif_mem_device_cfg_t const *device_cfg = smifBlockConfig.memConfig[MEM_SLOT]->deviceCfg;
+
+    if (ota_smif_erase_regions_valid)
+    {
+        region = ota_smif_find_erase_region(addr);
+        if (region != NULL)
+        {
+            *erase_size    = region->erase_size;
+            *erase_time_ms = region->erase_time_ms;
+            *region_end    = region->end;
+            if (erase_cmd != NULL)
+            {
+                *erase_cmd = region->erase_cmd;
+            }
+            return true;
+        }
+    }
+    /* Cy_SMIF_MemLocateHybridRegion() does not access the external flash, just data tables from RAM  */
+    else if (Cy_SMIF_MemLocateHybridRegion(smifBlockConfig.memConfig[MEM_SLOT], &hybrid_info, addr) == CY_SMIF_SUCCESS)
+    {
+        *erase_size    = hybrid_info->eraseSize;
+        *erase_time_ms = hybrid_info->eraseTime;
+        *region_end    = hybrid_info->regionAddress + (hybrid_info->sectorsCount * hybrid_info->eraseSize);
+        if (erase_cmd != NULL)
+        {
+            *erase_cmd = hybrid_info->eraseCmd;
+        }
+        return true;
+    }
+    else
+    {
+        /* Uniform memory */
+    }
+
+    *erase_size    = device_cfg->eraseSize;
+    *erase_time_ms = device_cfg->eraseTime;
+    *region_end    = device_cfg->memSize;
+    return false;
+}
+
+#ifdef CY_XIP_SMIF_MODE_CHANGE
+/* Number of steps taking step_time_us that fit in one XIP-off window, at least one */
+static uint32_t ota_smif_steps_per_xip_window(uint32_t step_time_us)
+{
+    uint32_t steps = 1u;
+
+#if (CY_OTA_SMIF_XIP_OFF_MAX_US != 0u)
+    if ((step_time_us != 0u) && (step_time_us < CY_OTA_SMIF_XIP_OFF_MAX_US))
+    {
+        steps = CY_OTA_SMIF_XIP_OFF_MAX_US / step_time_us;
+    }
+#else
+    (void)step_time_us;
+#endif
+
+    return steps;
+}
+
+/*
+ * Program pages per XIP-off window: as many as fit in CY_OTA_SMIF_XIP_OFF_MAX_US, or without a
+ * time limit those covering CY_OTA_SMIF_XIP_OFF_PROGRAM_SIZE bytes at any alignment
+ */
+static uint32_t ota_smif_pages_per_xip_window(cy_stc_smif_mem_device_cfg_t const *device_cfg)
+{
+#if (CY_OTA_SMIF_XIP_OFF_MAX_US != 0u)
+    return ota_smif_steps_per_xip_window(device_cfg->programTime);
+#else
+    if (device_cfg->programSize == 0u)
+    {
+        return 1u;
+    }
+    return ((CY_OTA_SMIF_XIP_OFF_PROGRAM_SIZE + device_cfg->programSize - 1u) / device_cfg->programSize) + 1u;
+#endif
+}
+#endif /* CY_XIP_SMIF_MODE_CHANGE */
+
+#if !defined (CY_XIP_SMIF_MODE_CHANGE) || defined (CY_OTA_SMIF_SFDP)
+static void ota_smif_addr_to_array(uint32_t addr, uint8_t *addr_array, uint32_t addr_len)
+{
+    while (addr_len > 0u)
+    {
+        addr_len--;
+        addr_array[addr_len] = (uint8_t)(addr & 0xFFu);
+        addr >>= 8u;
+    }
+}
+#endif
+
+/* Number of data lines of a transfer width */
+static uint32_t ota_smif_width_lines(cy_en_smif_txfr_width_t width)
+{
+    switch (width)
+    {
+        case CY_SMIF_WIDTH_DUAL:
+            return 2u;
+        case CY_SMIF_WIDTH_QUAD:
+            return 4u;
+        case CY_SMIF_WIDTH_OCTAL:
+            return 8u;
+        default:
+            return 1u;
+    }
+}
+
+#ifdef CY_OTA_SMIF_SFDP
+/* Read SFDP data, the SFDP read is always single width with a 3 byte address */
+static cy_en_smif_status_t ota_smif_read_sfdp(uint32_t offset, uint8_t *data, uint32_t len)
+{
+    cy_en_smif_status_t cy_smif_result;
+    uint8_t addr_array[CY_OTA_SFDP_ADDR_LEN];
+
+    ota_smif_addr_to_array(offset, addr_array, sizeof(addr_array));
+
+    cy_smif_result = Cy_SMIF_TransmitCommand(SMIF0, CY_OTA_SFDP_READ_CMD, CY_SMIF_WIDTH_SINGLE,
+                                             addr_array, sizeof(addr_array), CY_SMIF_WIDTH_SINGLE,
+                                             smifBlockConfig.memConfig[MEM_SLOT]->slaveSelect,
+                                             CY_SMIF_TX_NOT_LAST_BYTE, &ota_QSPI_context);
+    if (cy_smif_result == CY_SMIF_SUCCESS)
+    {
+        cy_smif_result = Cy_SMIF_SendDummyCycles(SMIF0, CY_OTA_SFDP_DUMMY_CYCLES);
+    }
+    if (cy_smif_result == CY_SMIF_SUCCESS)
+    {
+        cy_smif_result = Cy_SMIF_ReceiveDataBlocking(SMIF0, data, len, CY_SMIF_WIDTH_SINGLE, &ota_QSPI_context);
+    }
+
+    return cy_smif_result;
+}
+
+/* Find an SFDP parameter table by ID, get its address and length in dwords. Called with XIP off. */
+static bool ota_smif_sfdp_find_table(uint16_t id, uint32_t *table_addr, uint32_t *table_dwords)
+{
+    uint8_t  header[CY_OTA_SFDP_HEADER_SIZE];
+    uint8_t  param[CY_OTA_SFDP_PARAM_HEADER_SIZE];
+    uint32_t index;
+
+    if ((ota_smif_read_sfdp(0u, header, sizeof(header)) != CY_SMIF_SUCCESS) ||
+        (cy_ota_buffer_load_word(header) != CY_OTA_SFDP_SIGNATURE))
+    {
+        return false;
+    }
+
+    for (index = 0u; index <= header[CY_OTA_SFDP_NPH_OFFSET]; index++)
+    {
+        if (ota_smif_read_sfdp(CY_OTA_SFDP_HEADER_SIZE + (index * CY_OTA_SFDP_PARAM_HEADER_SIZE),
+                               param, sizeof(param)) != CY_SMIF_SUCCESS)
+        {
+            return false;
+        }
+
+        if ((((uint32_t)param[CY_OTA_SFDP_PARAM_ID_MSB_OFFSET] << 8u) | param[CY_OTA_SFDP_PARAM_ID_LSB_OFFSET]) == id)
+        {
+            *table_addr   = (uint32_t)param[CY_OTA_SFDP_PARAM_PTR_OFFSET] |
+                            ((uint32_t)param[CY_OTA_SFDP_PARAM_PTR_OFFSET + 1u] << 8u) |
+                            ((uint32_t)param[CY_OTA_SFDP_PARAM_PTR_OFFSET + 2u] << 16u);
+            *table_dwords = param[CY_OTA_SFDP_PARAM_LEN_OFFSET];
+            return true;
+        }
+    }
+
+    return false;
+}
+#endif /* CY_OTA_SMIF_SFDP */
+
+#ifdef CY_OTA_SMIF_FAST_CMDS
+/* A read or program command, the fields of cy_stc_smif_mem_cmd_t that the selection changes */
+typedef struct
+{
+    uint8_t                 command;
+    cy_en_smif_txfr_width_t addr_width;
+    cy_en_smif_txfr_width_t data_width;
+    uint32_t                dummy_cycles;
+} ota_smif_cmd_choice_t;
+
+/* Read and program commands selected at init, copies of the configured commands with wider phases */
+static cy_stc_smif_mem_cmd_t ota_smif_fast_read_cmd;
+static cy_stc_smif_mem_cmd_t ota_smif_fast_program_cmd;
+
+/* Clock cycles spent before the first data byte: address and dummy cycles */
+static uint32_t ota_smif_cmd_overhead(ota_smif_cmd_choice_t const *choice, uint32_t addr_bytes)
+{
+    return ((addr_bytes * 8u) / ota_smif_width_lines(choice->addr_width)) + choice->dummy_cycles;
+}
+
+/* Keep the candidate if it moves data over more lines, or over as many lines with less overhead */
+static void ota_smif_cmd_consider(ota_smif_cmd_choice_t *best, ota_smif_cmd_choice_t const *candidate,
+                                  uint32_t addr_bytes)
+{
+    uint32_t best_lines      = ota_smif_width_lines(best->data_width);
+    uint32_t candidate_lines = ota_smif_width_lines(candidate->data_width);
+
+    if ((candidate->command == 0u) || (candidate->command == 0xFFu) ||
+        (candidate_lines > CY_OTA_SMIF_FAST_CMDS_MAX_LINES))
+    {
+        return;
+    }
+    if ((candidate_lines > best_lines) ||
+        ((candidate_lines == best_lines) &&
+         (ota_smif_cmd_overhead(candidate, addr_bytes) < ota_smif_cmd_overhead(best, addr_bytes))))
+    {
+        *best = *candidate;
+    }
+}
+
+/*
+ * Consider a fast read described by a 16-bit SFDP read field: instruction, mode clocks and wait
+ * states. Reads with mode clocks are skipped, their mode bits would have to be driven to keep the
+ * memory out of continuous read mode. With 4 byte addresses cmd_4b replaces the instruction.
+ */
+static void ota_smif_read_consider(ota_smif_cmd_choice_t *best, uint32_t field, bool supported, uint8_t cmd_4b,
+                                   cy_en_smif_txfr_width_t addr_width, cy_en_smif_txfr_width_t data_width,
+                                   uint32_t addr_bytes)
+{
+    ota_smif_cmd_choice_t candidate;
+
+    if (!supported || (((field >> 5u) & 0x07u) != 0u))
+    {
+        return;
+    }
+
+    candidate.command      = (addr_bytes == 4u) ? cmd_4b : (uint8_t)(field >> 8u);
+    candidate.addr_width   = addr_width;
+    candidate.data_width   = data_width;
+    candidate.dummy_cycles = field & 0x1Fu;
+    ota_smif_cmd_consider(best, &candidate, addr_bytes);
+}
+
+/* Point the device configuration at a copy of its command with the chosen instruction and widths */
+static cy_stc_smif_mem_cmd_t *ota_smif_cmd_apply(cy_stc_smif_mem_cmd_t *fast_cmd, cy_stc_smif_mem_cmd_t const *cmd,
+                                                 ota_smif_cmd_choice_t const *choice)
+{
+    *fast_cmd              = *cmd;
+    fast_cmd->command      = choice->command;
+    fast_cmd->addrWidth    = choice->addr_width;
+    fast_cmd->dataWidth    = choice->data_width;
+    fast_cmd->dummyCycles  = choice->dummy_cycles;
+    fast_cmd->mode         = CY_SMIF_NO_COMMAND_OR_MODE;
+#if (CY_IP_MXSMIF_VERSION >= 2)
+    fast_cmd->modePresence        = CY_SMIF_NOT_PRESENT;
+    fast_cmd->dummyCyclesPresence = (choice->dummy_cycles != 0u) ? CY_SMIF_PRESENT_1BYTE : CY_SMIF_NOT_PRESENT;
+#endif
+    return fast_cmd;
+}
+
+/*
+ * Switch the read and program commands to the widest ones the memory advertises in SFDP: quad
+ * (or octal with CY_OTA_SMIF_OCTAL) fast read and, for 4 byte addresses, quad page program.
+ * SFDP does not describe quad page program with 3 byte addresses, CY_OTA_SMIF_QUAD_PROGRAM_CMD
+ * names the 1-1-4 instruction of such parts. Called with XIP off, after quad mode is enabled.
+ */
+static void ota_smif_select_fast_cmds(void)
+{
+    cy_stc_smif_mem_device_cfg_t *device_cfg = smifBlockConfig.memConfig[MEM_SLOT]->deviceCfg;
+    uint32_t addr_bytes = device_cfg->numOfAddrBytes;
+    ota_smif_cmd_choice_t best;
+    ota_smif_cmd_choice_t candidate;
+    uint8_t  dwords[12];
+    uint32_t bfpt_addr;
+    uint32_t bfpt_dwords;
+    uint32_t table_addr;
+    uint32_t table_dwords;
+    uint32_t dword1;
+    uint32_t dword3;
+    uint32_t dword17 = 0u;
+    uint32_t bait = 0u;
+
+    if (!ota_smif_sfdp_find_table(CY_OTA_SFDP_BFPT_ID, &bfpt_addr, &bfpt_dwords) ||
+        (ota_smif_read_sfdp(bfpt_addr + CY_OTA_SFDP_BFPT_DWORD1_OFFSET, dwords, sizeof(dwords)) != CY_SMIF_SUCCESS))
+    {
+        return;
+    }
+    dword1 = cy_ota_buffer_load_word(&dwords[CY_OTA_SFDP_BFPT_DWORD1_OFFSET]);
+    dword3 = cy_ota_buffer_load_word(&dwords[CY_OTA_SFDP_BFPT_DWORD3_OFFSET]);
+
+    if ((CY_OTA_SMIF_FAST_CMDS_MAX_LINES >= 8u) && (bfpt_dwords >= CY_OTA_SFDP_BFPT_OCTAL_DWORDS) &&
+        (ota_smif_read_sfdp(bfpt_addr + CY_OTA_SFDP_BFPT_DWORD17_OFFSET, dwords, 4u) == CY_SMIF_SUCCESS))
+    {
+        dword17 = cy_ota_buffer_load_word(dwords);
+    }
+
+    /* The instructions in BFPT use 3 byte addresses, 4 byte address instructions are listed in 4BAIT */
+    if ((addr_bytes == 4u) && ota_smif_sfdp_find_table(CY_OTA_SFDP_4BAIT_ID, &table_addr, &table_dwords) &&
+        (table_dwords >= 1u) && (ota_smif_read_sfdp(table_addr, dwords, 4u) == CY_SMIF_SUCCESS))
+    {
+        bait = cy_ota_buffer_load_word(dwords);
+    }
+
+    /* Read */
+    best.command      = (uint8_t)device_cfg->readCmd->command;
+    best.addr_width   = device_cfg->readCmd->addrWidth;
+    best.data_width   = device_cfg->readCmd->dataWidth;
+    best.dummy_cycles = device_cfg->readCmd->dummyCycles;
+
+    ota_smif_read_consider(&best, dword3 >> 16u,
+                           ((dword1 & CY_OTA_SFDP_READ_1_1_4) != 0u) && ((addr_bytes != 4u) || ((bait & CY_OTA_SFDP_4BAIT_READ_1_1_4) != 0u)),
+                           CY_OTA_SMIF_4B_READ_1_1_4_CMD, CY_SMIF_WIDTH_SINGLE, CY_SMIF_WIDTH_QUAD, addr_bytes);
+    ota_smif_read_consider(&best, dword3 & 0xFFFFu,
+                           ((dword1 & CY_OTA_SFDP_READ_1_4_4) != 0u) && ((addr_bytes != 4u) || ((bait & CY_OTA_SFDP_4BAIT_READ_1_4_4) != 0u)),
+                           CY_OTA_SMIF_4B_READ_1_4_4_CMD, CY_SMIF_WIDTH_QUAD, CY_SMIF_WIDTH_QUAD, addr_bytes);
+    ota_smif_read_consider(&best, dword17 & 0xFFFFu,
+                           ((dword17 & 0xFF00u) != 0u) && ((addr_bytes != 4u) || ((bait & CY_OTA_SFDP_4BAIT_READ_1_1_8) != 0u)),
+                           CY_OTA_SMIF_4B_READ_1_1_8_CMD, CY_SMIF_WIDTH_SINGLE, CY_SMIF_WIDTH_OCTAL, addr_bytes);
+    ota_smif_read_consider(&best, dword17 >> 16u,
+                           ((dword17 & 0xFF000000u) != 0u) && ((addr_bytes != 4u) || ((bait & CY_OTA_SFDP_4BAIT_READ_1_8_8) != 0u)),
+                           CY_OTA_SMIF_4B_READ_1_8_8_CMD, CY_SMIF_WIDTH_OCTAL, CY_SMIF_WIDTH_OCTAL, addr_bytes);
+
+    if (ota_smif_width_lines(best.data_width) > ota_smif_width_lines(device_cfg->readCmd->dataWidth))
+    {
+        device_cfg->readCmd = ota_smif_cmd_apply(&ota_smif_fast_read_cmd, device_cfg->readCmd, &best);
+    }
+
+    /* Program */
+    best.command      = (uint8_t)device_cfg->programCmd->command;
+    best.addr_width   = device_cfg->programCmd->addrWidth;
+    best.data_width   = device_cfg->programCmd->dataWidth;
+    best.dummy_cycles = 0u;
+
+    candidate.dummy_cycles = 0u;
+    if (addr_bytes == 4u)
+    {
+        static const struct
+        {
+            uint32_t                bait_bit;
+            uint8_t                 command;
+            cy_en_smif_txfr_width_t addr_width;
+            cy_en_smif_txfr_width_t data_width;
+        } programs[] =
+        {
+            { CY_OTA_SFDP_4BAIT_PP_1_1_4, CY_OTA_SMIF_4B_PP_1_1_4_CMD, CY_SMIF_WIDTH_SINGLE, CY_SMIF_WIDTH_QUAD  },
+            { CY_OTA_SFDP_4BAIT_PP_1_4_4, CY_OTA_SMIF_4B_PP_1_4_4_CMD, CY_SMIF_WIDTH_QUAD,   CY_SMIF_WIDTH_QUAD  },
+            { CY_OTA_SFDP_4BAIT_PP_1_1_8, CY_OTA_SMIF_4B_PP_1_1_8_CMD, CY_SMIF_WIDTH_SINGLE, CY_SMIF_WIDTH_OCTAL },
+            { CY_OTA_SFDP_4BAIT_PP_1_8_8, CY_OTA_SMIF_4B_PP_1_8_8_CMD, CY_SMIF_WIDTH_OCTAL,  CY_SMIF_WIDTH_OCTAL },
+        };
+        uint32_t index;
+
+        for (index = 0u; index < (sizeof(programs) / sizeof(programs[0])); index++)
+        {
+            if ((bait & programs[index].bait_bit) != 0u)
+            {
+                candidate.command    = programs[index].command;
+                candidate.addr_width = programs[index].addr_width;
+                candidate.data_width = programs[index].data_width;
+                ota_smif_cmd_consider(&best, &candidate, addr_bytes);
+            }
+        }
+    }
+#ifdef CY_OTA_SMIF_QUAD_PROGRAM_CMD
+    else
+    {
+        candidate.command    = (uint8_t)(CY_OTA_SMIF_QUAD_PROGRAM_CMD);
+        candidate.addr_width = CY_SMIF_WIDTH_SINGLE;
+        candidate.data_width = CY_SMIF_WIDTH_QUAD;
+        ota_smif_cmd_consider(&best, &candidate, addr_bytes);
+    }
+#endif
+
+    if (ota_smif_width_lines(best.data_width) > ota_smif_width_lines(device_cfg->programCmd->dataWidth))
+    {
+        device_cfg->programCmd = ota_smif_cmd_apply(&ota_smif_fast_program_cmd, device_cfg->programCmd, &best);
+    }
+}
+#endif /* CY_OTA_SMIF_FAST_CMDS */
+
+#if defined (CY_OTA_SMIF_ERASE_SUSPEND) || !defined (CY_XIP_SMIF_MODE_CHANGE) || defined (CY_OTA_SMIF_ERASE_PLANNER)
+/* Issue a sector erase with cmd, NULL for the erase command of the memory configuration */
+static cy_en_smif_status_t ota_smif_cmd_erase(cy_stc_smif_mem_config_t *mem_cfg, cy_stc_smif_mem_cmd_t const *cmd,
+                                              uint8_t const *addr_array)
+{
+    if (cmd == NULL)
+    {
+        return Cy_SMIF_MemCmdSectorErase(SMIF0, mem_cfg, addr_array, &ota_QSPI_context);
+    }
+
+    return Cy_SMIF_TransmitCommand(SMIF0, (uint8_t)cmd->command, cmd->cmdWidth, addr_array,
+                                   mem_cfg->deviceCfg->numOfAddrBytes, cmd->addrWidth, mem_cfg->slaveSelect,
+                                   CY_SMIF_TX_LAST_BYTE, &ota_QSPI_context);
+}
+#endif
+
+#ifdef CY_OTA_SMIF_ERASE_PLANNER
+/* One erase command of an erase plan */
+typedef struct
+{
+    uint32_t                        size;
+    uint32_t                        max_us;
+    cy_stc_smif_mem_cmd_t const     *cmd;   /* NULL for the erase command of the memory configuration */
+    ota_smif_op_t                   op;
+    cy_stc_smif_mem_cmd_t           region_cmd;     /* Erase command of a hybrid region */
+} ota_smif_erase_step_t;
+
+/* Erase time field of BFPT DWORD10 in us: count in bits 4:0, unit in bits 6:5 */
+static uint32_t ota_smif_sfdp_erase_time_us(uint32_t field)
+{
+    static const uint32_t units_us[] = { 1000u, 16000u, 128000u, 1000000u };
+
+    return ((field & 0x1Fu) + 1u) * units_us[(field >> 5u) & 0x03u];
+}
+
+/*
+ * Read the erase types of the memory from SFDP. With 4 byte addresses the instructions come
+ * from 4BAIT, types without one are dropped. The type with the erase size of the memory
+ * configuration keeps its erase command. Without erase times in SFDP the types are timed like
+ * the configured erase, scaled by size. Called with XIP off, after ota_smif_poll_init().
+ */
+static void ota_smif_detect_erase_types(void)
+{
+    cy_stc_smif_mem_device_cfg_t const *device_cfg = smifBlockConfig.memConfig[MEM_SLOT]->deviceCfg;
+    uint8_t  dwords[12];
+    uint8_t  bait[8];
+    uint32_t bfpt_addr;
+    uint32_t bfpt_dwords;
+    uint32_t table_addr;
+    uint32_t table_dwords;
+    uint32_t times = 0u;
+    uint32_t bait_dword1 = 0u;
+    uint32_t index;
+
+    ota_smif_erase_type_count = 0u;
+
+    if (!ota_smif_sfdp_find_table(CY_OTA_SFDP_BFPT_ID, &bfpt_addr, &bfpt_dwords) ||
+        (bfpt_dwords < CY_OTA_SFDP_BFPT_ERASE_TYPES_DWORDS) ||
+        (ota_smif_read_sfdp(bfpt_addr + CY_OTA_SFDP_BFPT_DWORD8_OFFSET, dwords, sizeof(dwords)) != CY_SMIF_SUCCESS))
+    {
+        return;
+    }
+    if (bfpt_dwords >= CY_OTA_SFDP_BFPT_ERASE_TIMES_DWORDS)
+    {
+        times = cy_ota_buffer_load_word(&dwords[8]);
+    }
+
+    if ((device_cfg->numOfAddrBytes == 4u) && ota_smif_sfdp_find_table(CY_OTA_SFDP_4BAIT_ID, &table_addr, &table_dwords) &&
+        (table_dwords >= 2u) && (ota_smif_read_sfdp(table_addr, bait, sizeof(bait)) == CY_SMIF_SUCCESS))
+    {
+        bait_dword1 = cy_ota_buffer_load_word(bait);
+    }
+
+    for (index = 0u; index < CY_OTA_SFDP_ERASE_TYPES; index++)
+    {
+        ota_smif_erase_type_t type;
+        uint32_t size_exp = dwords[index * 2u];
+        uint32_t slot;
+
+        if ((size_exp == 0u) || (size_exp >= 32u))
+        {
+            continue;
+        }
+
+        memset(&type, 0x00, sizeof(type));
+        type.size       = 1UL << size_exp;
+        type.device_cmd = (type.size == device_cfg->eraseSize);
+        type.cmd        = *device_cfg->eraseCmd;
+        if (device_cfg->numOfAddrBytes != 4u)
+        {
+            type.cmd.command = dwords[(index * 2u) + 1u];
+        }
+        else if ((bait_dword1 & (1UL << (CY_OTA_SFDP_4BAIT_ERASE_TYPE1_BIT + index))) != 0u)
+        {
+            type.cmd.command = bait[CY_OTA_SFDP_4BAIT_DWORD2_OFFSET + index];
+        }
+        else if (!type.device_cmd)
+        {
+            continue;
+        }
+
+        if (times != 0u)
+        {
+            /* DWORD10: max time multiplier in bits 3:0, typical times of the types from bit 4, 7 bits each */
+            type.typical_us = ota_smif_sfdp_erase_time_us(times >> (4u + (index * 7u)));
+            type.max_us     = 2u * ((times & 0x0Fu) + 1u) * type.typical_us;
+        }
+        else
+        {
+            type.max_us     = (uint32_t)(((uint64_t)device_cfg->eraseTime * 1000u * type.size) / device_cfg->eraseSize);
+            type.typical_us = type.max_us / 4u;
+        }
+
+        /* Insert sorted by size, a size listed twice is kept once */
+        for (slot = 0u; (slot < ota_smif_erase_type_count) && (ota_smif_erase_types[slot].size < type.size); slot++)
+        {
+        }
+        if ((slot < ota_smif_erase_type_count) && (ota_smif_erase_types[slot].size == type.size))
+        {
+            continue;
+        }
+        memmove(&ota_smif_erase_types[slot + 1u], &ota_smif_erase_types[slot],
+                (ota_smif_erase_type_count - slot) * sizeof(ota_smif_erase_types[0]));
+        ota_smif_erase_types[slot] = type;
+        ota_smif_erase_type_count++;
+    }
+
+    for (index = 0u; index < ota_smif_erase_type_count; index++)
+    {
+        ota_smif_erase_type_t *type = &ota_smif_erase_types[index];
+
+        type->best_us = type->typical_us;
+        if (index > 0u)
+        {
+            uint32_t smaller_us = (type->size / ota_smif_erase_types[index - 1u].size) * ota_smif_erase_types[index - 1u].best_us;
+
+            if (smaller_us < type->best_us)
+            {
+                type->best_us = smaller_us;
+            }
+        }
+        ota_smif_poll_estimate_us[OTA_SMIF_OP_ERASE_TYPE + index] = type->typical_us;
+    }
+}
+
+/* Smallest erase size at addr */
+static uint32_t ota_smif_erase_granularity(uint32_t addr)
+{
+    uint32_t erase_size;
+    uint32_t erase_time_ms;
+    uint32_t region_end;
+
+    if (!ota_smif_get_erase_region(addr, &erase_size, &erase_time_ms, &region_end, NULL) &&
+        (ota_smif_erase_type_count != 0u) && (ota_smif_erase_types[0].size < erase_size))
+    {
+        erase_size = ota_smif_erase_types[0].size;
+    }
+
+    return erase_size;
+}
+
+#ifdef CY_XIP_SMIF_MODE_CHANGE
+/*
+ * With XIP mode switching an erase command runs with XIP off. Types erasing within
+ * CY_OTA_SMIF_XIP_OFF_MAX_US fit, or without it those no larger than the configured sector.
+ * The smallest type is always used, a single sector erase is never split.
+ */
+static bool ota_smif_erase_type_fits_xip_off(uint32_t index)
+{
+    if (index == 0u)
+    {
+        return true;
+    }
+#if (CY_OTA_SMIF_XIP_OFF_MAX_US != 0u)
+    return (ota_smif_erase_types[index].max_us <= CY_OTA_SMIF_XIP_OFF_MAX_US);
+#else
+    return (ota_smif_erase_types[index].size <= smifBlockConfig.memConfig[MEM_SLOT]->deviceCfg->eraseSize);
+#endif
+}
+#endif
+
+/*
+ * Plan the erase command at addr of the range ending at end_addr. Hybrid regions have a single
+ * sector size erased with the command of the region. Elsewhere the largest erase type that is
+ * aligned at addr and fits in the range is used, unless smaller types erase the same bytes
+ * faster. Returns false when there is nothing to erase with.
+ */
+static bool ota_smif_erase_plan_step(uint32_t addr, uint32_t end_addr, ota_smif_erase_step_t *step)
+{
+    uint32_t erase_time_ms;
+    uint32_t region_end;
+    uint32_t region_cmd;
+    uint32_t index;
+
+    step->cmd = NULL;
+    step->op  = OTA_SMIF_OP_ERASE;
+    if (ota_smif_get_erase_region(addr, &step->size, &erase_time_ms, &region_end, &region_cmd))
+    {
+        step->region_cmd         = *smifBlockConfig.memConfig[MEM_SLOT]->deviceCfg->eraseCmd;
+        step->region_cmd.command = region_cmd;
+        step->cmd                = &step->region_cmd;
+    }
+    else
+    {
+        for (index = ota_smif_erase_type_count; index > 0u; index--)
+        {
+            ota_smif_erase_type_t const *type = &ota_smif_erase_types[index - 1u];
+
+#ifdef CY_XIP_SMIF_MODE_CHANGE
+            if (!ota_smif_erase_type_fits_xip_off(index - 1u))
+            {
+                continue;
+            }
+#endif
+            if (((addr % type->size) == 0u) && (type->size <= (end_addr - addr)) &&
+                (type->size <= (region_end - addr)) && (type->typical_us <= type->best_us))
+            {
+                step->size   = type->size;
+                step->max_us = type->max_us;
+                step->cmd    = type->device_cmd ? NULL : &type->cmd;
+                step->op     = (ota_smif_op_t)(OTA_SMIF_OP_ERASE_TYPE + (index - 1u));
+                return true;
+            }
+        }
+    }
+    step->max_us = erase_time_ms * 1000u;
+
+    return (step->size != 0u);
+}
+
+/* Estimated time of the erase plan of a range, from the learned erase times */
+static uint32_t ota_smif_erase_estimate_us(uint32_t addr, uint32_t end_addr)
+{
+    ota_smif_erase_step_t step;
+    uint32_t estimate_us = 0u;
+
+    while ((addr < end_addr) && ota_smif_erase_plan_step(addr, end_addr, &step))
+    {
+        estimate_us += ota_smif_poll_estimate_us[step.op];
+        addr        += step.size;
+    }
+
+    return estimate_us;
+}
+#endif /* CY_OTA_SMIF_ERASE_PLANNER */
+
+#ifdef CY_OTA_SMIF_ERASE_SUSPEND
+typedef enum
+{
+    OTA_SMIF_ERASE_IDLE = 0,
+    OTA_SMIF_ERASE_RUNNING,
+    OTA_SMIF_ERASE_SUSPENDED,
+} ota_smif_erase_state_t;
+
+/* Erase suspend/resume parameters from SFDP and the state of the sector erase in progress */
+typedef struct
+{
+    bool                            supported;
+    uint8_t                         suspend_cmd;
+    uint8_t                         resume_cmd;
+    uint32_t                        suspend_latency_us;     /* Longest time to enter erase suspend */
+    uint32_t                        resume_interval_us;     /* Shortest time from resume to the next suspend */
+    uint32_t                        erase_addr;             /* Range of the erase in progress */
+    uint32_t                        erase_size;
+    volatile ota_smif_erase_state_t state;
+} ota_smif_erase_suspend_t;
+
+static ota_smif_erase_suspend_t ota_smif_erase_suspend;
+
+/* Latency encoded in BFPT DWORD12 as units (128 ns, 1 us, 8 us, 64 us) and a count */
+static uint32_t ota_smif_sfdp_latency_us(uint32_t units, uint32_t count)
+{
+    static const uint32_t unit_ns[] = { 128u, 1000u, 8000u, 64000u };
+
+    return (((count + 1u) * unit_ns[units & 0x03u]) + 999u) / 1000u;
+}
+
+/*
+ * Check the JEDEC Basic Flash Parameter Table for erase suspend/resume support and
+ * get the instructions and timing. Called with XIP off.
+ */
+static void ota_smif_detect_erase_suspend(void)
+{
+    uint8_t  dwords[8];
+    uint32_t bfpt_addr;
+    uint32_t bfpt_dwords;
+    uint32_t dword12;
+
+    memset(&ota_smif_erase_suspend, 0x00, sizeof(ota_smif_erase_suspend));
+
+    if (!ota_smif_sfdp_find_table(CY_OTA_SFDP_BFPT_ID, &bfpt_addr, &bfpt_dwords) ||
+        (bfpt_dwords < CY_OTA_SFDP_BFPT_SUSPEND_DWORDS))
+    {
+        return;
+    }
+
+    /* DWORD12 (suspend timing) and DWORD13 (suspend/resume instructions) */
+    if (ota_smif_read_sfdp(bfpt_addr + CY_OTA_SFDP_BFPT_DWORD12_OFFSET, dwords, sizeof(dwords)) != CY_SMIF_SUCCESS)
+    {
+        return;
+    }
+
+    dword12 = cy_ota_buffer_load_word(dwords);
+    if ((dword12 & CY_OTA_SFDP_SUSPEND_NOT_SUPPORTED) != 0u)
+    {
+        return;
+    }
+
+    ota_smif_erase_suspend.suspend_latency_us = ota_smif_sfdp_latency_us(dword12 >> 29u, (dword12 >> 24u) & 0x1Fu);
+    ota_smif_erase_suspend.resume_interval_us = (((dword12 >> 20u) & 0x0Fu) + 1u) * 64u;
+    ota_smif_erase_suspend.resume_cmd         = dwords[6];
+    ota_smif_erase_suspend.suspend_cmd        = dwords[7];
+    ota_smif_erase_suspend.supported          = true;
+}
+
+static cy_en_smif_status_t ota_smif_send_cmd(uint8_t cmd)
+{
+    return Cy_SMIF_TransmitCommand(SMIF0, cmd, CY_SMIF_WIDTH_SINGLE, NULL, CY_SMIF_CMD_WITHOUT_PARAM,
+                                   CY_SMIF_WIDTH_SINGLE, smifBlockConfig.memConfig[MEM_SLOT]->slaveSelect,
+                                   CY_SMIF_TX_LAST_BYTE, &ota_QSPI_context);
+}
+
+#if defined (CY_XIP_SMIF_MODE_CHANGE) || !(defined (CY_OTA_DIRECT_XIP) && defined (ENABLE_ON_THE_FLY_ENCRYPTION))
+/* Suspend the running erase and wait until the memory accepts reads. Called with XIP off and interrupts masked. */
+static cy_en_smif_status_t ota_smif_erase_suspend_now(void)
+{
+    cy_en_smif_status_t cy_smif_result;
+    uint32_t waited_us = 0u;
+
+    cy_smif_result = ota_smif_send_cmd(ota_smif_erase_suspend.suspend_cmd);
+    if (cy_smif_result != CY_SMIF_SUCCESS)
+    {
+        return cy_smif_result;
+    }
+
+    while (Cy_SMIF_MemIsBusy(SMIF0, smifBlockConfig.memConfig[MEM_SLOT], &ota_QSPI_context))
+    {
+        if (waited_us > ota_smif_erase_suspend.suspend_latency_us)
+        {
+            return CY_SMIF_EXCEED_TIMEOUT;
+        }
+        Cy_SysLib_DelayUs(CY_OTA_SMIF_SUSPEND_POLL_US);
+        waited_us += CY_OTA_SMIF_SUSPEND_POLL_US;
+    }
+
+    ota_smif_erase_suspend.state = OTA_SMIF_ERASE_SUSPENDED;
+    return CY_SMIF_SUCCESS;
+}
+#endif
+
+/*
+ * Resume the suspended erase. The caller must let the minimum resume to suspend interval pass
+ * before the next suspend so back-to-back reads cannot starve the erase. Called with XIP off
+ * and interrupts masked.
+ */
+static cy_en_smif_status_t ota_smif_erase_resume_now(void)
+{
+    cy_en_smif_status_t cy_smif_result;
+
+    cy_smif_result = ota_smif_send_cmd(ota_smif_erase_suspend.resume_cmd);
+    if (cy_smif_result == CY_SMIF_SUCCESS)
+    {
+        ota_smif_erase_suspend.state = OTA_SMIF_ERASE_RUNNING;
+    }
+
+    return cy_smif_result;
+}
+
+#if !(defined (CY_OTA_DIRECT_XIP) && defined (ENABLE_ON_THE_FLY_ENCRYPTION))
+/*
+ * Read while another thread may be erasing. A read of the sector being erased waits for the
+ * erase to end, suspending would not make the sector readable. Otherwise a running erase is
+ * suspended for at most CY_OTA_SMIF_SUSPENDED_READ_MAX bytes at a time. Interrupts are only
+ * masked while an erase is in progress. Called with XIP on.
+ */
+static cy_en_smif_status_t ota_smif_read_during_erase(uint32_t addr, uint8_t *data, size_t len)
+{
+    cy_en_smif_status_t cy_smif_result = CY_SMIF_SUCCESS;
+    uint32_t intr_status;
+    size_t chunk_size;
+    bool suspended;
+
+    while ((len > 0u) && (cy_smif_result == CY_SMIF_SUCCESS))
+    {
+        if (ota_smif_erase_suspend.state == OTA_SMIF_ERASE_IDLE)
+        {
+            /* pre-access to SMIF */
+            PRE_SMIF_ACCESS_TURN_OFF_XIP;
+            cy_smif_result = Cy_SMIF_MemRead(SMIF0, smifBlockConfig.memConfig[MEM_SLOT], addr, data, len, &ota_QSPI_context);
+            /* post-access to SMIF */
+            POST_SMIF_ACCESS_TURN_ON_XIP;
+            break;
+        }
+
+        intr_status = Cy_SysLib_EnterCriticalSection();
+        if ((ota_smif_erase_suspend.state != OTA_SMIF_ERASE_IDLE) &&
+            (addr < (ota_smif_erase_suspend.erase_addr + ota_smif_erase_suspend.erase_size)) &&
+            (ota_smif_erase_suspend.erase_addr < (addr + len)))
+        {
+            Cy_SysLib_ExitCriticalSection(intr_status);
+            ota_smif_delay_us(CY_OTA_SMIF_ERASE_WAIT_US, true);
+            continue;
+        }
+
+        chunk_size = (len > CY_OTA_SMIF_SUSPENDED_READ_MAX) ? CY_OTA_SMIF_SUSPENDED_READ_MAX : len;
+        suspended  = false;
+
+        /* pre-access to SMIF */
+        PRE_SMIF_ACCESS_TURN_OFF_XIP;
+        if (ota_smif_erase_suspend.state == OTA_SMIF_ERASE_RUNNING)
+        {
+            cy_smif_result = ota_smif_erase_suspend_now();
+            suspended = (cy_smif_result == CY_SMIF_SUCCESS);
+        }
+        if (cy_smif_result == CY_SMIF_SUCCESS)
+        {
+            cy_smif_result = Cy_SMIF_MemRead(SMIF0, smifBlockConfig.memConfig[MEM_SLOT], addr, data, chunk_size, &ota_QSPI_context);
+        }
+        if (suspended)
+        {
+            /* Left suspended on failure, the erasing thread resumes it */
+            (void)ota_smif_erase_resume_now();
+        }
+        /* post-access to SMIF */
+        POST_SMIF_ACCESS_TURN_ON_XIP;
+        Cy_SysLib_ExitCriticalSection(intr_status);
+
+        if (suspended)
+        {
+            /* Resume to suspend interval, with interrupts enabled and XIP on */
+            ota_smif_delay_us(ota_smif_erase_suspend.resume_interval_us, false);
+        }
+
+        addr += chunk_size;
+        data += chunk_size;
+        len  -= chunk_size;
+    }
+
+    return cy_smif_result;
+}
+#endif /* !(CY_OTA_DIRECT_XIP & ENABLE_ON_THE_FLY_ENCRYPTION) */
+
+/*
+ * Erase one sector with the erase command issued directly, so the erase can be suspended.
+ * cy_ota_mem_read() from another thread suspends the erase for the read. With XIP mode
+ * switching the erase is also suspended at the end of every XIP-off window so code can be
+ * fetched from the memory until the next window resumes it. size is the size of the sector,
+ * cmd the erase command, NULL for the one of the memory configuration, op the operation its
+ * completion time is learned for.
+ */
+static cy_en_smif_status_t ota_smif_erase_sector_suspendable(uint32_t addr, uint32_t size, cy_stc_smif_mem_cmd_t const *cmd, ota_smif_op_t op)
+{
+    cy_stc_smif_mem_config_t *mem_cfg = smifBlockConfig.memConfig[MEM_SLOT];
+    cy_en_smif_status_t cy_smif_result;
+    uint8_t addr_array[CY_OTA_SMIF_MAX_ADDR_LEN];
+    uint32_t intr_status;
+    bool busy = true;
+    ota_smif_poll_t poll;
+    uint32_t timeout_us = ota_smif_poll_timeout_us(op);
+#ifdef CY_XIP_SMIF_MODE_CHANGE
+    uint32_t window_us = CY_OTA_SMIF_XIP_OFF_MAX_US;
+
+    if (window_us < ota_smif_erase_suspend.resume_interval_us)
+    {
+        window_us = ota_smif_erase_suspend.resume_interval_us;
+    }
+#endif
+
+    ota_smif_addr_to_array(addr, addr_array, mem_cfg->deviceCfg->numOfAddrBytes);
+    ota_smif_poll_start(&poll, op);
+
+    intr_status = Cy_SysLib_EnterCriticalSection();
+    {
+        /* pre-access to SMIF */
+        PRE_SMIF_ACCESS_TURN_OFF_XIP;
+        cy_smif_result = Cy_SMIF_MemCmdWriteEnable(SMIF0, mem_cfg, &ota_QSPI_context);
+        if (cy_smif_result == CY_SMIF_SUCCESS)
+        {
+            cy_smif_result = ota_smif_cmd_erase(mem_cfg, cmd, addr_array);
+        }
+        if (cy_smif_result == CY_SMIF_SUCCESS)
+        {
+            ota_smif_erase_suspend.erase_addr = addr;
+            ota_smif_erase_suspend.erase_size = size;
+            ota_smif_erase_suspend.state      = OTA_SMIF_ERASE_RUNNING;
+        }
+        /* post-access to SMIF */
+        POST_SMIF_ACCESS_TURN_ON_XIP;
+    }
+    Cy_SysLib_ExitCriticalSection(intr_status);
+
+    while ((cy_smif_result == CY_SMIF_SUCCESS) && busy)
+    {
+        intr_status = Cy_SysLib_EnterCriticalSection();
+        {
+            /* pre-access to SMIF */
+            PRE_SMIF_ACCESS_TURN_OFF_XIP;
+            if (ota_smif_erase_suspend.state == OTA_SMIF_ERASE_SUSPENDED)
+            {
+                cy_smif_result = ota_smif_erase_resume_now();
+            }
+
+            busy = Cy_SMIF_MemIsBusy(SMIF0, mem_cfg, &ota_QSPI_context);
+#ifdef CY_XIP_SMIF_MODE_CHANGE
+            {
+                /* window_us covers the resume to suspend interval */
+                uint32_t polled_us = 0u;
+
+                while (busy && (polled_us < window_us))
+                {
+                    Cy_SysLib_DelayUs(CY_OTA_SMIF_SUSPEND_POLL_US);
+                    polled_us       += CY_OTA_SMIF_SUSPEND_POLL_US;
+                    poll.elapsed_us += CY_OTA_SMIF_SUSPEND_POLL_US;
+                    busy = Cy_SMIF_MemIsBusy(SMIF0, mem_cfg, &ota_QSPI_context);
+                }
+            }
+            if (busy && (cy_smif_result == CY_SMIF_SUCCESS))
+            {
+                /* Let XIP fetch from the memory until the next window */
+                cy_smif_result = ota_smif_erase_suspend_now();
+            }
+#endif
+            if (!busy)
+            {
+                ota_smif_erase_suspend.state = OTA_SMIF_ERASE_IDLE;
+            }
+            /* post-access to SMIF */
+            POST_SMIF_ACCESS_TURN_ON_XIP;
+        }
+        Cy_SysLib_ExitCriticalSection(intr_status);
+
+        if (busy && (poll.elapsed_us >= timeout_us))
+        {
+            cy_smif_result = CY_SMIF_EXCEED_TIMEOUT;
+        }
+#ifndef CY_XIP_SMIF_MODE_CHANGE
+        else if (busy)
+        {
+            ota_smif_delay_us(ota_smif_poll_next_delay(&poll), true);
+        }
+#endif
+    }
+
+    if (cy_smif_result != CY_SMIF_SUCCESS)
+    {
+        ota_smif_erase_suspend.state = OTA_SMIF_ERASE_IDLE;
+    }
+    else
+    {
+        ota_smif_poll_done(&poll);
+    }
+
+    return cy_smif_result;
+}
+#endif /* CY_OTA_SMIF_ERASE_SUSPEND */
+
+#if !defined (CY_XIP_SMIF_MODE_CHANGE) || defined (CY_OTA_SMIF_ERASE_PLANNER)
+/*
+ * Erase one sector with the erase command issued directly, cmd NULL for the one of the memory
+ * configuration. Sleeps between status polls, with XIP mode switching it is called with XIP off
+ * and spins instead.
+ */
+static cy_en_smif_status_t ota_smif_erase_sector(uint32_t addr, cy_stc_smif_mem_cmd_t const *cmd, ota_smif_op_t op)
+{
+    cy_stc_smif_mem_config_t *mem_cfg = smifBlockConfig.memConfig[MEM_SLOT];
+    cy_en_smif_status_t cy_smif_result;
+    uint8_t addr_array[CY_OTA_SMIF_MAX_ADDR_LEN];
+
+    ota_smif_addr_to_array(addr, addr_array, mem_cfg->deviceCfg->numOfAddrBytes);
+
+    cy_smif_result = Cy_SMIF_MemCmdWriteEnable(SMIF0, mem_cfg, &ota_QSPI_context);
+    if (cy_smif_result == CY_SMIF_SUCCESS)
+    {
+        cy_smif_result = ota_smif_cmd_erase(mem_cfg, cmd, addr_array);
+    }
+    if (cy_smif_result == CY_SMIF_SUCCESS)
+    {
+#ifdef CY_XIP_SMIF_MODE_CHANGE
+        cy_smif_result = ota_smif_wait_ready(mem_cfg, op, false);
+#else
+        cy_smif_result = ota_smif_wait_ready(mem_cfg, op, true);
+#endif
+    }
+
+    return cy_smif_result;
+}
+#endif /* !CY_XIP_SMIF_MODE_CHANGE || CY_OTA_SMIF_ERASE_PLANNER */
+
+/*
+ * Program external flash. With XIP mode switching the data is written in whole program pages,
+ * ota_smif_pages_per_xip_window() of them per XIP-off window.
+ */
+static cy_en_smif_status_t ota_smif_write(uint32_t addr, uint8_t const *data, size_t len)
+{
+    cy_en_smif_status_t cy_smif_result = CY_SMIF_SUCCESS;
+
+#ifdef CY_XIP_SMIF_MODE_CHANGE
+    cy_stc_smif_mem_device_cfg_t const *device_cfg = smifBlockConfig.memConfig[MEM_SLOT]->deviceCfg;
+    uint32_t window_size = device_cfg->programSize * ota_smif_pages_per_xip_window(device_cfg);
+
+    while ((len > 0u) && (cy_smif_result == CY_SMIF_SUCCESS))
+    {
+        size_t chunk_size = len;
+
+        /* End each window on a program page boundary */
+        if (window_size != 0u)
+        {
+            chunk_size = window_size - (addr % device_cfg->programSize);
+            if (chunk_size > len)
+            {
+                chunk_size = len;
+            }
+        }
+
+        /* pre-access to SMIF */
+        PRE_SMIF_ACCESS_TURN_OFF_XIP;
+        Cy_SMIF_SetReadyPollingDelay((uint16_t)ota_smif_poll_step_us(OTA_SMIF_OP_PROGRAM), &ota_QSPI_context);
+        cy_smif_result = Cy_SMIF_MemWrite(SMIF0, smifBlockConfig.memConfig[MEM_SLOT], addr, data, chunk_size, &ota_QSPI_context);
+        Cy_SMIF_SetReadyPollingDelay(0, &ota_QSPI_context);
+        /* post-access to SMIF */
+        POST_SMIF_ACCESS_TURN_ON_XIP;
+
+        addr += chunk_size;
+        data += chunk_size;
+        len  -= chunk_size;
+    }
+#else
+    /* Cy_SMIF_MemWrite() programs page by page, a partial first or last page is programmed as is */
+    Cy_SMIF_SetReadyPollingDelay((uint16_t)ota_smif_poll_step_us(OTA_SMIF_OP_PROGRAM), &ota_QSPI_context);
+    cy_smif_result = Cy_SMIF_MemWrite(SMIF0, smifBlockConfig.memConfig[MEM_SLOT], addr, data, len, &ota_QSPI_context);
+    Cy_SMIF_SetReadyPollingDelay(0, &ota_QSPI_context);
+#endif
+
+    return cy_smif_result;
+}
+
+#ifdef ENABLE_ON_THE_FLY_ENCRYPTION
+/*
+ * Plain text of the AES block at addr. Through XIP the block is decrypted on the fly, read
+ * over SMIF it is decrypted with the same key stream used to encrypt it.
+ */
+static cy_en_smif_status_t ota_smif_encrypt_load_block(uint32_t addr, uint8_t *block)
+{
+    cy_en_smif_status_t cy_smif_result = CY_SMIF_SUCCESS;
+
+#ifdef CY_OTA_DIRECT_XIP
+    memcpy(block, (void const *)cy_flash_addr_to_cbus_addr(addr), CY_OTA_SMIF_ENCRYPT_BLOCK_SIZE);
+#else
+    /* pre-access to SMIF */
+    PRE_SMIF_ACCESS_TURN_OFF_XIP;
+    cy_smif_result = Cy_SMIF_MemRead(SMIF0, smifBlockConfig.memConfig[MEM_SLOT],
+            addr, block, CY_OTA_SMIF_ENCRYPT_BLOCK_SIZE, &ota_QSPI_context);
+    if (cy_smif_result == CY_SMIF_SUCCESS)
+    {
+        cy_smif_result = Cy_SMIF_Encrypt(SMIF0, cy_flash_addr_to_cbus_addr(addr), block,
+                CY_OTA_SMIF_ENCRYPT_BLOCK_SIZE, &ota_QSPI_context);
+    }
+    /* post-access to SMIF */
+    POST_SMIF_ACCESS_TURN_ON_XIP;
+#endif
+
+    return cy_smif_result;
+}
+
+/*
+ * Encrypt and program external flash. The range is widened to whole AES blocks, the plain
+ * text of partly written blocks is read back, so rows are only read back at the range edges.
+ * Bytes outside the range are programmed with the cipher text already stored there (erased
+ * bytes stay erased), which leaves them unchanged.
+ */
+static cy_en_smif_status_t ota_smif_encrypt_write(uint32_t addr, uint8_t const *data, size_t len)
+{
+    cy_en_smif_status_t cy_smif_result = CY_SMIF_SUCCESS;
+    uint32_t end_addr   = addr + len;
+    uint32_t block_addr = addr - (addr % CY_OTA_SMIF_ENCRYPT_BLOCK_SIZE);
+
+    while ((block_addr < end_addr) && (cy_smif_result == CY_SMIF_SUCCESS))
+    {
+        uint32_t offset    = (addr > block_addr) ? (addr - block_addr) : 0u;
+        uint32_t chunk_end = end_addr;
+        uint32_t fill_size;
+
+        if ((chunk_end - block_addr) > CY_OTA_SMIF_ENCRYPT_BUFFER_SIZE)
+        {
+            chunk_end = block_addr + CY_OTA_SMIF_ENCRYPT_BUFFER_SIZE;
+        }
+        fill_size = ((chunk_end - block_addr) + (CY_OTA_SMIF_ENCRYPT_BLOCK_SIZE - 1u)) &
+                    ~(CY_OTA_SMIF_ENCRYPT_BLOCK_SIZE - 1u);
+
+        /* Partly written first and last AES block */
+        if (offset != 0u)
+        {
+            cy_smif_result = ota_smif_encrypt_load_block(block_addr, &ota_smif_encrypt_buffer[0]);
+        }
+        if ((cy_smif_result == CY_SMIF_SUCCESS) && ((block_addr + fill_size) != chunk_end) &&
+            ((offset == 0u) || (fill_size > CY_OTA_SMIF_ENCRYPT_BLOCK_SIZE)))
+        {
+            cy_smif_result = ota_smif_encrypt_load_block(block_addr + fill_size - CY_OTA_SMIF_ENCRYPT_BLOCK_SIZE,
+                    &ota_smif_encrypt_buffer[fill_size - CY_OTA_SMIF_ENCRYPT_BLOCK_SIZE]);
+        }
+        if (cy_smif_result != CY_SMIF_SUCCESS)
+        {
+            break;
+        }
+
+        memcpy(&ota_smif_encrypt_buffer[offset], data, (chunk_end - block_addr) - offset);
+
+        /* pre-access to SMIF */
+        PRE_SMIF_ACCESS_TURN_OFF_XIP;
+        cy_smif_result = Cy_SMIF_Encrypt(SMIF0, cy_flash_addr_to_cbus_addr(block_addr),
+                ota_smif_encrypt_buffer, fill_size, &ota_QSPI_context);
+        /* post-access to SMIF */
+        POST_SMIF_ACCESS_TURN_ON_XIP;
+
+        if (cy_smif_result == CY_SMIF_SUCCESS)
+        {
+            cy_smif_result = ota_smif_write(block_addr, ota_smif_encrypt_buffer, fill_size);
+        }
+
+        data       += (chunk_end - block_addr) - offset;
+        block_addr += fill_size;
+    }
+
+    return cy_smif_result;
+}
+#endif /* ENABLE_ON_THE_FLY_ENCRYPTION */
+
+#ifdef CY_OTA_SMIF_SESSION
+/* Program operation queued in a session */
+typedef struct
+{
+    uint32_t        addr;
+    uint8_t const   *data;
+    size_t          len;
+} ota_smif_session_run_t;
+
+typedef struct
+{
+    uint32_t                depth;      /* Nesting of cy_ota_mem_session_begin() */
+    uint32_t                used;       /* Bytes of ota_smif_session_buffer in use */
+    uint32_t                run_count;
+    ota_smif_session_run_t  runs[CY_OTA_SMIF_SESSION_MAX_RUNS];
+} ota_smif_session_t;
+
+static ota_smif_session_t ota_smif_session;
+static uint8_t ota_smif_session_buffer[CY_OTA_SMIF_SESSION_BUFFER_SIZE];
+
+/*
+ * Program the queued operations, ota_smif_pages_per_xip_window() program pages of them
+ * per XIP-off window. A window is not closed at the end of an operation, so small operations share it.
+ */
+static cy_en_smif_status_t ota_smif_session_flush(void)
+{
+    cy_stc_smif_mem_device_cfg_t const *device_cfg = smifBlockConfig.memConfig[MEM_SLOT]->deviceCfg;
+    uint32_t window_pages = ota_smif_pages_per_xip_window(device_cfg);
+    cy_en_smif_status_t cy_smif_result = CY_SMIF_SUCCESS;
+    uint32_t run_index = 0u;
+    uint32_t run_done  = 0u;    /* Bytes of the current operation already programmed */
+
+    while ((run_index < ota_smif_session.run_count) && (cy_smif_result == CY_SMIF_SUCCESS))
+    {
+        uint32_t pages = 0u;
+
+        /* pre-access to SMIF */
+        PRE_SMIF_ACCESS_TURN_OFF_XIP;
+        Cy_SMIF_SetReadyPollingDelay((uint16_t)ota_smif_poll_step_us(OTA_SMIF_OP_PROGRAM), &ota_QSPI_context);
+        while ((pages < window_pages) && (run_index < ota_smif_session.run_count) && (cy_smif_result == CY_SMIF_SUCCESS))
+        {
+            ota_smif_session_run_t const *run = &ota_smif_session.runs[run_index];
+            uint32_t addr = run->addr + run_done;
+            size_t   chunk_size = device_cfg->programSize - (addr % device_cfg->programSize);
+
+            if (chunk_size > (run->len - run_done))
+            {
+                chunk_size = run->len - run_done;
+            }
+            cy_smif_result = Cy_SMIF_MemWrite(SMIF0, smifBlockConfig.memConfig[MEM_SLOT], addr,
+                                              &run->data[run_done], chunk_size, &ota_QSPI_context);
+            pages++;
+            run_done += chunk_size;
+            if (run_done == run->len)
+            {
+                run_index++;
+                run_done = 0u;
+            }
+        }
+        Cy_SMIF_SetReadyPollingDelay(0, &ota_QSPI_context);
+        /* post-access to SMIF */
+        POST_SMIF_ACCESS_TURN_ON_XIP;
+    }
+
+    ota_smif_session.run_count = 0u;
+    ota_smif_session.used      = 0u;
+    return cy_smif_result;
+}
+
+/*
+ * Program in a session: small operations are copied and queued, an operation that does not fit
+ * is programmed right away together with the queued ones.
+ */
+static cy_en_smif_status_t ota_smif_session_write(uint32_t addr, uint8_t const *data, size_t len)
+{
+    ota_smif_session_run_t *last = NULL;
+    cy_en_smif_status_t cy_smif_result = CY_SMIF_SUCCESS;
+
+    if (ota_smif_session.run_count > 0u)
+    {
+        last = &ota_smif_session.runs[ota_smif_session.run_count - 1u];
+    }
+
+    if (len > (CY_OTA_SMIF_SESSION_BUFFER_SIZE - ota_smif_session.used))
+    {
+        if (ota_smif_session.run_count == CY_OTA_SMIF_SESSION_MAX_RUNS)
+        {
+            cy_smif_result = ota_smif_session_flush();
+        }
+        if (cy_smif_result == CY_SMIF_SUCCESS)
+        {
+            ota_smif_session.runs[ota_smif_session.run_count].addr = addr;
+            ota_smif_session.runs[ota_smif_session.run_count].data = data;
+            ota_smif_session.runs[ota_smif_session.run_count].len  = len;
+            ota_smif_session.run_count++;
+            cy_smif_result = ota_smif_session_flush();
+        }
+        return cy_smif_result;
+    }
+
+    /* Extend the last operation when the new one continues it, in flash and in the buffer */
+    if ((last != NULL) && ((last->addr + last->len) == addr) &&
+        (&last->data[last->len] == &ota_smif_session_buffer[ota_smif_session.used]))
+    {
+        last->len += len;
+    }
+    else
+    {
+        if (ota_smif_session.run_count == CY_OTA_SMIF_SESSION_MAX_RUNS)
+        {
+            cy_smif_result = ota_smif_session_flush();
+            if (cy_smif_result != CY_SMIF_SUCCESS)
+            {
+                return cy_smif_result;
+            }
+        }
+        ota_smif_session.runs[ota_smif_session.run_count].addr = addr;
+        ota_smif_session.runs[ota_smif_session.run_count].data = &ota_smif_session_buffer[ota_smif_session.used];
+        ota_smif_session.runs[ota_smif_session.run_count].len  = len;
+        ota_smif_session.run_count++;
+    }
+    memcpy(&ota_smif_session_buffer[ota_smif_session.used], data, len);
+    ota_smif_session.used += len;
+
+    return cy_smif_result;
+}
+
+/* Program the queued operations before the memory is accessed otherwise */
+static cy_en_smif_status_t ota_smif_session_sync(void)
+{
+    if (ota_smif_session.run_count == 0u)
+    {
+        return CY_SMIF_SUCCESS;
+    }
+    return ota_smif_session_flush();
+}
+#endif /* CY_OTA_SMIF_SESSION */
+
+#ifdef CY_OTA_SMIF_ERASE_PLANNER
+/*
+ * Erase external flash with the commands planned by ota_smif_erase_plan_step(), addr and len
+ * are aligned to ota_smif_erase_granularity(). With CY_OTA_SMIF_ERASE_SUSPEND each command
+ * can be suspended. Otherwise, with XIP mode switching, as many commands as fit in
+ * CY_OTA_SMIF_XIP_OFF_MAX_US (at least one) are issued per XIP-off window.
+ */
+static cy_en_smif_status_t ota_smif_erase(uint32_t addr, size_t len)
+{
+    cy_en_smif_status_t cy_smif_result = CY_SMIF_SUCCESS;
+    uint32_t end_addr = addr + len;
+    ota_smif_erase_step_t step;
+
+    ota_smif_erase_stats.estimated_us = ota_smif_erase_estimate_us(addr, end_addr);
+    ota_smif_erase_stats.actual_us    = 0u;
+    ota_smif_erase_stats.commands     = 0u;
+
+    while ((addr < end_addr) && (cy_smif_result == CY_SMIF_SUCCESS))
+    {
+#ifdef CY_OTA_SMIF_ERASE_SUSPEND
+        if (ota_smif_erase_suspend.supported)
+        {
+            if (!ota_smif_erase_plan_step(addr, end_addr, &step))
+            {
+                return CY_SMIF_BAD_PARAM;
+            }
+            cy_smif_result = ota_smif_erase_sector_suspendable(addr, step.size, step.cmd, step.op);
+            ota_smif_erase_stats.commands++;
+            addr += step.size;
+            continue;
+        }
+#endif
+#ifdef CY_XIP_SMIF_MODE_CHANGE
+        {
+            uint32_t window_us = 0u;
+
+            /* pre-access to SMIF */
+            PRE_SMIF_ACCESS_TURN_OFF_XIP;
+            while ((addr < end_addr) && (cy_smif_result == CY_SMIF_SUCCESS))
+            {
+                if (!ota_smif_erase_plan_step(addr, end_addr, &step))
+                {
+                    cy_smif_result = CY_SMIF_BAD_PARAM;
+                    break;
+                }
+                if ((window_us != 0u) && ((window_us + step.max_us) > CY_OTA_SMIF_XIP_OFF_MAX_US))
+                {
+                    break;
+                }
+                cy_smif_result = ota_smif_erase_sector(addr, step.cmd, step.op);
+                ota_smif_erase_stats.commands++;
+                window_us += step.max_us;
+                addr      += step.size;
+            }
+            /* post-access to SMIF */
+            POST_SMIF_ACCESS_TURN_ON_XIP;
+        }
+#else
+        if (!ota_smif_erase_plan_step(addr, end_addr, &step))
+        {
+            return CY_SMIF_BAD_PARAM;
+        }
+        cy_smif_result = ota_smif_erase_sector(addr, step.cmd, step.op);
+        ota_smif_erase_stats.commands++;
+        addr += step.size;
+#endif
+    }
+
+    return cy_smif_result;
+}
+#else
+/*
+ * Erase external flash, addr and len are aligned to the erase sector size. With XIP mode
+ * switching only as many sectors as fit in CY_OTA_SMIF_XIP_OFF_MAX_US are erased per
+ * XIP-off window. Otherwise uniform sectors are erased one at a time with adaptive status
+ * polling, and with CY_OTA_SMIF_ERASE_SUSPEND so the erase can be suspended.
+ */
+static cy_en_smif_status_t ota_smif_erase(uint32_t addr, size_t len)
+{
+    cy_en_smif_status_t cy_smif_result = CY_SMIF_SUCCESS;
+
+    while ((len > 0u) && (cy_smif_result == CY_SMIF_SUCCESS))
+    {
+        uint32_t erase_size;
+        uint32_t erase_time_ms;
+        uint32_t region_end;
+        size_t   chunk_size;
+        bool     hybrid;
+
+        hybrid = ota_smif_get_erase_region(addr, &erase_size, &erase_time_ms, &region_end, NULL);
+
+        /* The erase command of hybrid regions differs from the device erase command */
+        if (!hybrid && (erase_size != 0u) && (erase_size <= len))
+        {
+#ifdef CY_OTA_SMIF_ERASE_SUSPEND
+            if (ota_smif_erase_suspend.supported)
+            {
+                cy_smif_result = ota_smif_erase_sector_suspendable(addr, erase_size, NULL, OTA_SMIF_OP_ERASE);
+                addr += erase_size;
+                len  -= erase_size;
+                continue;
+            }
+#endif
+#ifndef CY_XIP_SMIF_MODE_CHANGE
+            cy_smif_result = ota_smif_erase_sector(addr, NULL, OTA_SMIF_OP_ERASE);
+            addr += erase_size;
+            len  -= erase_size;
+            continue;
+#endif
+        }
+
+#ifdef CY_XIP_SMIF_MODE_CHANGE
+        chunk_size = erase_size * ota_smif_steps_per_xip_window(erase_time_ms * 1000u);
+#else
+        (void)erase_time_ms;
+        chunk_size = erase_size;
+#endif
+        /* Do not cross into a hybrid region with a different sector size */
+        if ((region_end > addr) && (chunk_size > (region_end - addr)))
+        {
+            chunk_size = region_end - addr;
+        }
+        if ((chunk_size == 0u) || (chunk_size > len))
+        {
+            chunk_size = len;
+        }
+
+        /* pre-access to SMIF */
+        PRE_SMIF_ACCESS_TURN_OFF_XIP;
+        Cy_SMIF_SetReadyPollingDelay((uint16_t)ota_smif_poll_step_us(OTA_SMIF_OP_ERASE), &ota_QSPI_context);
+        cy_smif_result = Cy_SMIF_MemEraseSector(SMIF0, smifBlockConfig.memConfig[MEM_SLOT], addr, chunk_size, &ota_QSPI_context);
+        Cy_SMIF_SetReadyPollingDelay(0, &ota_QSPI_context);
+        /* post-access to SMIF */
+        POST_SMIF_ACCESS_TURN_ON_XIP;
+
+        addr += chunk_size;
+        len  -= chunk_size;
+    }
+
+    return cy_smif_result;
+}
+#endif /* CY_OTA_SMIF_ERASE_PLANNER */
+#endif /* CY_IP_MXSMIF & !XMC7100 & !XMC7200 */
+
+/**********************************************************************************************************************************
+ * External Functions
+ **********************************************************************************************************************************/
+/**
+ * @brief Initializes flash, QSPI flash, or any other external memory type
+ *
+ * @return  CY_RSLT_SUCCESS on success
+ *          CY_RSLT_TYPE_ERROR on failure
+ */
+cy_rslt_t cy_ota_mem_init( void )
 {
     cy_rslt_t result = CY_RSLT_SUCCESS;
 
@@ -725,6 +2755,7 @@ cy_rslt_t cy_ota_mem_init( void )
 
 #if (defined (CY_MCUBOOT_OTA_IMAGE_VERIFICATION) || defined (CY_OTA_IMAGE_VERIFICATION))
     #include "flash_qspi.h"
+    #include "cy_smif_hybrid_sect.h"
     cy_en_smif_status_t qspi_status = CY_SMIF_SUCCESS;
     qspi_status = qspi_init_sfdp(CY_SS0_SMIF_ID);
     if(CY_SMIF_SUCCESS == qspi_status)
@@ -736,6 +2767,14 @@ cy_rslt_t cy_ota_mem_init( void )
         result = CY_RSLT_TYPE_ERROR;
         goto _bail;
     }
+
+    /* smifBlockConfig was detected with the previous sector architecture, erases would use the wrong sectors */
+    if (qspi_semper_reset_required())
+    {
+        cy_ota_bootloader_abstraction_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "%s() Semper sector architecture changed, reset required\n", __func__);
+        result = CY_RSLT_TYPE_ERROR;
+        goto _bail;
+    }
 #endif
 
 #else /* NON - CYW20829/CYW89829 */
@@ -761,6 +2800,9 @@ cy_rslt_t cy_ota_mem_init( void )
     #endif /* ! CY_RUN_CODE_FROM_XIP */
 #endif /* CYW20829B0LKML/CYW20829B1010/CYW89829B01MKSBG/CYW89829B1232 */
 
+    /* Before the first status register write, which polls with the learned register time */
+    ota_smif_poll_init();
+
     smif_status = IsQuadEnabled(smifMemConfigs[0], &QE_status);
     if(smif_status != CY_RSLT_SUCCESS)
     {
@@ -778,6 +2820,21 @@ cy_rslt_t cy_ota_mem_init( void )
         }
     }
 
+    ota_smif_cache_erase_regions();
+#ifdef CY_OTA_SMIF_FAST_CMDS
+    /* Wide commands need quad mode */
+    if (result == CY_RSLT_SUCCESS)
+    {
+        ota_smif_select_fast_cmds();
+    }
+#endif
+#ifdef CY_OTA_SMIF_ERASE_SUSPEND
+    ota_smif_detect_erase_suspend();
+#endif
+#ifdef CY_OTA_SMIF_ERASE_PLANNER
+    ota_smif_detect_erase_types();
+#endif
+
     SET_FLAG(FLAG_HAL_INIT_DONE);
 
   _bail:
@@ -808,6 +2865,14 @@ cy_rslt_t cy_ota_mem_read( cy_ota_mem_type_t mem_type, uint32_t addr, void *data
     if( mem_type == CY_OTA_MEM_TYPE_INTERNAL_FLASH )
     {
 #if !(defined (CYW20829B0LKML) || defined (CYW20829B1010) || defined (CYW89829B01MKSBG) || defined (CYW89829B1232))
+#ifdef CY_OTA_INTERNAL_FLASH_ASYNC
+        /* Do not read rows which are still being programmed */
+        result = cy_ota_mem_complete();
+        if(result != CY_RSLT_SUCCESS)
+        {
+            return result;
+        }
+#endif
         /* flash_area_read() uses offsets, we need absolute address here */
         addr += CY_FLASH_BASE;
 
@@ -850,6 +2915,13 @@ cy_rslt_t cy_ota_mem_read( cy_ota_mem_type_t mem_type, uint32_t addr, void *data
         return CY_RSLT_TYPE_ERROR;
 #else
         cy_en_smif_status_t cy_smif_result = CY_SMIF_SUCCESS;
+#ifdef CY_OTA_SMIF_SESSION
+        /* Program what the session has queued first */
+        if (ota_smif_session_sync() != CY_SMIF_SUCCESS)
+        {
+            return CY_RSLT_TYPE_ERROR;
+        }
+#endif
         if (addr >= CY_SMIF_BASE_MEM_OFFSET)
         {
             addr -= CY_SMIF_BASE_MEM_OFFSET;
@@ -857,6 +2929,10 @@ cy_rslt_t cy_ota_mem_read( cy_ota_mem_type_t mem_type, uint32_t addr, void *data
 
         if (IS_FLAG_SET(FLAG_HAL_INIT_DONE))
         {
+#ifdef CY_OTA_SMIF_ERASE_SUSPEND
+            /* An erase started by another thread is suspended for the read, or waited for */
+            cy_smif_result = ota_smif_read_during_erase(addr, (uint8_t *)data, len);
+#else
             /* pre-access to SMIF */
             PRE_SMIF_ACCESS_TURN_OFF_XIP;
 
@@ -864,6 +2940,7 @@ cy_rslt_t cy_ota_mem_read( cy_ota_mem_type_t mem_type, uint32_t addr, void *data
                     addr, data, len, &ota_QSPI_context);
             /* post-access to SMIF */
             POST_SMIF_ACCESS_TURN_ON_XIP;
+#endif
         }
         return (cy_smif_result == CY_SMIF_SUCCESS) ? CY_RSLT_SUCCESS : CY_RSLT_TYPE_ERROR;
 #endif
@@ -891,6 +2968,14 @@ static cy_rslt_t cy_ota_mem_write_row_size( cy_ota_mem_type_t mem_type, uint32_t
         addr += CY_FLASH_BASE;
 
 #if defined (XMC7100) || defined (XMC7200)
+#ifdef CY_OTA_INTERNAL_FLASH_ASYNC
+        /* A failed non-blocking operation fails the next blocking one */
+        result = cy_ota_mem_complete();
+        if(result != CY_RSLT_SUCCESS)
+        {
+            return result;
+        }
+#endif
         rc = xmc_internal_flash_write((uint8_t *)data, addr, len);
         if (rc != 0 )
         {
@@ -899,6 +2984,13 @@ static cy_rslt_t cy_ota_mem_write_row_size( cy_ota_mem_type_t mem_type, uint32_t
         }
         return result;
 #else
+#ifdef CY_OTA_INTERNAL_FLASH_ASYNC
+        result = cy_ota_mem_complete();
+        if(result != CY_RSLT_SUCCESS)
+        {
+            return result;
+        }
+#endif
         rc = psoc6_internal_flash_write((uint8_t *)data, addr, len);
         if (rc != 0 )
         {
@@ -917,7 +3009,7 @@ static cy_rslt_t cy_ota_mem_write_row_size( cy_ota_mem_type_t mem_type, uint32_t
     {
 #if (defined (CY_IP_MXSMIF) && !defined (XMC7100) && !defined (XMC7200))
         cy_en_smif_status_t cy_smif_result = CY_SMIF_SUCCESS;
-#ifdef ENABLE_ON_THE_FLY_ENCRYPTION
+#if defined (ENABLE_ON_THE_FLY_ENCRYPTION) && defined (READBACK_SMIF_WRITE_TEST)
         uint32_t cbus_addr = 0;
 #endif
 
@@ -929,38 +3021,22 @@ static cy_rslt_t cy_ota_mem_write_row_size( cy_ota_mem_type_t mem_type, uint32_t
         if (IS_FLAG_SET(FLAG_HAL_INIT_DONE))
         {
 #ifdef ENABLE_ON_THE_FLY_ENCRYPTION
-            cbus_addr = cy_flash_addr_to_cbus_addr(addr);
-            if(ota_allocate_write_buffer(len) != true)
-            {
-                printf("\n%s() - Memory allocation failed at %d\n", __func__, __LINE__);
-                return CY_RSLT_TYPE_ERROR;
-            }
-
-            memcpy(write_buffer, data, len);
-
-            /* pre-access to SMIF */
-            PRE_SMIF_ACCESS_TURN_OFF_XIP;
-
-            /* Encrypt ota_Buffer */
-            cy_smif_result = Cy_SMIF_Encrypt(SMIF0, cbus_addr, write_buffer, len, &ota_QSPI_context);
-
-            /* post-access to SMIF */
-            POST_SMIF_ACCESS_TURN_ON_XIP;
-
-            if(cy_smif_result == CY_SMIF_SUCCESS)
-            {
-                cy_smif_result = Cy_SMIF_MemWrite(SMIF0, smifBlockConfig.memConfig[MEM_SLOT], addr, write_buffer, len, &ota_QSPI_context);
-            }
-
-            ota_free_write_buffer();
+            /* Encrypted in ota_smif_encrypt_buffer, CY_OTA_SMIF_ENCRYPT_BUFFER_SIZE bytes per pass */
+            cy_smif_result = ota_smif_encrypt_write(addr, (uint8_t const *)data, len);
 #else
             if(cy_smif_result == CY_SMIF_SUCCESS)
             {
-                /* pre-access to SMIF */
-                PRE_SMIF_ACCESS_TURN_OFF_XIP;
-                cy_smif_result = Cy_SMIF_MemWrite(SMIF0, smifBlockConfig.memConfig[MEM_SLOT], addr, data, len, &ota_QSPI_context);
-                /* post-access to SMIF */
-                POST_SMIF_ACCESS_TURN_ON_XIP;
+#ifdef CY_OTA_SMIF_SESSION
+                if (ota_smif_session.depth > 0u)
+                {
+                    cy_smif_result = ota_smif_session_write(addr, (uint8_t const *)data, len);
+                }
+                else
+#endif
+                {
+                    /* XIP is turned off per program window inside */
+                    cy_smif_result = ota_smif_write(addr, (uint8_t const *)data, len);
+                }
             }
 #endif
         }
@@ -1065,6 +3141,28 @@ cy_rslt_t cy_ota_mem_write( cy_ota_mem_type_t mem_type, uint32_t addr, void *dat
 #endif
 #endif
 
+#if (defined (CY_IP_MXSMIF) && !defined (XMC7100) && !defined (XMC7200)) && !defined (ENABLE_ON_THE_FLY_ENCRYPTION)
+    /*
+     * External NOR program only clears bits and the slot is erased before it is written, so
+     * the bytes are programmed as they are, split on the program pages (deviceCfg->programSize)
+     * of the memory. Reading the surrounding row back and programming it again would not
+     * change the result.
+     */
+    if((mem_type == CY_OTA_MEM_TYPE_EXTERNAL_FLASH) && (bytes_to_write > 0x0U))
+    {
+        return cy_ota_mem_write_row_size(mem_type, curr_addr, curr_src, bytes_to_write);
+    }
+#elif (defined (CY_IP_MXSMIF) && !defined (XMC7100) && !defined (XMC7200))
+    /*
+     * Encrypted, the whole range is encrypted and programmed in one pass, only the AES blocks
+     * at its edges are read back. Image trailer updates erase first and keep the row path below.
+     */
+    if((mem_type == CY_OTA_MEM_TYPE_EXTERNAL_FLASH) && (len > CY_BOOT_TRAILER_MAX_UPDATE_SIZE))
+    {
+        return cy_ota_mem_write_row_size(mem_type, curr_addr, curr_src, bytes_to_write);
+    }
+#endif
+
     while(bytes_to_write > 0x0U)
     {
         chunk_size = bytes_to_write;
@@ -1175,16 +3273,28 @@ cy_rslt_t cy_ota_mem_erase( cy_ota_mem_type_t mem_type, uint32_t addr, size_t le
         int rc = 0;
 
 #if defined (XMC7100) || defined (XMC7200)
-        int intr_status = 0;
-        intr_status = Cy_SysLib_EnterCriticalSection();
+#ifdef CY_OTA_INTERNAL_FLASH_ASYNC
+        result = cy_ota_mem_complete();
+        if(result != CY_RSLT_SUCCESS)
+        {
+            return result;
+        }
+#endif
+        /* Interrupts are masked per sector inside */
         rc = xmc_internal_flash_erase(addr, len);
-        Cy_SysLib_ExitCriticalSection(intr_status);
         if (rc != 0 )
         {
             printf("xmc_internal_flash_erase(0x%08x, %u) FAILED rc:%d\n", (unsigned int)addr, len, rc);
             result = CY_RSLT_TYPE_ERROR;
         }
 #else
+#ifdef CY_OTA_INTERNAL_FLASH_ASYNC
+        result = cy_ota_mem_complete();
+        if(result != CY_RSLT_SUCCESS)
+        {
+            return result;
+        }
+#endif
         rc = psoc6_internal_flash_erase(addr, len);
         if (rc != 0 )
         {
@@ -1202,6 +3312,13 @@ cy_rslt_t cy_ota_mem_erase( cy_ota_mem_type_t mem_type, uint32_t addr, size_t le
     {
 #if (defined (CY_IP_MXSMIF) && !defined (XMC7100) && !defined (XMC7200))
         cy_en_smif_status_t cy_smif_result = CY_SMIF_SUCCESS;
+#ifdef CY_OTA_SMIF_SESSION
+        /* Program what the session has queued first */
+        if (ota_smif_session_sync() != CY_SMIF_SUCCESS)
+        {
+            return CY_RSLT_TYPE_ERROR;
+        }
+#endif
 
         if (addr >= CY_SMIF_BASE_MEM_OFFSET)
         {
@@ -1210,9 +3327,7 @@ cy_rslt_t cy_ota_mem_erase( cy_ota_mem_type_t mem_type, uint32_t addr, size_t le
 
         if (IS_FLAG_SET(FLAG_HAL_INIT_DONE))
         {
-            /* pre-access to SMIF */
-            PRE_SMIF_ACCESS_TURN_OFF_XIP;
-
+#ifndef CY_XIP_SMIF_MODE_CHANGE
             // If the erase is for the entire chip, use chip erase command
             if ((addr == 0u) && (len == ota_smif_get_memory_size()))
             {
@@ -1221,6 +3336,7 @@ cy_rslt_t cy_ota_mem_erase( cy_ota_mem_type_t mem_type, uint32_t addr, size_t le
                                                     &ota_QSPI_context);
             }
             else
+#endif
             {
                 // Cy_SMIF_MemEraseSector() returns error if (addr + length) > total flash size or if
                 // addr is not aligned to erase sector size or if (addr + length) is not aligned to
@@ -1228,21 +3344,28 @@ cy_rslt_t cy_ota_mem_erase( cy_ota_mem_type_t mem_type, uint32_t addr, size_t le
                 /* Make sure the base offset is correct */
                 uint32_t erase_size;
                 uint32_t diff;
+#ifdef CY_OTA_SMIF_ERASE_PLANNER
+                /* Round both ends to the smallest erase size there, the planner picks larger erases inside */
+                erase_size = ota_smif_erase_granularity(addr);
+                diff = addr & (erase_size - 1);
+                addr -= diff;
+                len += diff;
+                if (len > 0u)
+                {
+                    erase_size = ota_smif_erase_granularity(addr + len - 1u);
+                    len = ((addr + len + (erase_size - 1)) & ~(erase_size - 1)) - addr;
+                }
+#else
                 erase_size = cy_ota_mem_get_erase_size(CY_OTA_MEM_TYPE_EXTERNAL_FLASH, addr);
                 diff = addr & (erase_size - 1);
                 addr -= diff;
                 len += diff;
                 /* Make sure the length is correct */
                 len = (len + (erase_size - 1)) & ~(erase_size - 1);
-                Cy_SMIF_SetReadyPollingDelay(20000, &ota_QSPI_context);
-                cy_smif_result = Cy_SMIF_MemEraseSector(SMIF0,
-                                                      smifBlockConfig.memConfig[MEM_SLOT],
-                                                      addr, len, &ota_QSPI_context);
-                Cy_SMIF_SetReadyPollingDelay(0, &ota_QSPI_context);
+#endif
+                /* XIP is turned off per erase window inside */
+                cy_smif_result = ota_smif_erase(addr, len);
             }
-
-            /* post-access to SMIF */
-            POST_SMIF_ACCESS_TURN_ON_XIP;
         }
         else
         {
@@ -1326,9 +3449,9 @@ size_t cy_ota_mem_get_erase_size ( cy_ota_mem_type_t mem_type, uint32_t addr )
     else if( mem_type == CY_OTA_MEM_TYPE_EXTERNAL_FLASH )
     {
 #if (defined (CY_IP_MXSMIF) && !defined (XMC7100) && !defined (XMC7200))
-        uint32_t                            erase_sector_size = 0;
-        cy_stc_smif_hybrid_region_info_t*   hybrid_info = NULL;
-        cy_en_smif_status_t                 smif_status;
+        uint32_t    erase_sector_size = 0;
+        uint32_t    erase_time_ms;
+        uint32_t    region_end;
 
         if (addr >= CY_SMIF_BASE_MEM_OFFSET)
         {
@@ -1338,17 +3461,8 @@ size_t cy_ota_mem_get_erase_size ( cy_ota_mem_type_t mem_type, uint32_t addr )
         /* pre-access to SMIF is not needed, as we are just reading data from RAM */
         if (IS_FLAG_SET(FLAG_HAL_INIT_DONE))
         {
-            /* Cy_SMIF_MemLocateHybridRegion() does not access the external flash, just data tables from RAM  */
-            smif_status = Cy_SMIF_MemLocateHybridRegion(smifBlockConfig.memConfig[MEM_SLOT], &hybrid_info, addr);
-
-            if (CY_SMIF_SUCCESS != smif_status)
-            {
-                erase_sector_size = (size_t)smifBlockConfig.memConfig[MEM_SLOT]->deviceCfg->eraseSize;
-            }
-            else
-            {
-                erase_sector_size = (size_t)hybrid_info->eraseSize;
-            }
+            /* Geometry cached by cy_ota_mem_init() */
+            (void)ota_smif_get_erase_region(addr, &erase_sector_size, &erase_time_ms, &region_end, NULL);
         }
         /* post-access to SMIF is not needed, as we are just reading data from RAM */
 
@@ -1362,3 +3476,331 @@ size_t cy_ota_mem_get_erase_size ( cy_ota_mem_type_t mem_type, uint32_t addr )
         return 0;
     }
 }
+
+/**
+ * @brief Start a session of memory operations
+ *
+ * With CY_XIP_SMIF_MODE_CHANGE, external flash program operations of a session share the
+ * XIP-off windows (at most CY_OTA_SMIF_XIP_OFF_MAX_US long) instead of each starting its own.
+ * Small writes are queued until the session ends or the memory is read or erased.
+ * Sessions can be nested, other memory types and builds ignore them.
+ *
+ * @param[in]   mem_type   Memory type @ref cy_ota_mem_type_t
+ *
+ * @return  CY_RSLT_SUCCESS
+ */
+cy_rslt_t cy_ota_mem_session_begin( cy_ota_mem_type_t mem_type )
+{
+#ifdef CY_OTA_SMIF_SESSION
+    if(mem_type == CY_OTA_MEM_TYPE_EXTERNAL_FLASH)
+    {
+        ota_smif_session.depth++;
+    }
+#endif
+
+    (void)mem_type;
+    return CY_RSLT_SUCCESS;
+}
+
+/**
+ * @brief End a session of memory operations, programming the queued writes
+ *
+ * @param[in]   mem_type   Memory type @ref cy_ota_mem_type_t
+ *
+ * @return  CY_RSLT_SUCCESS on success
+ *          CY_RSLT_TYPE_ERROR if a queued write failed
+ */
+cy_rslt_t cy_ota_mem_session_end( cy_ota_mem_type_t mem_type )
+{
+#ifdef CY_OTA_SMIF_SESSION
+    if((mem_type == CY_OTA_MEM_TYPE_EXTERNAL_FLASH) && (ota_smif_session.depth > 0u))
+    {
+        ota_smif_session.depth--;
+        if((ota_smif_session.depth == 0u) && (ota_smif_session_sync() != CY_SMIF_SUCCESS))
+        {
+            return CY_RSLT_TYPE_ERROR;
+        }
+    }
+#endif
+
+    (void)mem_type;
+    return CY_RSLT_SUCCESS;
+}
+
+/**
+ * @brief Get the planned and measured time of the last external flash erase
+ *
+ * @param[in]   mem_type   Memory type @ref cy_ota_mem_type_t
+ * @param[out]  stats      Erase statistics @ref cy_ota_mem_erase_stats_t
+ *
+ * @return  CY_RSLT_SUCCESS on success
+ *          CY_RSLT_TYPE_ERROR if erase planning is not used for the memory type
+ */
+cy_rslt_t cy_ota_mem_get_erase_stats( cy_ota_mem_type_t mem_type, cy_ota_mem_erase_stats_t *stats )
+{
+#if (defined (CY_IP_MXSMIF) && !defined (XMC7100) && !defined (XMC7200)) && defined (CY_OTA_SMIF_ERASE_PLANNER)
+    if( mem_type == CY_OTA_MEM_TYPE_EXTERNAL_FLASH )
+    {
+        if (stats == NULL)
+        {
+            return CY_RSLT_SERIAL_FLASH_ERR_BAD_PARAM;
+        }
+
+        *stats = ota_smif_erase_stats;
+        return CY_RSLT_SUCCESS;
+    }
+#endif /* CY_IP_MXSMIF & !XMC7100 & !XMC7200 & CY_OTA_SMIF_ERASE_PLANNER */
+
+    (void)mem_type;
+    (void)stats;
+    return CY_RSLT_TYPE_ERROR;
+}
+
+/**
+ * @brief Get the commands used to read and program a memory type
+ *
+ * @param[in]   mem_type   Memory type @ref cy_ota_mem_type_t
+ * @param[out]  cmds       Commands @ref cy_ota_mem_cmds_t
+ *
+ * @return  CY_RSLT_SUCCESS on success
+ *          CY_RSLT_SERIAL_FLASH_ERR_NOT_INITED if the memory is not initialized
+ *          CY_RSLT_TYPE_ERROR if the memory type is not command based
+ */
+cy_rslt_t cy_ota_mem_get_cmds( cy_ota_mem_type_t mem_type, cy_ota_mem_cmds_t *cmds )
+{
+#if (defined (CY_IP_MXSMIF) && !defined (XMC7100) && !defined (XMC7200))
+    if( mem_type == CY_OTA_MEM_TYPE_EXTERNAL_FLASH )
+    {
+        cy_stc_smif_mem_device_cfg_t const *device_cfg;
+
+        if (cmds == NULL)
+        {
+            return CY_RSLT_SERIAL_FLASH_ERR_BAD_PARAM;
+        }
+        if (!IS_FLAG_SET(FLAG_HAL_INIT_DONE))
+        {
+            return CY_RSLT_SERIAL_FLASH_ERR_NOT_INITED;
+        }
+
+        /* Just reading data from RAM, no access to SMIF */
+        device_cfg = smifBlockConfig.memConfig[MEM_SLOT]->deviceCfg;
+        cmds->read_cmd           = (uint8_t)device_cfg->readCmd->command;
+        cmds->read_addr_width    = (uint8_t)ota_smif_width_lines(device_cfg->readCmd->addrWidth);
+        cmds->read_data_width    = (uint8_t)ota_smif_width_lines(device_cfg->readCmd->dataWidth);
+        cmds->read_dummy_cycles  = (uint8_t)device_cfg->readCmd->dummyCycles;
+        cmds->program_cmd        = (uint8_t)device_cfg->programCmd->command;
+        cmds->program_addr_width = (uint8_t)ota_smif_width_lines(device_cfg->programCmd->addrWidth);
+        cmds->program_data_width = (uint8_t)ota_smif_width_lines(device_cfg->programCmd->dataWidth);
+        return CY_RSLT_SUCCESS;
+    }
+#endif /* CY_IP_MXSMIF & !XMC7100 & !XMC7200 */
+
+    (void)mem_type;
+    (void)cmds;
+    return CY_RSLT_TYPE_ERROR;
+}
+
+/**
+ * @brief Start a non-blocking write to flash, QSPI flash, or any other external memory type
+ *
+ * PSoC 6 and XMC7000 internal flash is programmed row by row with the start/check flash
+ * driver functions when CY_OTA_FLASH_NON_BLOCKING is defined. All other memories complete
+ * the write before returning.
+ *
+ * @param[in]   mem_type   Memory type @ref cy_ota_mem_type_t
+ * @param[in]   addr       Starting address to write to.
+ * @param[in]   data       Pointer to the buffer containing the data to be written.
+ * @param[in]   len        Number of bytes to write.
+ * @param[in]   cb         Completion callback, can be NULL.
+ * @param[in]   cb_arg     Argument passed to the completion callback.
+ *
+ * @return  CY_RSLT_SUCCESS on success
+ *          CY_RSLT_SERIAL_FLASH_ERR_OP_BUSY if another non-blocking operation is in progress
+ *          CY_RSLT_TYPE_ERROR on failure
+ */
+cy_rslt_t cy_ota_mem_write_begin( cy_ota_mem_type_t mem_type, uint32_t addr, void *data, size_t len,
+                                  cy_ota_mem_complete_cb_t cb, void *cb_arg )
+{
+    cy_rslt_t result;
+#ifdef CY_OTA_INTERNAL_FLASH_ASYNC
+    uint32_t intr_status;
+#endif
+
+#ifdef CY_OTA_INTERNAL_FLASH_ASYNC
+    if( mem_type == CY_OTA_MEM_TYPE_INTERNAL_FLASH )
+    {
+        /* flash_area_write() uses offsets, we need absolute address here */
+        if((data == NULL) || ((addr + len) > CY_FLASH_SIZE))
+        {
+            return CY_RSLT_SERIAL_FLASH_ERR_BAD_PARAM;
+        }
+
+        /* cy_ota_mem_poll() may run from another context */
+        intr_status = Cy_SysLib_EnterCriticalSection();
+        if(ota_flash_async.op != OTA_FLASH_ASYNC_IDLE)
+        {
+            Cy_SysLib_ExitCriticalSection(intr_status);
+            return CY_RSLT_SERIAL_FLASH_ERR_OP_BUSY;
+        }
+
+        ota_flash_async.op = OTA_FLASH_ASYNC_WRITE;
+        ota_flash_async.addr = addr + CY_FLASH_BASE;
+        ota_flash_async.src = (const uint8_t *)data;
+        ota_flash_async.remaining = len;
+        ota_flash_async.cb = cb;
+        ota_flash_async.cb_arg = cb_arg;
+
+        return ota_flash_async_kick(intr_status);
+    }
+#endif /* CY_OTA_INTERNAL_FLASH_ASYNC */
+
+    result = cy_ota_mem_write(mem_type, addr, data, len);
+    if(cb != NULL)
+    {
+        cb(result, cb_arg);
+    }
+    return result;
+}
+
+/**
+ * @brief Start a non-blocking erase of flash, QSPI flash, or any other external memory type
+ *
+ * Row aligned ranges of PSoC 6 internal flash are erased with the start/check flash driver
+ * functions, using the largest sector, subsector or row erase that fits each step, when
+ * CY_OTA_FLASH_NON_BLOCKING is defined. All other ranges and
+ * memories complete the erase before returning.
+ *
+ * @param[in]   mem_type   Memory type @ref cy_ota_mem_type_t
+ * @param[in]   addr       Starting address to begin erasing.
+ * @param[in]   len        Number of bytes to erase.
+ * @param[in]   cb         Completion callback, can be NULL.
+ * @param[in]   cb_arg     Argument passed to the completion callback.
+ *
+ * @return  CY_RSLT_SUCCESS on success
+ *          CY_RSLT_SERIAL_FLASH_ERR_OP_BUSY if another non-blocking operation is in progress
+ *          CY_RSLT_TYPE_ERROR on failure
+ */
+cy_rslt_t cy_ota_mem_erase_begin( cy_ota_mem_type_t mem_type, uint32_t addr, size_t len,
+                                  cy_ota_mem_complete_cb_t cb, void *cb_arg )
+{
+    cy_rslt_t result;
+#if defined (CY_OTA_INTERNAL_FLASH_ASYNC) && !(defined (XMC7100) || defined (XMC7200))
+    uint32_t intr_status;
+#endif
+
+#ifdef CY_OTA_INTERNAL_FLASH_ASYNC
+    if( mem_type == CY_OTA_MEM_TYPE_INTERNAL_FLASH )
+    {
+        if(ota_flash_async.op != OTA_FLASH_ASYNC_IDLE)
+        {
+            return CY_RSLT_SERIAL_FLASH_ERR_OP_BUSY;
+        }
+
+        if((addr + len) > CY_FLASH_SIZE)
+        {
+            return CY_RSLT_SERIAL_FLASH_ERR_BAD_PARAM;
+        }
+
+#if !(defined (XMC7100) || defined (XMC7200))
+        /* Unaligned edges need preserve and restore, use the blocking path for those */
+        if(((addr % CY_FLASH_SIZEOF_ROW) == 0u) && ((len % CY_FLASH_SIZEOF_ROW) == 0u))
+        {
+            /* cy_ota_mem_poll() may run from another context */
+            intr_status = Cy_SysLib_EnterCriticalSection();
+            if(ota_flash_async.op != OTA_FLASH_ASYNC_IDLE)
+            {
+                Cy_SysLib_ExitCriticalSection(intr_status);
+                return CY_RSLT_SERIAL_FLASH_ERR_OP_BUSY;
+            }
+
+            ota_flash_async.op = OTA_FLASH_ASYNC_ERASE;
+            ota_flash_async.addr = addr + CY_FLASH_BASE;
+            ota_flash_async.src = NULL;
+            ota_flash_async.remaining = len;
+            ota_flash_async.cb = cb;
+            ota_flash_async.cb_arg = cb_arg;
+
+            return ota_flash_async_kick(intr_status);
+        }
+#endif /* !XMC7100 & !XMC7200 */
+    }
+#endif /* CY_OTA_INTERNAL_FLASH_ASYNC */
+
+    result = cy_ota_mem_erase(mem_type, addr, len);
+    if(cb != NULL)
+    {
+        cb(result, cb_arg);
+    }
+    return result;
+}
+
+/**
+ * @brief Advance the non-blocking memory operation in progress
+ *
+ * @return  CY_RSLT_SUCCESS if no operation is in progress (anymore)
+ *          CY_RSLT_SERIAL_FLASH_ERR_OP_BUSY if the operation is still in progress
+ *          CY_RSLT_TYPE_ERROR if the operation failed
+ */
+cy_rslt_t cy_ota_mem_poll( void )
+{
+#ifdef CY_OTA_INTERNAL_FLASH_ASYNC
+    cy_en_flashdrv_status_t rc;
+    cy_rslt_t result;
+    uint32_t intr_status;
+
+    if(ota_flash_async.op == OTA_FLASH_ASYNC_IDLE)
+    {
+        return CY_RSLT_SUCCESS;
+    }
+
+    /* The application may poll from a timer or another task while the OTA task waits */
+    intr_status = Cy_SysLib_EnterCriticalSection();
+    if(ota_flash_async.op == OTA_FLASH_ASYNC_IDLE)
+    {
+        Cy_SysLib_ExitCriticalSection(intr_status);
+        return CY_RSLT_SUCCESS;
+    }
+
+    rc = Cy_Flash_IsOperationComplete();
+    if(CY_OTA_FLASH_DRV_IS_BUSY(rc))
+    {
+        Cy_SysLib_ExitCriticalSection(intr_status);
+        return CY_RSLT_SERIAL_FLASH_ERR_OP_BUSY;
+    }
+
+    if(rc == CY_FLASH_DRV_SUCCESS)
+    {
+        /* Current row is done, prepare and start the next one */
+        rc = ota_flash_async_start_next();
+        if(rc == CY_FLASH_DRV_OPERATION_STARTED)
+        {
+            Cy_SysLib_ExitCriticalSection(intr_status);
+            return CY_RSLT_SERIAL_FLASH_ERR_OP_BUSY;
+        }
+    }
+
+    result = (rc == CY_FLASH_DRV_SUCCESS) ? CY_RSLT_SUCCESS : CY_RSLT_TYPE_ERROR;
+    ota_flash_async_finish(result, intr_status);
+    return result;
+#else
+    return CY_RSLT_SUCCESS;
+#endif /* CY_OTA_INTERNAL_FLASH_ASYNC */
+}
+
+/**
+ * @brief Wait for the non-blocking memory operation in progress to complete
+ *
+ * @return  CY_RSLT_SUCCESS if no operation is in progress or it completed successfully
+ *          CY_RSLT_TYPE_ERROR if the operation failed
+ */
+cy_rslt_t cy_ota_mem_complete( void )
+{
+    cy_rslt_t result;
+
+    do
+    {
+        result = cy_ota_mem_poll();
+    } while(result == CY_RSLT_SERIAL_FLASH_ERR_OP_BUSY);
+
+    return result;
+}
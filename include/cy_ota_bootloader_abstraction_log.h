@@ -36,7 +36,65 @@
 
 #include "cy_log.h"
 
-#ifdef ENABLE_OTA_BOOTLOADER_ABSTRACTION_LOGS
+#if defined(ENABLE_OTA_BOOTLOADER_ABSTRACTION_DEFERRED_LOGS)
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Records kept in the deferred log ring, must be a power of 2 */
+#ifndef CY_OTA_BOOTLOADER_ABSTRACTION_LOG_RING_SIZE
+#define CY_OTA_BOOTLOADER_ABSTRACTION_LOG_RING_SIZE     (64u)
+#endif
+
+/* Argument words kept per record, further arguments are dropped */
+#ifndef CY_OTA_BOOTLOADER_ABSTRACTION_LOG_MAX_ARGS
+#define CY_OTA_BOOTLOADER_ABSTRACTION_LOG_MAX_ARGS      (6u)
+#endif
+
+/* Bytes per record for copies of %s arguments, longer strings are truncated */
+#ifndef CY_OTA_BOOTLOADER_ABSTRACTION_LOG_STRINGS_SIZE
+#define CY_OTA_BOOTLOADER_ABSTRACTION_LOG_STRINGS_SIZE  (32u)
+#endif
+
+/* Longest message printed by cy_ota_bootloader_abstraction_log_flush(), longer messages are truncated */
+#ifndef CY_OTA_BOOTLOADER_ABSTRACTION_LOG_LINE_SIZE
+#define CY_OTA_BOOTLOADER_ABSTRACTION_LOG_LINE_SIZE     (128u)
+#endif
+
+/*
+ * One deferred log message. The format string address identifies the message,
+ * the arguments are kept as raw 32-bit words in the order of the conversions.
+ * 64-bit and double values take two words, low word first. A %s argument is
+ * copied into strings, its word is the offset of the copy. Arguments from a
+ * conversion that does not fit, %n or long double on are not kept.
+ */
+typedef struct
+{
+    uint32_t    seq;            /* Sequence number of the message */
+    const char  *fmt;           /* Format string */
+    uint8_t     facility;       /* CY_LOG_FACILITY_T of the message */
+    uint8_t     level;          /* CY_LOG_LEVEL_T of the message */
+    uint8_t     arg_count;      /* Argument words used */
+    uint8_t     strings_used;   /* Bytes of strings used */
+    uint32_t    args[CY_OTA_BOOTLOADER_ABSTRACTION_LOG_MAX_ARGS];
+    char        strings[CY_OTA_BOOTLOADER_ABSTRACTION_LOG_STRINGS_SIZE];
+} cy_ota_bootloader_abstraction_log_record_t;
+
+/* Records a message without formatting it. Safe to call from any thread. */
+cy_rslt_t cy_ota_bootloader_abstraction_log_deferred(CY_LOG_FACILITY_T facility, CY_LOG_LEVEL_T level, const char *fmt, ...);
+
+/* Takes the oldest record from the ring, for a host dump or a custom transport. Single reader only. */
+bool cy_ota_bootloader_abstraction_log_read(cy_ota_bootloader_abstraction_log_record_t *record);
+
+/* Formats up to max_records records through cy_log_msg(), typically from a low priority task. Returns the records printed. */
+uint32_t cy_ota_bootloader_abstraction_log_flush(uint32_t max_records);
+
+/* Returns the number of records overwritten before they were read */
+uint32_t cy_ota_bootloader_abstraction_log_dropped(void);
+
+#define cy_ota_bootloader_abstraction_log_msg cy_ota_bootloader_abstraction_log_deferred
+
+#elif defined(ENABLE_OTA_BOOTLOADER_ABSTRACTION_LOGS)
 #define cy_ota_bootloader_abstraction_log_msg cy_log_msg
 #else
 #define cy_ota_bootloader_abstraction_log_msg(a,b,c,...)
@@ -0,0 +1,281 @@
+/*
+ * Copyright 2025, Cypress Semiconductor Corporation (an Infineon company) or
+ * an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+ *
+ * This software, including source code, documentation and related
+ * materials ("Software") is owned by Cypress Semiconductor Corporation
+ * or one of its affiliates ("Cypress") and is protected by and subject to
+ * worldwide patent protection (United States and foreign),
+ * United States copyright laws and international treaty provisions.
+ * Therefore, you may use this Software only as provided in the license
+ * agreement accompanying the software package from which you
+ * obtained this Software ("EULA").
+ * If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+ * non-transferable license to copy, modify, and compile the Software
+ * source code solely for use in connection with Cypress's
+ * integrated circuit products.  Any reproduction, modification, translation,
+ * compilation, or representation of this Software except as specified
+ * above is prohibited without the express written permission of Cypress.
+ *
+ * Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+ * reserves the right to make changes to the Software without notice. Cypress
+ * does not assume any liability arising out of the application or use of the
+ * Software or any product or circuit described in the Software. Cypress does
+ * not authorize its products for use in any products where a malfunction or
+ * failure of the Cypress product may reasonably be expected to result in
+ * significant property damage, injury or death ("High Risk Product"). By
+ * including Cypress's product in a High Risk Product, the manufacturer
+ * of such system or application assumes all risk of such use and in doing
+ * so agrees to indemnify Cypress against all liability.
+ */
+
+/*
+ *  Word-at-a-time buffer scan helpers used by the flash and untar layers.
+ *
+ *  The helpers step byte-wise up to the first word boundary of the scanned
+ *  buffer, then reduce four 32-bit words per iteration with a single branch,
+ *  and finish the tail byte-wise.
+ *
+ *  When the CMSIS compiler header is included before this file, words are
+ *  accessed with __UNALIGNED_UINT32_READ()/__UNALIGNED_UINT32_WRITE() and the
+ *  helpers make no library calls, so RAM resident (CY_SECTION_RAMFUNC) flash
+ *  routines can use them. Otherwise (host builds) words go through memcpy().
+ */
+
+#ifndef CY_OTA_BUFFER_SCAN_H_
+#define CY_OTA_BUFFER_SCAN_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+/***********************************************************************
+ *
+ * Defines
+ *
+ **********************************************************************/
+
+/* Size of the scan word */
+#define CY_OTA_BUFFER_SCAN_WORD_SIZE        (sizeof(uint32_t))
+
+/* Number of bytes reduced per unrolled iteration */
+#define CY_OTA_BUFFER_SCAN_BLOCK_SIZE       (4u * CY_OTA_BUFFER_SCAN_WORD_SIZE)
+
+/* Check if the pointer is aligned to the scan word */
+#define CY_OTA_BUFFER_SCAN_IS_ALIGNED(ptr)  ((((uintptr_t)(ptr)) & (CY_OTA_BUFFER_SCAN_WORD_SIZE - 1u)) == 0u)
+
+/***********************************************************************
+ *
+ * Functions
+ *
+ **********************************************************************/
+
+static inline uint32_t cy_ota_buffer_load_word(const uint8_t *ptr)
+{
+#if defined (__UNALIGNED_UINT32_READ)
+    return __UNALIGNED_UINT32_READ(ptr);
+#else
+    uint32_t word;
+
+    (void)memcpy(&word, ptr, sizeof(word));
+    return word;
+#endif
+}
+
+static inline void cy_ota_buffer_store_word(uint8_t *ptr, uint32_t word)
+{
+#if defined (__UNALIGNED_UINT32_WRITE)
+    __UNALIGNED_UINT32_WRITE(ptr, word);
+#else
+    (void)memcpy(ptr, &word, sizeof(word));
+#endif
+}
+
+/**
+ * @brief Copy a buffer, a word at a time where possible.
+ *
+ * Unlike memcpy() this stays inline, for use from RAM resident code.
+ * The buffers must not overlap.
+ *
+ * @param[out]  dst     Pointer to the destination buffer.
+ * @param[in]   src     Pointer to the source buffer, may be memory mapped flash.
+ * @param[in]   len     Number of bytes to copy.
+ */
+static inline void cy_ota_buffer_copy(void *dst, const void *src, size_t len)
+{
+    uint8_t *ptr_d = (uint8_t *)dst;
+    const uint8_t *ptr_s = (const uint8_t *)src;
+
+    while((len > 0u) && !CY_OTA_BUFFER_SCAN_IS_ALIGNED(ptr_d))
+    {
+        *ptr_d = *ptr_s;
+        ptr_d++;
+        ptr_s++;
+        len--;
+    }
+
+    while(len >= CY_OTA_BUFFER_SCAN_WORD_SIZE)
+    {
+        cy_ota_buffer_store_word(ptr_d, cy_ota_buffer_load_word(ptr_s));
+        ptr_d += CY_OTA_BUFFER_SCAN_WORD_SIZE;
+        ptr_s += CY_OTA_BUFFER_SCAN_WORD_SIZE;
+        len   -= CY_OTA_BUFFER_SCAN_WORD_SIZE;
+    }
+
+    while(len > 0u)
+    {
+        *ptr_d = *ptr_s;
+        ptr_d++;
+        ptr_s++;
+        len--;
+    }
+}
+
+/**
+ * @brief Check if every byte of a buffer holds the same value.
+ *
+ * @param[in]   buffer  Pointer to the buffer to check.
+ * @param[in]   fill    Expected byte value.
+ * @param[in]   len     Number of bytes to check.
+ *
+ * @return  true if all len bytes equal fill (or len is 0), false otherwise.
+ */
+static inline bool cy_ota_buffer_is_filled(const void *buffer, uint8_t fill, size_t len)
+{
+    const uint8_t *ptr = (const uint8_t *)buffer;
+    uint32_t pattern = (uint32_t)fill * 0x01010101UL;
+    uint32_t diff;
+
+    while((len > 0u) && !CY_OTA_BUFFER_SCAN_IS_ALIGNED(ptr))
+    {
+        if(*ptr != fill)
+        {
+            return false;
+        }
+        ptr++;
+        len--;
+    }
+
+    while(len >= CY_OTA_BUFFER_SCAN_BLOCK_SIZE)
+    {
+        diff  = cy_ota_buffer_load_word(&ptr[0])  ^ pattern;
+        diff |= cy_ota_buffer_load_word(&ptr[4])  ^ pattern;
+        diff |= cy_ota_buffer_load_word(&ptr[8])  ^ pattern;
+        diff |= cy_ota_buffer_load_word(&ptr[12]) ^ pattern;
+        if(diff != 0u)
+        {
+            return false;
+        }
+        ptr += CY_OTA_BUFFER_SCAN_BLOCK_SIZE;
+        len -= CY_OTA_BUFFER_SCAN_BLOCK_SIZE;
+    }
+
+    while(len >= CY_OTA_BUFFER_SCAN_WORD_SIZE)
+    {
+        if(cy_ota_buffer_load_word(ptr) != pattern)
+        {
+            return false;
+        }
+        ptr += CY_OTA_BUFFER_SCAN_WORD_SIZE;
+        len -= CY_OTA_BUFFER_SCAN_WORD_SIZE;
+    }
+
+    while(len > 0u)
+    {
+        if(*ptr != fill)
+        {
+            return false;
+        }
+        ptr++;
+        len--;
+    }
+
+    return true;
+}
+
+/**
+ * @brief Check if every byte of a buffer is zero.
+ *
+ * @param[in]   buffer  Pointer to the buffer to check.
+ * @param[in]   len     Number of bytes to check.
+ *
+ * @return  true if all len bytes are zero (or len is 0), false otherwise.
+ */
+static inline bool cy_ota_buffer_is_zero(const void *buffer, size_t len)
+{
+    return cy_ota_buffer_is_filled(buffer, 0x00u, len);
+}
+
+/**
+ * @brief Check if two buffers differ.
+ *
+ * Either buffer may be memory mapped flash. Only equality is reported, the
+ * position of the first difference is not.
+ *
+ * @param[in]   buf_a   Pointer to the first buffer.
+ * @param[in]   buf_b   Pointer to the second buffer.
+ * @param[in]   len     Number of bytes to compare.
+ *
+ * @return  true if at least one byte differs, false if the buffers are equal.
+ */
+static inline bool cy_ota_buffer_differs(const void *buf_a, const void *buf_b, size_t len)
+{
+    const uint8_t *ptr_a = (const uint8_t *)buf_a;
+    const uint8_t *ptr_b = (const uint8_t *)buf_b;
+    uint32_t diff;
+
+    while((len > 0u) && !CY_OTA_BUFFER_SCAN_IS_ALIGNED(ptr_a))
+    {
+        if(*ptr_a != *ptr_b)
+        {
+            return true;
+        }
+        ptr_a++;
+        ptr_b++;
+        len--;
+    }
+
+    while(len >= CY_OTA_BUFFER_SCAN_BLOCK_SIZE)
+    {
+        diff  = cy_ota_buffer_load_word(&ptr_a[0])  ^ cy_ota_buffer_load_word(&ptr_b[0]);
+        diff |= cy_ota_buffer_load_word(&ptr_a[4])  ^ cy_ota_buffer_load_word(&ptr_b[4]);
+        diff |= cy_ota_buffer_load_word(&ptr_a[8])  ^ cy_ota_buffer_load_word(&ptr_b[8]);
+        diff |= cy_ota_buffer_load_word(&ptr_a[12]) ^ cy_ota_buffer_load_word(&ptr_b[12]);
+        if(diff != 0u)
+        {
+            return true;
+        }
+        ptr_a += CY_OTA_BUFFER_SCAN_BLOCK_SIZE;
+        ptr_b += CY_OTA_BUFFER_SCAN_BLOCK_SIZE;
+        len   -= CY_OTA_BUFFER_SCAN_BLOCK_SIZE;
+    }
+
+    while(len >= CY_OTA_BUFFER_SCAN_WORD_SIZE)
+    {
+        if(cy_ota_buffer_load_word(ptr_a) != cy_ota_buffer_load_word(ptr_b))
+        {
+            return true;
+        }
+        ptr_a += CY_OTA_BUFFER_SCAN_WORD_SIZE;
+        ptr_b += CY_OTA_BUFFER_SCAN_WORD_SIZE;
+        len   -= CY_OTA_BUFFER_SCAN_WORD_SIZE;
+    }
+
+    while(len > 0u)
+    {
+        if(*ptr_a != *ptr_b)
+        {
+            return true;
+        }
+        ptr_a++;
+        ptr_b++;
+        len--;
+    }
+
+    return false;
+}
+
+#endif /* CY_OTA_BUFFER_SCAN_H_ */
@@ -612,6 +612,11 @@ ifeq ($(CY_XIP_SMIF_MODE_CHANGE),1)
     DEFINES+=CY_XIP_SMIF_MODE_CHANGE=1
 endif
 
+# Set by flashmap.py for an external flash with "hybrid" parameter sectors
+ifeq ($(USE_HYBRID_SECTORS),1)
+    DEFINES+=CY_OTA_SEMPER_HYBRID_SECTORS
+endif
+
 ifeq ($(CY_OTA_IMAGE_VERIFICATION), 1)
     USE_SWAP_STATUS ?=1
     USE_SHARED_SLOT ?=0
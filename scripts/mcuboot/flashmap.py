@@ -135,10 +135,14 @@ flashDict = {
     'S25HS256T': {
         'flashSize': 0x2000000,  # 256 Mbits
         'eraseSize': 0x40000,  # Uniform Sector Architecture
+        'paramSize': 0x20000,  # 32 4K-byte parameter sectors (hybrid)
+        'paramEraseSize': 0x1000,
     },
     'S25HS512T': {
         'flashSize': 0x4000000,  # 512 Mbits
         'eraseSize': 0x40000,  # Uniform Sector Architecture
+        'paramSize': 0x20000,  # 32 4K-byte parameter sectors (hybrid)
+        'paramEraseSize': 0x1000,
     },
     'S25FL512S': {
         'flashSize': 0x4000000,  # 512 Mbits
@@ -147,6 +151,8 @@ flashDict = {
     'S25HS01GT': {
         'flashSize': 0x8000000,  # 1 Gbit
         'eraseSize': 0x40000,  # Uniform Sector Architecture
+        'paramSize': 0x20000,  # 32 4K-byte parameter sectors (hybrid)
+        'paramEraseSize': 0x1000,
     }
 }
 
@@ -162,6 +168,34 @@ def is_overlap(fa1off, fa1size, fa2off, fa2size, align):
     return fa1off < fa2end and fa2off < fa1end
 
 
+def get_flash_regions(flash, hybrid):
+    """Erase regions of SPI Flash IC as (offset, size, erase size).
+    Hybrid sector parts overlay the bottom or top sector with 4K-byte
+    parameter sectors, the rest of that sector is erased as one sector"""
+    flash_size = flash['flashSize']
+    erase_size = flash['eraseSize']
+    if hybrid is None:
+        return [(0, flash_size, erase_size)]
+    param_size = flash.get('paramSize')
+    if param_size is None:
+        print('Hybrid sectors are not supported by the SPI Flash IC',
+              file=sys.stderr)
+        sys.exit(3)
+    param_erase_size = flash['paramEraseSize']
+    rest_size = erase_size - param_size
+    if str(hybrid).lower() == 'bottom':
+        return [(0, param_size, param_erase_size),
+                (param_size, rest_size, rest_size),
+                (erase_size, flash_size - erase_size, erase_size)]
+    if str(hybrid).lower() == 'top':
+        return [(0, flash_size - erase_size, erase_size),
+                (flash_size - erase_size, rest_size, rest_size),
+                (flash_size - param_size, param_size, param_erase_size)]
+    print("Malformed JSON: 'hybrid' must be 'bottom' or 'top'",
+          file=sys.stderr)
+    sys.exit(3)
+
+
 def is_same_mem(fa1addr, fa2addr):
     """Check if two addresses belong to the same memory"""
     if fa1addr is None or fa2addr is None:
@@ -244,6 +278,27 @@ class AreaList:
         """Calculate image trailer size"""
         return self.get_min_erase_size()
 
+    def is_hybrid(self):
+        """Check if the SPI Flash IC has sectors of different sizes"""
+        return self.flash is not None and len(self.flash['regions']) > 1
+
+    def get_ext_erase_size(self, fa_off):
+        """Erase size of the external flash sector at offset fa_off"""
+        for reg_off, reg_size, reg_erase_size in self.flash['regions']:
+            if reg_off <= fa_off < reg_off + reg_size:
+                return reg_erase_size
+        return self.flash['eraseSize']
+
+    def get_ext_sectors(self, fa_off, fa_size):
+        """Start, end and number of external flash sectors of an area"""
+        start = fa_off - fa_off % self.get_ext_erase_size(fa_off)
+        end = start
+        count = 0
+        while end < fa_off + fa_size:
+            end += self.get_ext_erase_size(end)
+            count += 1
+        return start, end, count
+
     def process_int_area(self, title, fa_addr, fa_size,
                          img_trailer_size, shared_slot):
         """Process internal flash area"""
@@ -296,6 +351,11 @@ class AreaList:
             print('Misfitting', title, file=sys.stderr)
             sys.exit(7)
         if img_trailer_size is not None:
+            # Trailer is the last sector of the slot
+            if self.is_hybrid():
+                img_trailer_size = self.get_ext_erase_size(fa_off + fa_size - 1)
+            erase_size = self.get_ext_erase_size(fa_off + fa_size -
+                                                 img_trailer_size)
             if self.use_overwrite:
                 if shared_slot:
                     print('Shared slot', title,
@@ -304,8 +364,7 @@ class AreaList:
                     sys.exit(7)
             else:
                 # Check trailer alignment (start at the sector boundary)
-                align = (fa_off + fa_size - img_trailer_size) % \
-                        self.flash['eraseSize']
+                align = (fa_off + fa_size - img_trailer_size) % erase_size
                 if align != 0:
                     peer_addr = self.peers.get(fa_addr)
                     if shared_slot:
@@ -319,11 +378,11 @@ class AreaList:
                             print('Misaligned', title, file=sys.stderr)
                             sys.exit(7)
                     elif is_same_mem(fa_addr, peer_addr) and \
-                            fa_addr % self.flash['eraseSize'] == \
-                            peer_addr % self.flash['eraseSize']:
+                            fa_addr % erase_size == \
+                            peer_addr % erase_size:
                         pass  # postpone checking
                     else:
-                        fa_addr += self.flash['eraseSize'] - align
+                        fa_addr += erase_size - align
                         if fa_addr + fa_size <= \
                                 self.plat['smifAddr'] + self.flash['flashSize']:
                             print('Misaligned', title,
@@ -334,12 +393,10 @@ class AreaList:
                         sys.exit(7)
         else:
             # Check alignment (flash area should start at the sector boundary)
-            if fa_off % self.flash['eraseSize'] != 0:
+            if fa_off % self.get_ext_erase_size(fa_off) != 0:
                 print('Misaligned', title, file=sys.stderr)
                 sys.exit(7)
-        slot_sectors = int((fa_off % self.flash['eraseSize'] +
-                            fa_size + self.flash['eraseSize'] - 1) //
-                           self.flash['eraseSize'])
+        slot_sectors = self.get_ext_sectors(fa_off, fa_size)[2]
         self.external_flash = True
         if self.flash['XIP']:
             self.external_flash_xip = True
@@ -380,7 +437,7 @@ class AreaList:
             # External flash
             fa_device_id, fa_off, slot_sectors = self.process_ext_area(
                 title, fa_addr, fa_size, img_trailer_size, shared_slot)
-            align = self.flash['eraseSize']
+            align = None if self.is_hybrid() else self.flash['eraseSize']
         else:
             print('Invalid', title, file=sys.stderr)
             # [stde] More interesting output
@@ -411,9 +468,16 @@ class AreaList:
         # shared slot
         for area in self.areas:
             if fa_device_id == area['fa_device_id']:
-                over = is_overlap(fa_off, fa_size,
-                                  area['fa_off'], area['fa_size'],
-                                  align)
+                if align is None:
+                    # External flash with sectors of different sizes
+                    fa_start, fa_end, _ = self.get_ext_sectors(fa_off, fa_size)
+                    area_start, area_end, _ = self.get_ext_sectors(
+                        area['fa_off'], area['fa_size'])
+                    over = fa_start < area_end and area_start < fa_end
+                else:
+                    over = is_overlap(fa_off, fa_size,
+                                      area['fa_off'], area['fa_size'],
+                                      align)
                 if shared_slot and area['shared_slot']:
                     if not over:  # images in shared slot should overlap
                         print(title, 'is not shared with', area['title'],
@@ -597,6 +661,7 @@ def process_json(in_file):
         flash = flash[0]
         model = flash.get('model')
         mode = flash.get('mode')
+        hybrid = flash.get('hybrid')
         if model is not None:
             try:
                 flash = flashDict[model]
@@ -617,6 +682,7 @@ def process_json(in_file):
                       file=sys.stderr)
                 sys.exit(3)
         flash.update({'XIP': str(mode).upper() == 'XIP'})
+        flash.update({'regions': get_flash_regions(flash, hybrid)})
     return flash_map['boot_and_upgrade'], flash
 
 
@@ -866,6 +932,8 @@ def main():
         print('USE_EXTERNAL_FLASH := 1')
         if area_list.external_flash_xip:
             print('USE_XIP := 1')
+        if area_list.is_hybrid():
+            print('USE_HYBRID_SECTORS := 1')
     if shared_slot:
         print('USE_SHARED_SLOT := 1')
     if service_app is not None:
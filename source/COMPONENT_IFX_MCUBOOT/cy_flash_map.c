@@ -78,6 +78,7 @@
 #include "cy_ota_api.h"
 #include "cy_ota_bootloader_abstraction_log.h"
 #include "cy_ota_flash.h"
+#include "cy_ota_buffer_scan.h"
 /* This header file will get generated during building depending on flashmap choosen. */
 #include "cy_flash_map.h"
 
@@ -117,6 +118,9 @@
 static uint8_t row_buff[PLATFORM_MAX_TRAILER_PAGE_SIZE];
 #endif
 
+/* Bumped by every write or erase issued through this backend */
+static uint32_t cy_flash_area_write_gen;
+
 /* This is not actually used by mcuboot's code but can be used by apps
  * when attempting to read/write a trailer.
     struct image_trailer {
@@ -157,6 +161,9 @@ struct cy_mcuboot_swap_state
 /* size of the boot_image_magic in mcuboot slot */
 #define CY_IFX_MCUBOOT_MAGIC_SZ   (sizeof(boot_img_magic))
 
+/* swap_info, copy_done, image_ok and magic, the contiguous end of the trailer */
+#define CY_IFX_MCUBOOT_TRAILER_TAIL_SZ   ((3u * BOOT_TRAILER_ALIGN) + CY_IFX_MCUBOOT_MAGIC_SZ)
+
 uint8_t cy_flash_area_erased_val(const struct flash_area *fap);
 
 /* Define DEBUG_PRINT_OPEN_AREA to print flash area info when area is opened */
@@ -281,6 +288,12 @@ int8_t cy_flash_area_read(const struct flash_area *fa, uint32_t off, void *dst,
     return 0;
 }
 
+/*< Returns a counter that changes whenever flash is written or erased through this backend */
+uint32_t cy_flash_area_get_write_gen(void)
+{
+    return cy_flash_area_write_gen;
+}
+
 /*< Writes `len` bytes of flash memory at `off` from the buffer at `src` */
 int8_t cy_flash_area_write(const struct flash_area *fa, uint32_t off, const void *src, uint32_t len)
 {
@@ -293,6 +306,8 @@ int8_t cy_flash_area_write(const struct flash_area *fa, uint32_t off, const void
         return CY_IFX_MCUBOOT_ERR_BADARGS;
     }
 
+    cy_flash_area_write_gen++;
+
     /* Add base of flash area and offset within the flash area */
 #ifndef COMPONENT_PSE84
     addr = fa->fa_off + off;
@@ -335,6 +350,8 @@ int8_t cy_flash_area_erase(const struct flash_area *fa, uint32_t off, uint32_t l
         return CY_IFX_MCUBOOT_ERR_BADARGS;
     }
 
+    cy_flash_area_write_gen++;
+
     /* Add base of flash area and offset within the flash area */
 #ifndef PSE84
     if (off + len > fa->fa_size)
@@ -491,22 +508,12 @@ int8_t cy_boot_write_magic(const struct flash_area *fap)
 
 bool cy_bootutil_buffer_is_filled(const void *buffer, uint8_t fill, size_t len)
 {
-    uint8_t *p;
-
     if(buffer == NULL || len == 0)
     {
         return false;
     }
 
-    for(p = (uint8_t *)buffer; len-- > 0; p++)
-    {
-        if(*p != fill)
-        {
-            return false;
-        }
-    }
-
-    return true;
+    return cy_ota_buffer_is_filled(buffer, fill, len);
 }
 
 bool cy_bootutil_buffer_is_erased(const struct flash_area *area,
@@ -542,6 +549,16 @@ static int boot_magic_decode(const uint8_t *magic)
     return CY_IFX_MCUBOOT_MAGIC_BAD;
 }
 
+/* Decode a trailer flag byte as read from flash */
+static uint8_t boot_flag_from_flash(const struct flash_area *fap, uint8_t flag)
+{
+    if(flag == cy_flash_area_erased_val(fap))
+    {
+        return CY_IFX_MCUBOOT_FLAG_UNSET;
+    }
+    return (uint8_t)boot_flag_decode(flag);
+}
+
 static int8_t boot_read_flag(const struct flash_area *fap, uint8_t *flag, uint32_t off)
 {
     int8_t rc;
@@ -551,14 +568,7 @@ static int8_t boot_read_flag(const struct flash_area *fap, uint8_t *flag, uint32
     {
         return CY_IFX_MCUBOOT_ERR_FLASH;
     }
-    if(*flag == cy_flash_area_erased_val(fap))
-    {
-        *flag = CY_IFX_MCUBOOT_FLAG_UNSET;
-    }
-    else
-    {
-        *flag = boot_flag_decode(*flag);
-    }
+    *flag = boot_flag_from_flash(fap, *flag);
 
     return 0;
 }
@@ -568,11 +578,6 @@ int cy_boot_read_image_ok(const struct flash_area *fap, uint8_t *image_ok)
     return boot_read_flag(fap, image_ok, boot_image_ok_off(fap));
 }
 
-static inline int boot_read_copy_done(const struct flash_area *fap, uint8_t *copy_done)
-{
-    return boot_read_flag(fap, copy_done, boot_copy_done_off(fap));
-}
-
 int8_t cy_boot_write_image_ok(const struct flash_area *fap)
 {
     uint32_t off;
@@ -614,6 +619,59 @@ int8_t cy_boot_write_swap_info(const struct flash_area *fap, uint8_t swap_type,
     return 0;
 }
 
+/**
+ * Program the end of the image trailer (swap_info, copy_done, image_ok and magic) with one write.
+ * The current contents are read once and the new fields are composed in RAM, the other bytes
+ * are written back unchanged. Nothing is written when the trailer already holds these values.
+ *
+ * @param fap               Flash area of the slot
+ * @param image_ok          Set the image_ok flag
+ * @param set_swap_info     Write swap_info
+ * @param swap_info         swap_info value, see BOOT_SET_SWAP_INFO()
+ *
+ * @return                  0 on success; nonzero on failure.
+ */
+static int8_t cy_boot_write_trailer_tail(const struct flash_area *fap, bool image_ok, bool set_swap_info, uint8_t swap_info)
+{
+    uint8_t tail[CY_IFX_MCUBOOT_TRAILER_TAIL_SZ];
+    uint8_t current[CY_IFX_MCUBOOT_TRAILER_TAIL_SZ];
+    uint32_t off;
+    int8_t rc;
+
+    off = boot_swap_info_off(fap);
+    rc = cy_flash_area_read(fap, off, current, sizeof(current));
+    if(rc != 0)
+    {
+        return CY_IFX_MCUBOOT_ERR_FLASH;
+    }
+    memcpy(tail, current, sizeof(tail));
+
+    /* boot_img_magic may be stored in external flash for XIP builds, it is copied to RAM here */
+    memcpy(&tail[boot_magic_off(fap) - off], &(boot_img_magic[0]), CY_IFX_MCUBOOT_MAGIC_SZ);
+    if(image_ok)
+    {
+        tail[boot_image_ok_off(fap) - off] = CY_IFX_MCUBOOT_FLAG_SET;
+    }
+    if(set_swap_info)
+    {
+        tail[boot_swap_info_off(fap) - off] = swap_info;
+    }
+
+    if(memcmp(tail, current, sizeof(tail)) == 0)
+    {
+        return 0;
+    }
+
+    rc = cy_flash_area_write(fap, off, tail, sizeof(tail));
+    cy_ota_bootloader_abstraction_log_msg(CYLF_MIDDLEWARE, CY_LOG_DEBUG, "%s() fap->off 0x%lx off 0x%lx rc %d\n", __func__, fap->fa_off, off, rc);
+    if(rc != 0)
+    {
+        return CY_IFX_MCUBOOT_ERR_FLASH;
+    }
+
+    return 0;
+}
+
 /**
  * Marks the image in the secondary slot as pending.  On the next reboot,
  * the system will perform a one-time boot of the the secondary slot image.
@@ -629,43 +687,31 @@ int8_t cy_flash_area_boot_set_pending(uint8_t image, uint8_t permanent)
 {
     const struct flash_area *fap;
     int8_t rc = 0;
+    bool image_ok = false;
+    bool set_swap_info = false;
+    uint8_t swap_info = 0;
 
     rc = cy_flash_area_open(CY_FLASH_AREA_IMAGE_SECONDARY(image-1), &fap);
 
     if(rc == 0)
     {
-        rc = cy_boot_write_magic(fap);
-        cy_ota_bootloader_abstraction_log_msg(CYLF_MIDDLEWARE, CY_LOG_DEBUG, "%s() cy_boot_write_magic(fap) returned %d\n", __func__, rc);
-
         /*
          * Writing trailer flags doesn't work properly for internal flash. That's OK
          * because writing the magic does work and that's enough to trigger the update.
          */
         if( (fap->fa_device_id & CY_FLASH_DEVICE_EXTERNAL_FLAG) == CY_FLASH_DEVICE_EXTERNAL_FLAG)
         {
-            if((rc == 0) && permanent)
-            {
-                rc = cy_boot_write_image_ok(fap);
-                cy_ota_bootloader_abstraction_log_msg(CYLF_MIDDLEWARE, CY_LOG_DEBUG, "%s() cy_boot_write_image_ok(fap) returned %d\n", __func__, rc);
-            }
+            image_ok = (permanent != 0u);
 #if(CY_ENC_IMG != 1)
-            uint8_t swap_type = 0;
-            if(rc == 0)
-            {
-                if(permanent)
-                {
-                    swap_type = CY_IFX_MCUBOOT_SWAP_TYPE_PERM;
-                }
-                else
-                {
-                    swap_type = CY_IFX_MCUBOOT_SWAP_TYPE_TEST;
-                }
-                 rc = cy_boot_write_swap_info(fap, swap_type, image-1);
-                cy_ota_bootloader_abstraction_log_msg(CYLF_MIDDLEWARE, CY_LOG_DEBUG, "%s() cy_boot_write_swap_info(fap) returned %d\n", __func__, rc);
-            }
+            set_swap_info = true;
+            BOOT_SET_SWAP_INFO(swap_info, image-1, (permanent != 0u) ? CY_IFX_MCUBOOT_SWAP_TYPE_PERM : CY_IFX_MCUBOOT_SWAP_TYPE_TEST);
 #endif
         }
 
+        /* Magic, image_ok and swap_info in one program operation */
+        rc = cy_boot_write_trailer_tail(fap, image_ok, set_swap_info, swap_info);
+        cy_ota_bootloader_abstraction_log_msg(CYLF_MIDDLEWARE, CY_LOG_DEBUG, "%s() cy_boot_write_trailer_tail(fap) returned %d\n", __func__, rc);
+
         cy_flash_area_close(fap);
     }
 
@@ -709,20 +755,21 @@ int8_t cy_flash_area_boot_unset_pending(uint8_t image)
 
 int cy_boot_read_swap_state(const struct flash_area *fap, struct cy_mcuboot_swap_state *state)
 {
-    uint8_t magic[CY_IFX_MCUBOOT_MAGIC_SZ];
+    uint8_t tail[CY_IFX_MCUBOOT_TRAILER_TAIL_SZ];
+    uint8_t *magic;
     uint32_t off;
     uint8_t swap_info;
     int rc;
 
-    memset(&magic, 0x00, CY_IFX_MCUBOOT_MAGIC_SZ);
-
-    off = boot_magic_off(fap);
-    rc = cy_flash_area_read(fap, off, magic, CY_IFX_MCUBOOT_MAGIC_SZ);
+    /* One flash read for the whole trailer end, the fields are decoded from RAM */
+    off = boot_swap_info_off(fap);
+    rc = cy_flash_area_read(fap, off, tail, sizeof(tail));
     if(rc != 0)
     {
         return CY_IFX_MCUBOOT_ERR_FLASH;
     }
 
+    magic = &tail[boot_magic_off(fap) - off];
     if(cy_bootutil_buffer_is_erased(fap, magic, CY_IFX_MCUBOOT_MAGIC_SZ))
     {
         state->magic = CY_IFX_MCUBOOT_MAGIC_UNSET;
@@ -732,12 +779,7 @@ int cy_boot_read_swap_state(const struct flash_area *fap, struct cy_mcuboot_swap
         state->magic = boot_magic_decode(magic);
     }
 
-    off = boot_swap_info_off(fap);
-    rc = cy_flash_area_read(fap, off, &swap_info, sizeof swap_info);
-    if(rc != 0)
-    {
-        return CY_IFX_MCUBOOT_ERR_FLASH;
-    }
+    swap_info = tail[boot_swap_info_off(fap) - off];
 
     /* Extract the swap type and image number */
     state->swap_type = BOOT_GET_SWAP_TYPE(swap_info);
@@ -750,13 +792,139 @@ int cy_boot_read_swap_state(const struct flash_area *fap, struct cy_mcuboot_swap
         state->image_num = 0;
     }
 
-    rc = boot_read_copy_done(fap, &state->copy_done);
-    if (rc != 0)
+    state->copy_done = boot_flag_from_flash(fap, tail[boot_copy_done_off(fap) - off]);
+    state->image_ok  = boot_flag_from_flash(fap, tail[boot_image_ok_off(fap) - off]);
+
+    return 0;
+}
+
+/*
+ * The commit journal of a multi-image update is kept in the padding of the copy_done field of
+ * the first secondary slot trailer. MCUboot only reads the first byte of the field. The bytes
+ * are erased with the slot when a download starts, and then only have bits cleared.
+ */
+#define CY_BOOT_JOURNAL_MAGIC           (0xA5u)
+#define CY_BOOT_JOURNAL_OPEN            (0x3Cu)
+#define CY_BOOT_JOURNAL_CLOSED          (0x0Cu)     /* CY_BOOT_JOURNAL_OPEN with bits cleared */
+
+#define CY_BOOT_JOURNAL_MAGIC_IDX       (1u)
+#define CY_BOOT_JOURNAL_IMAGES_IDX      (2u)
+#define CY_BOOT_JOURNAL_CHECK_IDX       (3u)        /* ~images */
+#define CY_BOOT_JOURNAL_PERMANENT_IDX   (4u)
+#define CY_BOOT_JOURNAL_STATE_IDX       (5u)
+#define CY_BOOT_JOURNAL_TODO_IDX        (6u)        /* Bit cleared once the trailer of the image is written */
+
+/**
+ * Reads the commit journal and which of its images still have a pending trailer.
+ *
+ * @param journal           Journal read
+ *
+ * @return                  0 on success; CY_IFX_MCUBOOT_ERR_BADSTATUS when there is no journal.
+ */
+int8_t cy_flash_area_boot_read_journal(cy_flash_area_boot_journal_t *journal)
+{
+    const struct flash_area *fap;
+    struct cy_mcuboot_swap_state state;
+    uint8_t field[BOOT_TRAILER_ALIGN];
+    uint8_t image;
+    int8_t rc;
+
+    if(journal == NULL)
+    {
+        return CY_IFX_MCUBOOT_ERR_BADARGS;
+    }
+    memset(journal, 0x00, sizeof(*journal));
+
+    if(cy_flash_area_open(CY_FLASH_AREA_IMAGE_SECONDARY(0), &fap) != 0)
+    {
+        return CY_IFX_MCUBOOT_ERR_FLASH;
+    }
+    rc = cy_flash_area_read(fap, boot_copy_done_off(fap), field, sizeof(field));
+    cy_flash_area_close(fap);
+    if(rc != 0)
     {
         return CY_IFX_MCUBOOT_ERR_FLASH;
     }
 
-    return cy_boot_read_image_ok(fap, &state->image_ok);
+    if((field[CY_BOOT_JOURNAL_MAGIC_IDX] != CY_BOOT_JOURNAL_MAGIC) ||
+       ((uint8_t)(field[CY_BOOT_JOURNAL_IMAGES_IDX] ^ field[CY_BOOT_JOURNAL_CHECK_IDX]) != 0xFFu) ||
+       ((field[CY_BOOT_JOURNAL_STATE_IDX] != CY_BOOT_JOURNAL_OPEN) && (field[CY_BOOT_JOURNAL_STATE_IDX] != CY_BOOT_JOURNAL_CLOSED)))
+    {
+        return CY_IFX_MCUBOOT_ERR_BADSTATUS;
+    }
+
+    journal->images    = field[CY_BOOT_JOURNAL_IMAGES_IDX];
+    journal->committed = journal->images & (uint8_t)~field[CY_BOOT_JOURNAL_TODO_IDX];
+    journal->permanent = field[CY_BOOT_JOURNAL_PERMANENT_IDX];
+    journal->open      = (field[CY_BOOT_JOURNAL_STATE_IDX] == CY_BOOT_JOURNAL_OPEN) ? 1u : 0u;
+
+    for(image = 0; image < CY_IFX_MCUBOOT_IMAGE_NUMBER; image++)
+    {
+        if(((journal->images & (1u << image)) != 0u) && (cy_flash_area_open(CY_FLASH_AREA_IMAGE_SECONDARY(image), &fap) == 0))
+        {
+            if((cy_boot_read_swap_state(fap, &state) == 0) && (state.magic == CY_IFX_MCUBOOT_MAGIC_GOOD))
+            {
+                journal->pending |= (uint8_t)(1u << image);
+            }
+            cy_flash_area_close(fap);
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * Writes the commit journal. Until the slot is erased again, images can only be added to
+ * committed and a closed journal cannot be opened, the write is read back to check this.
+ *
+ * @param journal           Journal to write, pending is not stored
+ *
+ * @return                  0 on success; nonzero on failure.
+ */
+int8_t cy_flash_area_boot_write_journal(const cy_flash_area_boot_journal_t *journal)
+{
+    const struct flash_area *fap;
+    uint8_t field[BOOT_TRAILER_ALIGN];
+    uint8_t current[BOOT_TRAILER_ALIGN];
+    uint32_t off;
+    int8_t rc;
+
+    if(journal == NULL)
+    {
+        return CY_IFX_MCUBOOT_ERR_BADARGS;
+    }
+    if(cy_flash_area_open(CY_FLASH_AREA_IMAGE_SECONDARY(0), &fap) != 0)
+    {
+        return CY_IFX_MCUBOOT_ERR_FLASH;
+    }
+
+    off = boot_copy_done_off(fap);
+    rc = cy_flash_area_read(fap, off, current, sizeof(current));
+    if(rc == 0)
+    {
+        /* The copy_done flag itself is kept */
+        memcpy(field, current, sizeof(field));
+        field[CY_BOOT_JOURNAL_MAGIC_IDX]     = CY_BOOT_JOURNAL_MAGIC;
+        field[CY_BOOT_JOURNAL_IMAGES_IDX]    = journal->images;
+        field[CY_BOOT_JOURNAL_CHECK_IDX]     = (uint8_t)~journal->images;
+        field[CY_BOOT_JOURNAL_PERMANENT_IDX] = journal->permanent;
+        field[CY_BOOT_JOURNAL_STATE_IDX]     = (journal->open != 0u) ? CY_BOOT_JOURNAL_OPEN : CY_BOOT_JOURNAL_CLOSED;
+        field[CY_BOOT_JOURNAL_TODO_IDX]      = (uint8_t)~journal->committed;
+
+        if(memcmp(field, current, sizeof(field)) != 0)
+        {
+            rc = cy_flash_area_write(fap, off, field, sizeof(field));
+            if((rc == 0) &&
+               ((cy_flash_area_read(fap, off, current, sizeof(current)) != 0) || (memcmp(field, current, sizeof(field)) != 0)))
+            {
+                rc = CY_IFX_MCUBOOT_ERR_FLASH;
+            }
+        }
+    }
+    cy_flash_area_close(fap);
+
+    cy_ota_bootloader_abstraction_log_msg(CYLF_MIDDLEWARE, CY_LOG_DEBUG, "%s() images 0x%x committed 0x%x open %d rc %d\n", __func__, journal->images, journal->committed, journal->open, rc);
+    return (rc == 0) ? 0 : CY_IFX_MCUBOOT_ERR_FLASH;
 }
 
 /**
@@ -847,3 +1015,42 @@ int8_t cy_flash_area_boot_get_image_confirm_status(uint8_t image, uint8_t *image
 
     return rc;
 }
+
+/**
+ * Reads the trailer status of one slot of an image. Magic, swap type and
+ * flags all come from a single read of the trailer end.
+ *
+ * @param image             Image number, as for cy_flash_area_boot_get_pending_status().
+ * @param slot              0 for the primary slot, 1 for the secondary slot.
+ * @param status            Decoded trailer fields.
+ *
+ * @return                  0 on success; nonzero on failure.
+ */
+int8_t cy_flash_area_boot_get_trailer_status(uint8_t image, uint8_t slot, cy_flash_area_trailer_status_t *status)
+{
+    const struct flash_area *fap;
+    struct cy_mcuboot_swap_state state = {0};
+    int8_t rc = 0;
+
+    if((status == NULL) || (slot > 1U))
+    {
+        return CY_IFX_MCUBOOT_ERR_BADARGS;
+    }
+
+    rc = cy_flash_area_open((slot == 0U) ? CY_FLASH_AREA_IMAGE_PRIMARY(image-1) : CY_FLASH_AREA_IMAGE_SECONDARY(image-1), &fap);
+    if(rc == 0)
+    {
+        rc = (int8_t)cy_boot_read_swap_state(fap, &state);
+        cy_ota_bootloader_abstraction_log_msg(CYLF_MIDDLEWARE, CY_LOG_DEBUG, "%s() cy_boot_read_swap_state() returned %d\n", __func__, rc);
+        if(rc == 0)
+        {
+            status->magic     = state.magic;
+            status->swap_type = state.swap_type;
+            status->copy_done = state.copy_done;
+            status->image_ok  = state.image_ok;
+        }
+        cy_flash_area_close(fap);
+    }
+
+    return rc;
+}
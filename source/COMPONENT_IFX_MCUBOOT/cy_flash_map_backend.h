@@ -396,6 +396,15 @@ typedef struct image_boot_config_s
     uint32_t size;
 } image_boot_config_t;
 
+/* Decoded end of one image trailer */
+typedef struct cy_flash_area_trailer_status
+{
+    uint8_t magic;      /* One of the CY_IFX_MCUBOOT_MAGIC_[...] values. */
+    uint8_t swap_type;  /* One of the CY_IFX_MCUBOOT_SWAP_TYPE_[...] values. */
+    uint8_t copy_done;  /* One of the CY_IFX_MCUBOOT_FLAG_[...] values. */
+    uint8_t image_ok;   /* One of the CY_IFX_MCUBOOT_FLAG_[...] values. */
+} cy_flash_area_trailer_status_t;
+
 /*< Opens the area for use. id is one of the `fa_id`s */
 int8_t cy_flash_area_open(uint8_t id, const struct flash_area **fa);
 
@@ -411,6 +420,9 @@ int8_t cy_flash_area_write(const struct flash_area *fa, uint32_t off, const void
 /*< Erases `len` bytes of flash memory at `off` */
 int8_t cy_flash_area_erase(const struct flash_area *fa, uint32_t off, uint32_t len);
 
+/*< Returns a counter that changes whenever flash is written or erased through this backend */
+uint32_t cy_flash_area_get_write_gen(void);
+
 /* writes MAGIC, OK and swap_type */
 int8_t cy_flash_area_boot_set_pending(uint8_t image, uint8_t permanent);
 
@@ -426,4 +438,26 @@ int8_t cy_flash_area_boot_get_image_confirm_status(uint8_t image, uint8_t *image
 /* Removes the Boot Magic of the image in the secondary slot. */
 int8_t cy_flash_area_boot_unset_pending(uint8_t image);
 
+/*
+ * Commit journal of a multi-image update, kept in the first secondary slot trailer.
+ * Bit n of each mask stands for image n + 1.
+ */
+typedef struct cy_flash_area_boot_journal
+{
+    uint8_t images;     /* Images of the update */
+    uint8_t committed;  /* Images whose trailer has been written */
+    uint8_t pending;    /* Images whose secondary slot trailer is pending, read only */
+    uint8_t permanent;  /* permanent value of the trailers */
+    uint8_t open;       /* Nonzero until every trailer is written, or the written ones are cleared */
+} cy_flash_area_boot_journal_t;
+
+/* Reads the commit journal, fails with BADSTATUS when the first secondary slot has none */
+int8_t cy_flash_area_boot_read_journal(cy_flash_area_boot_journal_t *journal);
+
+/* Writes the commit journal */
+int8_t cy_flash_area_boot_write_journal(const cy_flash_area_boot_journal_t *journal);
+
+/* Reads magic, swap_type, copy_done and image_ok of one slot with a single trailer read */
+int8_t cy_flash_area_boot_get_trailer_status(uint8_t image, uint8_t slot, cy_flash_area_trailer_status_t *status);
+
 #endif /* __FLASH_MAP_BACKEND_H__ */
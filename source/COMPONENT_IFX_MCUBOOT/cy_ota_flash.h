@@ -72,6 +72,10 @@
 /** Read abort failed. QSPI block is busy. */
 #define CY_RSLT_SERIAL_FLASH_ERR_QSPI_BUSY   (cy_rslt_t)(CY_RSLT_CREATE(CY_RSLT_TYPE_ERROR, CY_RSLT_MODULE_BOARD_LIB_SERIAL_FLASH, 6))
 #endif
+#ifndef CY_RSLT_SERIAL_FLASH_ERR_OP_BUSY
+/** A previously started non-blocking operation is not yet complete */
+#define CY_RSLT_SERIAL_FLASH_ERR_OP_BUSY     (cy_rslt_t)(CY_RSLT_CREATE(CY_RSLT_TYPE_ERROR, CY_RSLT_MODULE_BOARD_LIB_SERIAL_FLASH, 7))
+#endif
 /** \} group_ota_macros */
 
 
@@ -91,6 +95,16 @@ typedef enum
     CY_OTA_MEM_TYPE_NONE                     /**<  Default value.           */
 } cy_ota_mem_type_t;
 
+/**
+ * @brief Completion callback of the non-blocking memory operations.
+ *
+ * Called from cy_ota_mem_poll() or cy_ota_mem_complete() once the whole operation has finished.
+ *
+ * @param[in]   result     CY_RSLT_SUCCESS if the operation completed successfully, error code otherwise.
+ * @param[in]   cb_arg     Argument passed to cy_ota_mem_write_begin() or cy_ota_mem_erase_begin().
+ */
+typedef void (*cy_ota_mem_complete_cb_t)(cy_rslt_t result, void *cb_arg);
+
 /** \} group_ota_typedefs */
 
 /***********************************************************************
@@ -183,6 +197,69 @@ size_t cy_ota_mem_get_prog_size(cy_ota_mem_type_t mem_type, uint32_t addr);
  */
 size_t cy_ota_mem_get_erase_size(cy_ota_mem_type_t mem_type, uint32_t addr);
 
+/**
+ * @brief Start a non-blocking write to flash, QSPI flash, or any other external memory type
+ *
+ * The operation is advanced by cy_ota_mem_poll() or cy_ota_mem_complete(). The data buffer
+ * must stay valid until the completion callback is called. Only one non-blocking operation
+ * can be in progress at a time. Backends without non-blocking support complete the write
+ * before returning and call the callback from this function. Blocking memory operations
+ * wait for the non-blocking operation in progress to complete first.
+ *
+ * @param[in]   mem_type   Memory type @ref cy_ota_mem_type_t
+ * @param[in]   addr       Starting address to write to.
+ * @param[in]   data       Pointer to the buffer containing the data to be written.
+ * @param[in]   len        Number of bytes to write.
+ * @param[in]   cb         Completion callback, can be NULL.
+ * @param[in]   cb_arg     Argument passed to the completion callback.
+ *
+ * @return  CY_RSLT_SUCCESS on success
+ *          CY_RSLT_SERIAL_FLASH_ERR_OP_BUSY if another non-blocking operation is in progress
+ *          CY_RSLT_TYPE_ERROR on failure
+ */
+cy_rslt_t cy_ota_mem_write_begin(cy_ota_mem_type_t mem_type, uint32_t addr, void *data, size_t len,
+                                 cy_ota_mem_complete_cb_t cb, void *cb_arg);
+
+/**
+ * @brief Start a non-blocking erase of flash, QSPI flash, or any other external memory type
+ *
+ * The operation is advanced by cy_ota_mem_poll() or cy_ota_mem_complete(). Only one
+ * non-blocking operation can be in progress at a time. Backends without non-blocking
+ * support complete the erase before returning and call the callback from this function.
+ *
+ * @param[in]   mem_type   Memory type @ref cy_ota_mem_type_t
+ * @param[in]   addr       Starting address to begin erasing.
+ * @param[in]   len        Number of bytes to erase.
+ * @param[in]   cb         Completion callback, can be NULL.
+ * @param[in]   cb_arg     Argument passed to the completion callback.
+ *
+ * @return  CY_RSLT_SUCCESS on success
+ *          CY_RSLT_SERIAL_FLASH_ERR_OP_BUSY if another non-blocking operation is in progress
+ *          CY_RSLT_TYPE_ERROR on failure
+ */
+cy_rslt_t cy_ota_mem_erase_begin(cy_ota_mem_type_t mem_type, uint32_t addr, size_t len,
+                                 cy_ota_mem_complete_cb_t cb, void *cb_arg);
+
+/**
+ * @brief Advance the non-blocking memory operation in progress
+ *
+ * Starts the next step of the operation once the current one has finished and calls the
+ * completion callback when the whole operation is done.
+ *
+ * @return  CY_RSLT_SUCCESS if no operation is in progress (anymore)
+ *          CY_RSLT_SERIAL_FLASH_ERR_OP_BUSY if the operation is still in progress
+ *          CY_RSLT_TYPE_ERROR if the operation failed
+ */
+cy_rslt_t cy_ota_mem_poll(void);
+
+/**
+ * @brief Wait for the non-blocking memory operation in progress to complete
+ *
+ * @return  CY_RSLT_SUCCESS if no operation is in progress or it completed successfully
+ *          CY_RSLT_TYPE_ERROR if the operation failed
+ */
+cy_rslt_t cy_ota_mem_complete(void);
+
 /** \} group_ota_bootsupport_functions */
 
 /** \} group_ota_bootsupport */
@@ -233,3 +233,84 @@ OTA_WEAK_FUNCTION size_t cy_ota_mem_get_erase_size(cy_ota_mem_type_t mem_type, u
     UNUSED_ARG(addr);
     return CY_RSLT_SUCCESS;
 }
+
+/**
+ * @brief Start a non-blocking write to flash, QSPI flash, or any other external memory type
+ *
+ * Weak implementation: the write is done with cy_ota_mem_write() before returning and
+ * the completion callback is called from here.
+ *
+ * @param[in]   mem_type   Memory type @ref cy_ota_mem_type_t
+ * @param[in]   addr       Starting address to write to.
+ * @param[in]   data       Pointer to the buffer containing the data to be written.
+ * @param[in]   len        Number of bytes to write.
+ * @param[in]   cb         Completion callback, can be NULL.
+ * @param[in]   cb_arg     Argument passed to the completion callback.
+ *
+ * @return  CY_RSLT_SUCCESS on success
+ *          CY_RSLT_TYPE_ERROR on failure
+ */
+OTA_WEAK_FUNCTION cy_rslt_t cy_ota_mem_write_begin(cy_ota_mem_type_t mem_type, uint32_t addr, void *data, size_t len,
+                                                   cy_ota_mem_complete_cb_t cb, void *cb_arg)
+{
+    cy_rslt_t result;
+
+    result = cy_ota_mem_write(mem_type, addr, data, len);
+    if(cb != NULL)
+    {
+        cb(result, cb_arg);
+    }
+    return result;
+}
+
+/**
+ * @brief Start a non-blocking erase of flash, QSPI flash, or any other external memory type
+ *
+ * Weak implementation: the erase is done with cy_ota_mem_erase() before returning and
+ * the completion callback is called from here.
+ *
+ * @param[in]   mem_type   Memory type @ref cy_ota_mem_type_t
+ * @param[in]   addr       Starting address to begin erasing.
+ * @param[in]   len        Number of bytes to erase.
+ * @param[in]   cb         Completion callback, can be NULL.
+ * @param[in]   cb_arg     Argument passed to the completion callback.
+ *
+ * @return  CY_RSLT_SUCCESS on success
+ *          CY_RSLT_TYPE_ERROR on failure
+ */
+OTA_WEAK_FUNCTION cy_rslt_t cy_ota_mem_erase_begin(cy_ota_mem_type_t mem_type, uint32_t addr, size_t len,
+                                                   cy_ota_mem_complete_cb_t cb, void *cb_arg)
+{
+    cy_rslt_t result;
+
+    result = cy_ota_mem_erase(mem_type, addr, len);
+    if(cb != NULL)
+    {
+        cb(result, cb_arg);
+    }
+    return result;
+}
+
+/**
+ * @brief Advance the non-blocking memory operation in progress
+ *
+ * Weak implementation: operations complete in the begin functions, nothing is ever in progress.
+ *
+ * @return  CY_RSLT_SUCCESS
+ */
+OTA_WEAK_FUNCTION cy_rslt_t cy_ota_mem_poll(void)
+{
+    return CY_RSLT_SUCCESS;
+}
+
+/**
+ * @brief Wait for the non-blocking memory operation in progress to complete
+ *
+ * Weak implementation: operations complete in the begin functions, nothing is ever in progress.
+ *
+ * @return  CY_RSLT_SUCCESS
+ */
+OTA_WEAK_FUNCTION cy_rslt_t cy_ota_mem_complete(void)
+{
+    return CY_RSLT_SUCCESS;
+}
@@ -79,6 +79,29 @@
 #define CY_FLASH_SECTOR_SIZE    0x40000UL   /**< Sector Size                                */
 #endif
 
+#define CY_OTA_UNTAR_IMAGE_MAGIC        (0x96f3b83dUL)  /**< MCUboot image header magic                 */
+#define CY_OTA_UNTAR_TLV_INFO_MAGIC     (0x6907U)       /**< MCUboot unprotected TLV area magic         */
+#define CY_OTA_UNTAR_IMAGE_HDR_SIZE     (32)            /**< MCUboot image header size                  */
+#define CY_OTA_UNTAR_TLV_INFO_SIZE      (4)             /**< MCUboot TLV area info size                 */
+
+#if (MCUBOOT_IMAGE_NUMBER > 8)
+#error The TAR archive commit journal tracks at most 8 images.
+#endif
+
+#if (defined (CY_OTA_IMAGE_VERIFICATION) || defined (CY_OTA_DIRECT_XIP))
+#define CY_OTA_SLOT_STATE_CACHE_IMAGES  MCUBOOT_IMAGE_NUMBER    /**< Images whose slot states are cached */
+#endif /* (CY_OTA_IMAGE_VERIFICATION) || (CY_OTA_DIRECT_XIP) */
+
+#if (defined (CY_OTA_IMAGE_VERIFICATION) || defined (CY_OTA_DIRECT_XIP))
+#ifndef CY_OTA_TLV_SCAN_BUF_SIZE
+#define CY_OTA_TLV_SCAN_BUF_SIZE        64      /**< Stack buffer used to walk the TLV areas */
+#endif
+
+#if ((CY_OTA_TLV_SCAN_BUF_SIZE < 32) || (CY_OTA_TLV_SCAN_BUF_SIZE < CY_OTA_TLV_CUSTOM_DATA_SIZE))
+#error CY_OTA_TLV_SCAN_BUF_SIZE must hold an image header and CY_OTA_TLV_CUSTOM_DATA_SIZE bytes.
+#endif
+#endif /* (CY_OTA_IMAGE_VERIFICATION) || (CY_OTA_DIRECT_XIP) */
+
 /***********************************************************************
  *
  * Structures
@@ -106,6 +129,47 @@ typedef struct update_file_header
     bool is_tar_header_checked; /** Indicates if the TAR header check is completed. */
 } cy_ota_tar_file_header_t;
 
+/**
+ * @brief Journal of the multi-image commit for the current tarball.
+ *
+ * Bit n of each mask stands for image index n (image number n + 1).
+ */
+typedef struct cy_ota_untar_commit_journal
+{
+    uint8_t     written;        /**< Images written to their secondary slot by this session   */
+    uint8_t     validated;      /**< Images whose secondary slot passed validation            */
+    uint8_t     committed;      /**< Images whose trailer has been written                    */
+    uint8_t     permanent;      /**< permanent value the committed trailers were written with */
+    uint32_t    write_gen;      /**< Flash write generation the journal was last updated at   */
+} cy_ota_untar_commit_journal_t;
+
+#if (defined (CY_OTA_IMAGE_VERIFICATION) || defined (CY_OTA_DIRECT_XIP))
+/**
+ * @brief State of a single pass over an image's TLV areas.
+ */
+typedef struct cy_ota_tlv_reader
+{
+    const struct flash_area *fap;               /**< Slot being scanned                 */
+    uint32_t buf_off;                           /**< Area offset of buf[0]              */
+    uint32_t buf_len;                           /**< Valid bytes in buf                 */
+    uint8_t  buf[CY_OTA_TLV_SCAN_BUF_SIZE];     /**< Window of the slot                 */
+} cy_ota_tlv_reader_t;
+#endif /* (CY_OTA_IMAGE_VERIFICATION) || (CY_OTA_DIRECT_XIP) */
+
+#if (defined (CY_OTA_IMAGE_VERIFICATION) || defined (CY_OTA_DIRECT_XIP))
+/**
+ * @brief Cached state of one slot.
+ *
+ * The entry is valid while cy_flash_area_get_write_gen() still returns write_gen.
+ */
+typedef struct cy_ota_slot_state_cache
+{
+    bool                valid;      /**< Entry holds a state read from flash    */
+    uint32_t            write_gen;  /**< Flash write generation of the read     */
+    cy_ota_slot_state_t state;      /**< Slot state                             */
+} cy_ota_slot_state_cache_t;
+#endif /* (CY_OTA_IMAGE_VERIFICATION) || (CY_OTA_DIRECT_XIP) */
+
 /***********************************************************************
  *
  * Variables
@@ -126,6 +190,25 @@ static cy_ota_storage_erase_info_t slot_erase_info[MCUBOOT_IMAGE_NUMBER];
  */
 static cy_untar_context_t  ota_untar_context;
 
+/**
+ * @brief Commit journal for the images of the tar file.
+ */
+static cy_ota_untar_commit_journal_t commit_journal;
+
+#if (defined (CY_OTA_IMAGE_VERIFICATION) || defined (CY_OTA_DIRECT_XIP))
+/**
+ * @brief Slot states per image, indexed by image number and slot id.
+ */
+static cy_ota_slot_state_cache_t slot_state_cache[CY_OTA_SLOT_STATE_CACHE_IMAGES][2];
+#endif /* (CY_OTA_IMAGE_VERIFICATION) || (CY_OTA_DIRECT_XIP) */
+
+/***********************************************************************
+ *
+ * Forward declarations
+ *
+ **********************************************************************/
+static cy_rslt_t cy_ota_untar_recover_commit(void);
+
 /***********************************************************************
  *
  * functions
@@ -146,6 +229,14 @@ cy_rslt_t cy_ota_storage_init(void)
 
     cy_ota_bootloader_abstraction_log_msg(CYLF_MIDDLEWARE, CY_LOG_DEBUG, "%s()\n", __func__);
     result = cy_ota_mem_init();
+    if(result == CY_RSLT_SUCCESS)
+    {
+        /* A failed recovery leaves no partial set pending, it does not stop a new download */
+        if(cy_ota_untar_recover_commit() != CY_RSLT_SUCCESS)
+        {
+            cy_ota_bootloader_abstraction_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "%s() interrupted TAR archive commit undone\n", __func__);
+        }
+    }
     return result;
 }
 
@@ -230,10 +321,11 @@ static cy_untar_result_t ota_untar_write_callback(cy_untar_context_ptr ctxt, uin
         }
 
         cy_flash_area_close(fap);
+        commit_journal.written |= (uint8_t)(1u << image_index);
     }
     else
     {
-        printf("\nImage Need not be updated, Not writing to Flash!!!!!");
+        cy_ota_bootloader_abstraction_log_msg(CYLF_MIDDLEWARE, CY_LOG_NOTICE, "\nImage Need not be updated, Not writing to Flash!!!!!");
     }
 
     return CY_UNTAR_SUCCESS;
@@ -252,12 +344,333 @@ static cy_untar_result_t cy_ota_untar_init_context(cy_ota_storage_context_t *sto
 {
     if(cy_untar_init( ctx_untar, ota_untar_write_callback, storage_ptr ) == CY_RSLT_SUCCESS)
     {
+        memset(&commit_journal, 0x00, sizeof(commit_journal));
         storage_ptr->ota_is_tar_archive  = 1;
         return CY_UNTAR_SUCCESS;
     }
     return CY_UNTAR_ERROR;
 }
 
+/**
+ * @brief Check that an image landed completely in its secondary slot
+ *
+ * Without CY_OTA_IMAGE_VERIFICATION this reads the image header and the TLV
+ * area info behind the image; a short or torn download leaves one of them
+ * without its magic.
+ *
+ * @param[in]   image_index     0 based image index
+ *
+ * @return  CY_RSLT_SUCCESS
+ *          CY_RSLT_OTA_ERROR_VERIFY
+ */
+static cy_rslt_t cy_ota_untar_validate_image(uint16_t image_index)
+{
+#ifdef CY_OTA_IMAGE_VERIFICATION
+    fih_int fih_rc = 0;
+    FIH_CALL(boot_validate_slot_for_image_id, fih_rc, image_index, APP_INACTIVE_SLOT);
+    if(fih_rc != 0)
+    {
+        cy_ota_bootloader_abstraction_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "%s() boot_validate_slot_for_image_id(%d) failed\n", __func__, image_index);
+        return CY_RSLT_OTA_ERROR_VERIFY;
+    }
+    return CY_RSLT_SUCCESS;
+#else
+    const struct flash_area *fap;
+    uint8_t hdr[CY_OTA_UNTAR_IMAGE_HDR_SIZE];
+    uint8_t tlv[CY_OTA_UNTAR_TLV_INFO_SIZE];
+    uint32_t magic;
+    uint16_t hdr_size;
+    uint16_t prot_size;
+    uint32_t img_size;
+    uint16_t tlv_magic;
+    uint16_t tlv_tot;
+    uint32_t off;
+    cy_rslt_t result = CY_RSLT_OTA_ERROR_VERIFY;
+
+    if(cy_flash_area_open(CY_FLASH_AREA_IMAGE_SECONDARY(image_index), &fap) != 0)
+    {
+        cy_ota_bootloader_abstraction_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "%s() cy_flash_area_open(%d) failed\n", __func__, image_index);
+        return CY_RSLT_OTA_ERROR_VERIFY;
+    }
+
+    /* ih_magic, ih_hdr_size, ih_protect_tlv_size and ih_img_size of struct image_header */
+    if(cy_flash_area_read(fap, 0, hdr, sizeof(hdr)) == 0)
+    {
+        memcpy(&magic, &hdr[0], sizeof(magic));
+        memcpy(&hdr_size, &hdr[8], sizeof(hdr_size));
+        memcpy(&prot_size, &hdr[10], sizeof(prot_size));
+        memcpy(&img_size, &hdr[12], sizeof(img_size));
+
+        if((magic == CY_OTA_UNTAR_IMAGE_MAGIC) && (img_size < fap->fa_size))
+        {
+            off = (uint32_t)hdr_size + prot_size + img_size;
+            if(((off + CY_OTA_UNTAR_TLV_INFO_SIZE) <= fap->fa_size) &&
+               (cy_flash_area_read(fap, off, tlv, sizeof(tlv)) == 0))
+            {
+                memcpy(&tlv_magic, &tlv[0], sizeof(tlv_magic));
+                memcpy(&tlv_tot, &tlv[2], sizeof(tlv_tot));
+                if((tlv_magic == CY_OTA_UNTAR_TLV_INFO_MAGIC) && ((off + tlv_tot) <= fap->fa_size))
+                {
+                    result = CY_RSLT_SUCCESS;
+                }
+            }
+        }
+    }
+    cy_flash_area_close(fap);
+
+    if(result != CY_RSLT_SUCCESS)
+    {
+        cy_ota_bootloader_abstraction_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "%s() image %d incomplete in secondary slot\n", __func__, image_index);
+    }
+    return result;
+#endif
+}
+
+/**
+ * @brief Validate every image of the tarball written to a secondary slot
+ *
+ * The result is kept in the commit journal and reused for as long as no flash
+ * write happens, so a retried commit does not read the images again.
+ *
+ * @return  CY_RSLT_SUCCESS
+ *          CY_RSLT_OTA_ERROR_VERIFY
+ */
+static cy_rslt_t cy_ota_untar_validate(void)
+{
+    uint16_t image_index;
+
+    if(commit_journal.written == 0)
+    {
+        cy_ota_bootloader_abstraction_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "%s() no image written from the TAR archive\n", __func__);
+        return CY_RSLT_OTA_ERROR_VERIFY;
+    }
+
+    if(commit_journal.write_gen != cy_flash_area_get_write_gen())
+    {
+        commit_journal.validated = 0;
+    }
+
+    for(image_index = 0; image_index < MCUBOOT_IMAGE_NUMBER; image_index++)
+    {
+        uint8_t bit = (uint8_t)(1u << image_index);
+
+        if(((commit_journal.written & bit) == 0) || ((commit_journal.validated & bit) != 0))
+        {
+            continue;
+        }
+        if(cy_ota_untar_validate_image(image_index) != CY_RSLT_SUCCESS)
+        {
+            commit_journal.validated = 0;
+            return CY_RSLT_OTA_ERROR_VERIFY;
+        }
+        commit_journal.validated |= bit;
+    }
+    commit_journal.write_gen = cy_flash_area_get_write_gen();
+
+    return CY_RSLT_SUCCESS;
+}
+
+/**
+ * @brief Clear the pending trailers of a commit and close its journal
+ *
+ * @param[in,out]   journal     journal of the commit, pending lists the trailers to clear
+ *
+ * @return  CY_RSLT_SUCCESS
+ *          CY_RSLT_OTA_ERROR_VERIFY
+ */
+static cy_rslt_t cy_ota_untar_undo_commit(cy_flash_area_boot_journal_t *journal)
+{
+    cy_rslt_t result = CY_RSLT_SUCCESS;
+    uint16_t image_index;
+
+    for(image_index = 0; image_index < MCUBOOT_IMAGE_NUMBER; image_index++)
+    {
+        if(((journal->pending & (1u << image_index)) != 0) &&
+           (cy_flash_area_boot_unset_pending((uint8_t)(image_index + 1)) != 0))
+        {
+            cy_ota_bootloader_abstraction_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "%s() cy_flash_area_boot_unset_pending(%d) failed\n", __func__, (image_index + 1));
+            result = CY_RSLT_OTA_ERROR_VERIFY;
+        }
+    }
+
+    journal->open = 0;
+    if(cy_flash_area_boot_write_journal(journal) != 0)
+    {
+        result = CY_RSLT_OTA_ERROR_VERIFY;
+    }
+    return result;
+}
+
+/**
+ * @brief Write the trailers of the images of the journal not committed yet
+ *
+ * The trailers are written from the highest image down, image 1 last. The journal
+ * in flash is updated after each trailer. Then the journal is closed.
+ *
+ * @param[in,out]   journal     open journal of the commit
+ *
+ * @return  CY_RSLT_SUCCESS
+ *          CY_RSLT_OTA_ERROR_VERIFY
+ */
+static cy_rslt_t cy_ota_untar_commit(cy_flash_area_boot_journal_t *journal)
+{
+    int16_t image_index;
+
+    for(image_index = (MCUBOOT_IMAGE_NUMBER - 1); image_index >= 0; image_index--)
+    {
+        uint8_t bit = (uint8_t)(1u << image_index);
+
+        if(((journal->images & bit) == 0) || ((journal->committed & bit) != 0))
+        {
+            continue;
+        }
+        if(cy_flash_area_boot_set_pending((uint8_t)(image_index + 1), journal->permanent) != 0)
+        {
+            cy_ota_bootloader_abstraction_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "%s() cy_flash_area_boot_set_pending(%d) failed\n", __func__, (image_index + 1));
+            journal->pending |= bit;
+            return CY_RSLT_OTA_ERROR_VERIFY;
+        }
+        journal->committed |= bit;
+        journal->pending   |= bit;
+        if(cy_flash_area_boot_write_journal(journal) != 0)
+        {
+            return CY_RSLT_OTA_ERROR_VERIFY;
+        }
+    }
+
+    /* Every trailer is written, a journal left open is closed by cy_ota_untar_recover_commit() */
+    journal->open = 0;
+    if(cy_flash_area_boot_write_journal(journal) != 0)
+    {
+        cy_ota_bootloader_abstraction_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "%s() closing the commit journal failed\n", __func__);
+    }
+    return CY_RSLT_SUCCESS;
+}
+
+/**
+ * @brief Set pending for all images of the TAR archive in one ordered pass
+ *
+ * Nothing is marked pending until every secondary slot written by this session
+ * has passed cy_ota_untar_validate(). The commit journal is then opened in the
+ * image 1 secondary slot trailer, and the trailers are written from the highest
+ * image down, so image 1 is written last and completes the commit. If a trailer
+ * write fails, every trailer of the set is cleared again and the journal is
+ * closed. A closed journal cannot be opened again until the next download erases
+ * the trailer, so after a rollback the archive has to be downloaded again.
+ * Images the journal already lists as committed are skipped, so the calls made
+ * for the other images of the same archive only finish the pass.
+ *
+ * @param[in]   permanent   0 = run the images once, then confirm or revert
+ *                          1 = run the images forever
+ *
+ * @return  CY_RSLT_SUCCESS
+ *          CY_RSLT_OTA_ERROR_VERIFY
+ */
+static cy_rslt_t cy_ota_untar_set_pending(uint8_t permanent)
+{
+    cy_flash_area_boot_journal_t journal;
+    cy_rslt_t result;
+
+    result = cy_ota_untar_validate();
+    if(result != CY_RSLT_SUCCESS)
+    {
+        return result;
+    }
+
+    memset(&journal, 0x00, sizeof(journal));
+    journal.images    = commit_journal.written;
+    journal.committed = commit_journal.committed;
+    journal.pending   = commit_journal.committed;
+    journal.permanent = permanent;
+    journal.open      = 1;
+
+    /* The closed journal cannot be opened again to rewrite the trailers */
+    if((commit_journal.committed != 0) && (commit_journal.permanent != permanent))
+    {
+        cy_ota_bootloader_abstraction_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "%s() images already pending with permanent %d\n", __func__, commit_journal.permanent);
+        return CY_RSLT_OTA_ERROR_VERIFY;
+    }
+
+    /* Opened before the first trailer is written */
+    if((commit_journal.committed == 0) && (cy_flash_area_boot_write_journal(&journal) != 0))
+    {
+        cy_ota_bootloader_abstraction_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "%s() opening the commit journal failed\n", __func__);
+        return CY_RSLT_OTA_ERROR_VERIFY;
+    }
+    commit_journal.permanent = permanent;
+
+    result = cy_ota_untar_commit(&journal);
+    commit_journal.committed = journal.committed;
+    if(result != CY_RSLT_SUCCESS)
+    {
+        /* Roll back, no partial set of images is left pending */
+        (void)cy_ota_untar_undo_commit(&journal);
+        commit_journal.committed = 0;
+    }
+    /* Trailer writes do not touch the images, keep the validation */
+    commit_journal.write_gen = cy_flash_area_get_write_gen();
+
+    cy_ota_bootloader_abstraction_log_msg(CYLF_MIDDLEWARE, CY_LOG_DEBUG, "%s() written 0x%x committed 0x%x\n", __func__, commit_journal.written, commit_journal.committed);
+    return result;
+}
+
+/**
+ * @brief Finish or undo a TAR archive commit interrupted by a reset
+ *
+ * A commit journal left open in the image 1 secondary slot trailer means the
+ * trailer pass was cut short. When no image of the set has been installed by
+ * MCUboot yet, the images are validated again and the remaining trailers are
+ * written. When only part of the set was installed, or finishing fails, the
+ * trailers still pending are cleared; an image MCUboot already installed in test
+ * mode reverts at the next reset unless it is confirmed.
+ *
+ * @return  CY_RSLT_SUCCESS
+ *          CY_RSLT_OTA_ERROR_VERIFY
+ */
+static cy_rslt_t cy_ota_untar_recover_commit(void)
+{
+    cy_flash_area_boot_journal_t journal;
+    cy_rslt_t result = CY_RSLT_SUCCESS;
+    uint8_t installed;
+    uint16_t image_index;
+
+    if((cy_flash_area_boot_read_journal(&journal) != 0) || (journal.open == 0))
+    {
+        return CY_RSLT_SUCCESS;
+    }
+    cy_ota_bootloader_abstraction_log_msg(CYLF_MIDDLEWARE, CY_LOG_NOTICE, "%s() images 0x%x committed 0x%x pending 0x%x\n", __func__, journal.images, journal.committed, journal.pending);
+
+    /* A committed image without a pending trailer has been installed by MCUboot */
+    installed = journal.committed & (uint8_t)~journal.pending;
+    if(installed == journal.images)
+    {
+        /* The whole set was committed before the journal could be closed */
+        journal.open = 0;
+        return (cy_flash_area_boot_write_journal(&journal) == 0) ? CY_RSLT_SUCCESS : CY_RSLT_OTA_ERROR_VERIFY;
+    }
+    if(installed != 0)
+    {
+        result = CY_RSLT_OTA_ERROR_VERIFY;
+    }
+    for(image_index = 0; (image_index < MCUBOOT_IMAGE_NUMBER) && (result == CY_RSLT_SUCCESS); image_index++)
+    {
+        if((journal.images & (1u << image_index)) != 0)
+        {
+            result = cy_ota_untar_validate_image(image_index);
+        }
+    }
+    if(result == CY_RSLT_SUCCESS)
+    {
+        result = cy_ota_untar_commit(&journal);
+    }
+
+    if(result != CY_RSLT_SUCCESS)
+    {
+        (void)cy_ota_untar_undo_commit(&journal);
+    }
+    return result;
+}
+
 /**
  * @brief Open Storage area for download
  *
@@ -303,6 +716,16 @@ cy_rslt_t cy_ota_storage_open(cy_ota_storage_context_t *storage_ptr)
         slot_erase_info[i].erased_sectors = 0;
         slot_erase_info[i].erased_complete = false;
         slot_erase_info[i].erase_offset = 0;
+
+#if !CY_OTA_DIRECT_XIP
+        /* The slots are erased while the archive is written, clear a commit journal left in the trailer now */
+        if((i == 0) && (slot_erase_info[i].total_sectors != 0) &&
+           (cy_flash_area_erase(fap, ((slot_erase_info[i].total_sectors - 1) * CY_FLASH_SECTOR_SIZE), CY_FLASH_SECTOR_SIZE) != 0))
+        {
+            cy_ota_bootloader_abstraction_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "cy_flash_area_erase(fap, %d) failed\r\n", i);
+            return CY_RSLT_OTA_ERROR_OPEN_STORAGE;
+        }
+#endif
     }
     storage_ptr->storage_loc = (void *)fap;
 
@@ -629,6 +1052,16 @@ cy_rslt_t cy_ota_storage_verify(cy_ota_storage_context_t *storage_ptr)
         return CY_RSLT_OTA_ERROR_VERIFY;
     }
 
+    if(storage_ptr->ota_is_tar_archive != 0)
+    {
+        /* The images of a TAR archive are validated, and marked pending, as one set */
+#ifdef CY_OTA_IMAGE_VERIFICATION
+        return cy_ota_untar_validate();
+#else
+        return cy_ota_untar_set_pending((storage_ptr->validate_after_reboot == 0));
+#endif
+    }
+
     cy_ota_bootloader_abstraction_log_msg(CYLF_MIDDLEWARE, CY_LOG_NOTICE, "Start boot_validate_slot_for_image_id() ... \n");
 
 #ifdef CY_OTA_IMAGE_VERIFICATION
@@ -710,6 +1143,11 @@ cy_rslt_t cy_ota_storage_set_boot_pending(uint16_t app_id, cy_ota_storage_contex
         return CY_RSLT_OTA_ERROR_VERIFY;
     }
 
+    if(storage_ptr->ota_is_tar_archive != 0)
+    {
+        return cy_ota_untar_set_pending((storage_ptr->validate_after_reboot == 0));
+    }
+
     rc = cy_flash_area_boot_set_pending(app_id, (storage_ptr->validate_after_reboot == 0));
     if(rc != 0)
     {
@@ -796,113 +1234,300 @@ cy_rslt_t cy_ota_storage_get_image_validate_status(uint16_t app_id, uint8_t *sta
     return CY_RSLT_SUCCESS;
 }
 
-cy_rslt_t cy_ota_storage_get_app_info(uint16_t slot_id, uint16_t image_num, cy_ota_app_info_t *app_info)
+#if (defined (CY_OTA_IMAGE_VERIFICATION) || defined (CY_OTA_DIRECT_XIP))
+/**
+ * @brief Return len bytes of the slot at off, refilling the scan buffer when needed
+ *
+ * @param[in]   reader  - TLV scan state
+ * @param[in]   off     - offset in the flash area
+ * @param[in]   len     - bytes needed, at most CY_OTA_TLV_SCAN_BUF_SIZE
+ * @param[out]  data    - pointer into the scan buffer
+ *
+ * @return  CY_RSLT_SUCCESS
+ *          CY_RSLT_OTA_ERROR_READ_STORAGE
+ */
+static cy_rslt_t cy_ota_tlv_reader_get(cy_ota_tlv_reader_t *reader, uint32_t off, uint32_t len, const uint8_t **data)
 {
-    cy_rslt_t result = CY_RSLT_SUCCESS;
+    uint32_t read_len;
 
-    cy_ota_bootloader_abstraction_log_msg(CYLF_MIDDLEWARE, CY_LOG_DEBUG, "%s \n", __func__);
+    if((len > CY_OTA_TLV_SCAN_BUF_SIZE) || (off > reader->fap->fa_size) || (len > (reader->fap->fa_size - off)))
+    {
+        return CY_RSLT_OTA_ERROR_READ_STORAGE;
+    }
 
-#if (defined (CY_OTA_IMAGE_VERIFICATION) || defined (CY_OTA_DIRECT_XIP))
-    const struct flash_area *fap;
-    struct image_version img_ver;
-    uint8_t *buffer = NULL;
-    uint16_t len = 0;
-    uint32_t off = 0;
-    int rc = 0;
+    if((off < reader->buf_off) || ((off + len) > (reader->buf_off + reader->buf_len)))
+    {
+        read_len = reader->fap->fa_size - off;
+        if(read_len > CY_OTA_TLV_SCAN_BUF_SIZE)
+        {
+            read_len = CY_OTA_TLV_SCAN_BUF_SIZE;
+        }
 
-    memset(&img_ver, 0x00, sizeof(img_ver));
-    rc = boot_get_image_version(image_num, slot_id, &img_ver);
-    if(rc == 0)
+        if(cy_flash_area_read(reader->fap, off, reader->buf, read_len) != 0)
+        {
+            cy_ota_bootloader_abstraction_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "cy_flash_area_read() failed at offset 0x%lx\n", off);
+            reader->buf_len = 0;
+            return CY_RSLT_OTA_ERROR_READ_STORAGE;
+        }
+        reader->buf_off = off;
+        reader->buf_len = read_len;
+    }
+
+    *data = &reader->buf[off - reader->buf_off];
+    return CY_RSLT_SUCCESS;
+}
+
+/**
+ * @brief Walk one TLV area and pick out the requested TLVs
+ *
+ * @param[in]       reader  - TLV scan state
+ * @param[in]       off     - offset of the TLV area info header
+ * @param[in]       magic   - expected TLV area magic
+ * @param[in,out]   info    - image information being filled
+ * @param[out]      next    - offset just past the TLV area
+ *
+ * @return  CY_RSLT_SUCCESS
+ *          CY_RSLT_OTA_ERROR_READ_STORAGE
+ *          CY_RSLT_OTA_ERROR_NO_IMAGE_INFO
+ */
+static cy_rslt_t cy_ota_tlv_scan_area(cy_ota_tlv_reader_t *reader, uint32_t off, uint16_t magic,
+                                      cy_ota_image_tlv_info_t *info, uint32_t *next)
+{
+    struct image_tlv_info tlv_info;
+    struct image_tlv tlv;
+    const uint8_t *data;
+    uint32_t end;
+    uint32_t copy_len;
+    cy_rslt_t result;
+    uint8_t i;
+
+    result = cy_ota_tlv_reader_get(reader, off, sizeof(tlv_info), &data);
+    if(result != CY_RSLT_SUCCESS)
     {
-        cy_ota_bootloader_abstraction_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR,"Image version %x.%x.%x\r\n", img_ver.iv_major, img_ver.iv_minor, img_ver.iv_build_num);
+        return result;
     }
-    else
+    memcpy(&tlv_info, data, sizeof(tlv_info));
+    if(tlv_info.it_magic != magic)
     {
-        cy_ota_bootloader_abstraction_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "boot_get_image_version failed\n");
         return CY_RSLT_OTA_ERROR_NO_IMAGE_INFO;
     }
 
-    app_info->app_id = image_num;
-    app_info->major = img_ver.iv_major;
-    app_info->minor = img_ver.iv_minor;
-    app_info->build = img_ver.iv_build_num;
-    app_info->revision = (img_ver.iv_revision >> 8);
-    app_info->slot = (img_ver.iv_revision & 0xFF);
+    end = off + tlv_info.it_tlv_tot;
+    off += sizeof(tlv_info);
 
-    /* Retrieve Company ID */
-    rc = boot_find_image_tlv_info(image_num, slot_id, CY_TLV_INDEX_COMPANY_ID, &len, &off);
-    if(rc == 0)
+    while((off + sizeof(tlv)) <= end)
     {
-        if(cy_flash_area_open(CY_FLASH_UPGRADE_AREA(slot_id, 0), &fap) != 0)
+        result = cy_ota_tlv_reader_get(reader, off, sizeof(tlv), &data);
+        if(result != CY_RSLT_SUCCESS)
         {
-            cy_ota_bootloader_abstraction_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "cy_flash_area_open failed\n");
-            return CY_RSLT_OTA_ERROR_OPEN_STORAGE;
+            return result;
         }
+        memcpy(&tlv, data, sizeof(tlv));
+        off += sizeof(tlv);
 
-        buffer = (uint8_t *)malloc(len);
-        if(buffer == NULL)
+        if((tlv.it_type == CY_TLV_INDEX_COMPANY_ID) || (tlv.it_type == CY_TLV_INDEX_PRODUCT_ID))
         {
-            return CY_RSLT_OTA_ERROR_OUT_OF_MEMORY;
+            if(tlv.it_len >= sizeof(uint16_t))
+            {
+                result = cy_ota_tlv_reader_get(reader, off, sizeof(uint16_t), &data);
+                if(result != CY_RSLT_SUCCESS)
+                {
+                    return result;
+                }
+                if(tlv.it_type == CY_TLV_INDEX_COMPANY_ID)
+                {
+                    info->app_info.company_id = (uint16_t)((data[0] << 8) | data[1]);
+                }
+                else
+                {
+                    info->app_info.product_id = (uint16_t)((data[0] << 8) | data[1]);
+                }
+            }
         }
-        memset(buffer, 0x00, len);
 
-        /* read TLV info into the buffer */
-        result = cy_flash_area_read(fap, off, (void *)buffer, len);
-        if(result != CY_RSLT_SUCCESS)
+        for(i = 0; i < info->custom_count; i++)
         {
-            cy_ota_bootloader_abstraction_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "cy_flash_area_read() failed with error 0x%lx for Company ID with offset : 0x%lx\n", off, (uint32_t)result);
-            result = CY_RSLT_OTA_ERROR_READ_STORAGE;
-        }
-        else
-        {
-            app_info->company_id = (uint16_t)((buffer[0] << 8) | buffer[1]);
+            if((info->custom[i].type == tlv.it_type) && (info->custom[i].len == 0))
+            {
+                info->custom[i].len = tlv.it_len;
+                copy_len = (tlv.it_len < CY_OTA_TLV_CUSTOM_DATA_SIZE) ? tlv.it_len : CY_OTA_TLV_CUSTOM_DATA_SIZE;
+                result = cy_ota_tlv_reader_get(reader, off, copy_len, &data);
+                if(result != CY_RSLT_SUCCESS)
+                {
+                    return result;
+                }
+                memcpy(info->custom[i].data, data, copy_len);
+            }
         }
-        free(buffer);
+
+        off += tlv.it_len;
     }
-    else
+
+    *next = end;
+    return CY_RSLT_SUCCESS;
+}
+#endif /* (CY_OTA_IMAGE_VERIFICATION) || (CY_OTA_DIRECT_XIP) */
+
+cy_rslt_t cy_ota_storage_get_image_tlv_info(uint16_t slot_id, uint16_t image_num, cy_ota_image_tlv_info_t *info)
+{
+    cy_rslt_t result = CY_RSLT_SUCCESS;
+
+    cy_ota_bootloader_abstraction_log_msg(CYLF_MIDDLEWARE, CY_LOG_DEBUG, "%s \n", __func__);
+
+    if((info == NULL) || (info->custom_count > CY_OTA_TLV_CUSTOM_MAX))
     {
-        app_info->company_id = 0xFFFF;
+        return CY_RSLT_OTA_ERROR_BADARG;
     }
 
-    /* Retrieve Product ID */
-    rc = boot_find_image_tlv_info(image_num, slot_id, CY_TLV_INDEX_PRODUCT_ID, &len, &off);
-    if(rc == 0)
+#if (defined (CY_OTA_IMAGE_VERIFICATION) || defined (CY_OTA_DIRECT_XIP))
+    cy_ota_tlv_reader_t reader;
+    struct image_header hdr;
+    const uint8_t *data;
+    uint32_t off = 0;
+    uint8_t fa_id;
+    uint8_t i;
+
+    memset(&info->app_info, 0x00, sizeof(info->app_info));
+    info->app_info.company_id = 0xFFFF;
+    info->app_info.product_id = 0xFFFF;
+    for(i = 0; i < info->custom_count; i++)
     {
-        if(cy_flash_area_open(CY_FLASH_UPGRADE_AREA(slot_id, 0), &fap) != 0)
-        {
-            cy_ota_bootloader_abstraction_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "cy_flash_area_open failed\n");
-            return CY_RSLT_OTA_ERROR_OPEN_STORAGE;
-        }
+        info->custom[i].len = 0;
+    }
 
-        buffer = (uint8_t *)malloc(len);
-        if(buffer == NULL)
-        {
-            return CY_RSLT_OTA_ERROR_OUT_OF_MEMORY;
-        }
-        memset(buffer, 0x00, len);
+    fa_id = (slot_id == 0) ? CY_FLASH_AREA_IMAGE_PRIMARY(image_num) : CY_FLASH_AREA_IMAGE_SECONDARY(image_num);
+    if(cy_flash_area_open(fa_id, &reader.fap) != 0)
+    {
+        cy_ota_bootloader_abstraction_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "cy_flash_area_open failed\n");
+        return CY_RSLT_OTA_ERROR_OPEN_STORAGE;
+    }
+    reader.buf_off = 0;
+    reader.buf_len = 0;
 
-        /* read TLV info into the buffer */
-        result = cy_flash_area_read(fap, off, (void *)buffer, len);
-        if(result != CY_RSLT_SUCCESS)
+    result = cy_ota_tlv_reader_get(&reader, 0, sizeof(hdr), &data);
+    if(result == CY_RSLT_SUCCESS)
+    {
+        memcpy(&hdr, data, sizeof(hdr));
+        if(hdr.ih_magic != IMAGE_MAGIC)
         {
-            cy_ota_bootloader_abstraction_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "cy_flash_area_read() failed with error 0x%lx for Product ID with offset : 0x%lx\n", off, (uint32_t)result);
-            result = CY_RSLT_OTA_ERROR_READ_STORAGE;
+            cy_ota_bootloader_abstraction_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "No image header in slot %d\n", slot_id);
+            result = CY_RSLT_OTA_ERROR_NO_IMAGE_INFO;
         }
-        else
+    }
+
+    if(result == CY_RSLT_SUCCESS)
+    {
+        cy_ota_bootloader_abstraction_log_msg(CYLF_MIDDLEWARE, CY_LOG_DEBUG, "Image version %x.%x.%x\r\n", hdr.ih_ver.iv_major, hdr.ih_ver.iv_minor, hdr.ih_ver.iv_build_num);
+        info->app_info.app_id = image_num;
+        info->app_info.major = hdr.ih_ver.iv_major;
+        info->app_info.minor = hdr.ih_ver.iv_minor;
+        info->app_info.build = hdr.ih_ver.iv_build_num;
+        info->app_info.revision = (hdr.ih_ver.iv_revision >> 8);
+        info->app_info.slot = (hdr.ih_ver.iv_revision & 0xFF);
+
+        /* Protected TLVs, when present, come first, followed by the unprotected TLVs */
+        off = (uint32_t)hdr.ih_hdr_size + hdr.ih_img_size;
+        if(hdr.ih_protect_tlv_size != 0)
         {
-            app_info->product_id = (uint16_t)((buffer[0] << 8) | buffer[1]);
+            result = cy_ota_tlv_scan_area(&reader, off, IMAGE_TLV_PROT_INFO_MAGIC, info, &off);
         }
-        free(buffer);
     }
-    else
+
+    if(result == CY_RSLT_SUCCESS)
     {
-        app_info->product_id = 0xFFFF;
+        result = cy_ota_tlv_scan_area(&reader, off, IMAGE_TLV_INFO_MAGIC, info, &off);
     }
+
+    cy_flash_area_close(reader.fap);
 #endif /* (CY_OTA_IMAGE_VERIFICATION) || (CY_OTA_DIRECT_XIP) */
 
     return result;
 }
 
+cy_rslt_t cy_ota_storage_get_app_info(uint16_t slot_id, uint16_t image_num, cy_ota_app_info_t *app_info)
+{
+    cy_rslt_t result = CY_RSLT_SUCCESS;
+
+    cy_ota_bootloader_abstraction_log_msg(CYLF_MIDDLEWARE, CY_LOG_DEBUG, "%s \n", __func__);
+
+#if (defined (CY_OTA_IMAGE_VERIFICATION) || defined (CY_OTA_DIRECT_XIP))
+    cy_ota_image_tlv_info_t info;
+
+    info.custom_count = 0;
+    result = cy_ota_storage_get_image_tlv_info(slot_id, image_num, &info);
+    if(result == CY_RSLT_SUCCESS)
+    {
+        *app_info = info.app_info;
+    }
+#endif /* (CY_OTA_IMAGE_VERIFICATION) || (CY_OTA_DIRECT_XIP) */
+
+    return result;
+}
+
+#if (defined (CY_OTA_IMAGE_VERIFICATION) || defined (CY_OTA_DIRECT_XIP))
+/**
+ * @brief Look up a cached slot state
+ *
+ * @param[in]   slot_id     - slot id
+ * @param[in]   image_num   - image number
+ * @param[out]  state       - cached state
+ *
+ * @return  true if state holds the current state of the slot
+ */
+static bool cy_ota_storage_get_cached_slot_state(uint16_t slot_id, uint16_t image_num, cy_ota_slot_state_t *state)
+{
+    cy_ota_slot_state_cache_t *entry;
+
+    if((image_num >= CY_OTA_SLOT_STATE_CACHE_IMAGES) || (slot_id > 1))
+    {
+        return false;
+    }
+
+    entry = &slot_state_cache[image_num][slot_id];
+    if((!entry->valid) || (entry->write_gen != cy_flash_area_get_write_gen()))
+    {
+        return false;
+    }
+
+    *state = entry->state;
+    return true;
+}
+
+/**
+ * @brief Remember a slot state read from flash
+ *
+ * @param[in]   slot_id     - slot id
+ * @param[in]   image_num   - image number
+ * @param[in]   write_gen   - flash write generation sampled before the read
+ * @param[in]   state       - state read
+ */
+static void cy_ota_storage_cache_slot_state(uint16_t slot_id, uint16_t image_num, uint32_t write_gen, cy_ota_slot_state_t state)
+{
+    cy_ota_slot_state_cache_t *entry;
+
+    if((image_num >= CY_OTA_SLOT_STATE_CACHE_IMAGES) || (slot_id > 1))
+    {
+        return;
+    }
+
+    entry = &slot_state_cache[image_num][slot_id];
+    entry->write_gen = write_gen;
+    entry->state     = state;
+    entry->valid     = true;
+}
+
+/**
+ * @brief Drop all cached slot states
+ *
+ * Used after trailer updates made by the bootloader library, which do not
+ * go through cy_flash_area_write().
+ */
+static void cy_ota_storage_invalidate_slot_states(void)
+{
+    memset(slot_state_cache, 0x00, sizeof(slot_state_cache));
+}
+#endif /* (CY_OTA_IMAGE_VERIFICATION) || (CY_OTA_DIRECT_XIP) */
+
 cy_rslt_t cy_ota_storage_get_slot_state(uint16_t slot_id, uint16_t image_num, cy_ota_slot_state_t *state)
 {
     cy_rslt_t result = CY_RSLT_SUCCESS;
@@ -912,8 +1537,15 @@ cy_rslt_t cy_ota_storage_get_slot_state(uint16_t slot_id, uint16_t image_num, cy
 #if (defined (CY_OTA_IMAGE_VERIFICATION) || defined (CY_OTA_DIRECT_XIP))
     int rc = 0;
     boot_slot_state_t slot_state;
+    uint32_t write_gen;
+
+    if(cy_ota_storage_get_cached_slot_state(slot_id, image_num, state))
+    {
+        return CY_RSLT_SUCCESS;
+    }
 
     cy_ota_bootloader_abstraction_log_msg(CYLF_MIDDLEWARE, CY_LOG_DEBUG, "%s \n", __func__);
+    write_gen = cy_flash_area_get_write_gen();
     rc = boot_get_image_state(image_num, slot_id, &slot_state);
     if(rc == 0)
     {
@@ -943,6 +1575,11 @@ cy_rslt_t cy_ota_storage_get_slot_state(uint16_t slot_id, uint16_t image_num, cy
                 result = CY_RSLT_OTA_ERROR_UNSUPPORTED;
                 break;
         }
+
+        if(result == CY_RSLT_SUCCESS)
+        {
+            cy_ota_storage_cache_slot_state(slot_id, image_num, write_gen, *state);
+        }
     }
     else
     {
@@ -1059,6 +1696,8 @@ cy_rslt_t cy_ota_storage_set_slot_state(uint16_t slot_id, uint16_t image_num, cy
                 result = CY_RSLT_OTA_ERROR_UNSUPPORTED;
                 break;
         }
+
+        cy_ota_storage_invalidate_slot_states();
     }
     else
     {
@@ -1069,3 +1708,103 @@ cy_rslt_t cy_ota_storage_set_slot_state(uint16_t slot_id, uint16_t image_num, cy
 
     return result;
 }
+
+#if (defined (CY_OTA_IMAGE_VERIFICATION) || defined (CY_OTA_DIRECT_XIP))
+/**
+ * @brief Slot state from a trailer already read, by the rules of boot_get_image_state()
+ *
+ * @param[in]   has_image   - slot holds an image header
+ * @param[in]   trailer     - trailer of the slot
+ *
+ * @return  slot state
+ */
+static cy_ota_slot_state_t cy_ota_storage_slot_state_from_trailer(bool has_image, const cy_flash_area_trailer_status_t *trailer)
+{
+    if(!has_image)
+    {
+        return CY_OTA_SLOT_STATE_NO_IMAGE;
+    }
+    if(trailer->magic != CY_IFX_MCUBOOT_MAGIC_GOOD)
+    {
+        return CY_OTA_SLOT_STATE_INACTIVE;
+    }
+    if(trailer->image_ok == CY_IFX_MCUBOOT_FLAG_SET)
+    {
+        return CY_OTA_SLOT_STATE_ACTIVE;
+    }
+    if(trailer->copy_done == CY_IFX_MCUBOOT_FLAG_SET)
+    {
+        return CY_OTA_SLOT_STATE_VERIFYING;
+    }
+    return CY_OTA_SLOT_STATE_PENDING;
+}
+#endif /* (CY_OTA_IMAGE_VERIFICATION) || (CY_OTA_DIRECT_XIP) */
+
+cy_rslt_t cy_ota_storage_get_images_status(cy_ota_image_status_t *status, uint16_t image_count)
+{
+    cy_rslt_t result = CY_RSLT_SUCCESS;
+    cy_flash_area_trailer_status_t trailer;
+    cy_ota_slot_status_t *slot_status;
+    uint16_t image_num;
+    uint16_t slot_id;
+
+    cy_ota_bootloader_abstraction_log_msg(CYLF_MIDDLEWARE, CY_LOG_DEBUG, "%s()\n", __func__);
+
+    if((status == NULL) || (image_count == 0) || (image_count > MCUBOOT_IMAGE_NUMBER))
+    {
+        cy_ota_bootloader_abstraction_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "Bad args for %s()\n", __func__);
+        return CY_RSLT_OTA_ERROR_BADARG;
+    }
+
+    memset(status, 0x00, image_count * sizeof(cy_ota_image_status_t));
+
+    for(image_num = 0; image_num < image_count; image_num++)
+    {
+        for(slot_id = 0; slot_id < 2; slot_id++)
+        {
+#if (defined (CY_OTA_IMAGE_VERIFICATION) || defined (CY_OTA_DIRECT_XIP))
+            cy_ota_image_tlv_info_t info;
+            cy_rslt_t info_result;
+            uint32_t write_gen = cy_flash_area_get_write_gen();
+#endif
+
+            slot_status = &status[image_num].slot[slot_id];
+            slot_status->state = CY_OTA_SLOT_STATE_UNKNOWN;
+
+            if(cy_flash_area_boot_get_trailer_status((uint8_t)(image_num + 1), (uint8_t)slot_id, &trailer) != 0)
+            {
+                cy_ota_bootloader_abstraction_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "Image %d slot %d trailer read failed\n", image_num, slot_id);
+                slot_status->result = CY_RSLT_OTA_ERROR_GENERAL;
+                result = CY_RSLT_OTA_ERROR_GENERAL;
+                continue;
+            }
+            slot_status->pending_status  = trailer.swap_type;
+            slot_status->validate_status = trailer.image_ok;
+
+#if (defined (CY_OTA_IMAGE_VERIFICATION) || defined (CY_OTA_DIRECT_XIP))
+            /* Header and version from the TLV pass, the state from the trailer read above */
+            info.custom_count = 0;
+            info_result = cy_ota_storage_get_image_tlv_info(slot_id, image_num, &info);
+            if(info_result == CY_RSLT_OTA_ERROR_OPEN_STORAGE)
+            {
+                slot_status->result = CY_RSLT_OTA_ERROR_GENERAL;
+                result = CY_RSLT_OTA_ERROR_GENERAL;
+                continue;
+            }
+
+            slot_status->state = cy_ota_storage_slot_state_from_trailer((info_result != CY_RSLT_OTA_ERROR_NO_IMAGE_INFO), &trailer);
+            cy_ota_storage_cache_slot_state(slot_id, image_num, write_gen, slot_status->state);
+
+            if(info_result == CY_RSLT_SUCCESS)
+            {
+                slot_status->major    = info.app_info.major;
+                slot_status->minor    = info.app_info.minor;
+                slot_status->revision = info.app_info.revision;
+                slot_status->build    = info.app_info.build;
+            }
+#endif /* (CY_OTA_IMAGE_VERIFICATION) || (CY_OTA_DIRECT_XIP) */
+        }
+    }
+
+    return result;
+}
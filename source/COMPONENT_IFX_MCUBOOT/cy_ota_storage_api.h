@@ -67,6 +67,21 @@
  * defines & enums
  *
  **********************************************************************/
+/**
+ * \addtogroup group_ota_bootsupport_macros
+ * \{
+ */
+
+#ifndef CY_OTA_TLV_CUSTOM_MAX
+#define CY_OTA_TLV_CUSTOM_MAX           (4)     /**< Custom TLVs extracted by one cy_ota_storage_get_image_tlv_info() call. */
+#endif
+
+#ifndef CY_OTA_TLV_CUSTOM_DATA_SIZE
+#define CY_OTA_TLV_CUSTOM_DATA_SIZE     (32)    /**< Bytes kept from the value of each custom TLV. */
+#endif
+
+/** \} group_ota_bootsupport_macros */
+
 /**
  * \addtogroup group_ota_bootsupport_typedefs
  * \{
@@ -85,6 +100,49 @@ typedef enum
     CY_OTA_SLOT_STATE_UNKNOWN         /**<  Reserved. */
 } cy_ota_slot_state_t;
 
+/**
+ * @brief Custom TLV to extract with cy_ota_storage_get_image_tlv_info().
+ */
+typedef struct
+{
+    uint16_t type;                                  /**< [in] TLV type to look for. */
+    uint16_t len;                                   /**< [out] TLV length in the image, 0 if not found. */
+    uint8_t  data[CY_OTA_TLV_CUSTOM_DATA_SIZE];     /**< [out] First bytes of the TLV value. */
+} cy_ota_tlv_entry_t;
+
+/**
+ * @brief Image information filled by cy_ota_storage_get_image_tlv_info().
+ */
+typedef struct
+{
+    cy_ota_app_info_t   app_info;                   /**< [out] Version, company ID and product ID, as cy_ota_storage_get_app_info(). */
+    uint8_t             custom_count;               /**< [in] Number of entries used in custom. */
+    cy_ota_tlv_entry_t  custom[CY_OTA_TLV_CUSTOM_MAX];  /**< [in,out] Custom TLVs to extract. */
+} cy_ota_image_tlv_info_t;
+
+/**
+ * @brief Status of one slot of an image, filled by cy_ota_storage_get_images_status().
+ */
+typedef struct
+{
+    cy_rslt_t           result;             /**< CY_RSLT_SUCCESS if the slot trailer and state were read. */
+    cy_ota_slot_state_t state;              /**< Slot state, as returned by cy_ota_storage_get_slot_state(). */
+    uint8_t             pending_status;     /**< Swap type in the slot trailer, as returned by cy_ota_storage_get_boot_pending_status(). */
+    uint8_t             validate_status;    /**< image_ok flag in the slot trailer, as returned by cy_ota_storage_get_image_validate_status(). */
+    uint8_t             major;              /**< Image version major, 0 if the slot has no readable image. */
+    uint8_t             minor;              /**< Image version minor. */
+    uint16_t            revision;           /**< Image version revision, encoded as in cy_ota_storage_get_app_info(). */
+    uint32_t            build;              /**< Image version build number. */
+} cy_ota_slot_status_t;
+
+/**
+ * @brief Status of both slots of an image, filled by cy_ota_storage_get_images_status().
+ */
+typedef struct
+{
+    cy_ota_slot_status_t slot[2];           /**< Slot status, indexed by slot ID. */
+} cy_ota_image_status_t;
+
 /** \} group_ota_typedefs */
 
 #define APP_INACTIVE_SLOT   (APP_ACTIVE_SLOT ^ 1)
@@ -240,6 +298,24 @@ cy_rslt_t cy_ota_storage_get_image_validate_status(uint16_t app_id, uint8_t *sta
  */
 cy_rslt_t cy_ota_storage_get_app_info(uint16_t slot_id, uint16_t image_num, cy_ota_app_info_t *app_info);
 
+/**
+ * @brief Get Application image information and custom TLVs
+ *
+ * Reads the image header and walks the protected and unprotected TLV areas once,
+ * through a fixed size stack buffer.
+ *
+ * @param[in]        slot_id         Memory slot ID.
+ * @param[in]        image_num       Image number.
+ * @param[in,out]    info            Custom TLV types to look for, filled with the image information.
+ *
+ * @return  CY_RSLT_SUCCESS
+ *          CY_RSLT_OTA_ERROR_BADARG
+ *          CY_RSLT_OTA_ERROR_OPEN_STORAGE
+ *          CY_RSLT_OTA_ERROR_READ_STORAGE
+ *          CY_RSLT_OTA_ERROR_NO_IMAGE_INFO
+ */
+cy_rslt_t cy_ota_storage_get_image_tlv_info(uint16_t slot_id, uint16_t image_num, cy_ota_image_tlv_info_t *info);
+
 /**
  * @brief Get Application slot state information
  *
@@ -264,6 +340,23 @@ cy_rslt_t cy_ota_storage_get_slot_state(uint16_t slot_id, uint16_t image_num, cy
  */
 cy_rslt_t cy_ota_storage_set_slot_state(uint16_t slot_id, uint16_t image_num, cy_ota_slot_state_t state);
 
+/**
+ * @brief Get the status of both slots of several images in one call
+ *
+ * Each slot trailer and image header is read once, the slot state is derived from
+ * the trailer and the version comes from the header. status[n] describes image number n as used by
+ * cy_ota_storage_get_slot_state(), which is app_id n + 1 for
+ * cy_ota_storage_get_boot_pending_status() and cy_ota_storage_get_image_validate_status().
+ *
+ * @param[out]       status          Array of image_count records.
+ * @param[in]        image_count     Number of images to query, 1 to MCUBOOT_IMAGE_NUMBER.
+ *
+ * @return  CY_RSLT_SUCCESS
+ *          CY_RSLT_OTA_ERROR_BADARG
+ *          CY_RSLT_OTA_ERROR_GENERAL if any slot failed, see its result field
+ */
+cy_rslt_t cy_ota_storage_get_images_status(cy_ota_image_status_t *status, uint16_t image_count);
+
 
 /** \} group_ota_bootsupport_functions */
 
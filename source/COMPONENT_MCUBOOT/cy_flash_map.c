@@ -78,6 +78,7 @@
 #include "cy_ota_api.h"
 #include "cy_ota_bootloader_abstraction_log.h"
 #include "cy_ota_flash.h"
+#include "cy_ota_buffer_scan.h"
 
 #ifdef PSOC_064_2M
 /* Include flashmap header for PSoC64 kit */
@@ -123,6 +124,30 @@
 static uint8_t row_buff[PLATFORM_MAX_TRAILER_PAGE_SIZE];
 #endif
 
+/* Bumped by every write or erase issued through this backend */
+static uint32_t cy_flash_area_write_gen;
+
+/*
+ * With CY_OTA_FLASH_NON_BLOCKING, cy_flash_area_write_begin() copies internal flash writes to
+ * a static buffer and programs them with cy_ota_mem_write_begin(), so the caller can reuse its
+ * buffer. Rows after the first are programmed by cy_ota_mem_poll(), or by the next flash area
+ * call, which waits for the write.
+ */
+#if defined (CY_OTA_FLASH_NON_BLOCKING) && \
+    (defined(PSOC_062_2M) || defined(PSOC_062_1M) || defined(PSOC_062_512K) || defined(PSOC_063_1M) || defined(PSOC_064_2M) || \
+     defined (XMC7100) || defined(XMC7200))
+#define CY_FLASH_AREA_WRITE_ASYNC
+
+#ifndef CY_FLASH_AREA_WRITE_STAGE_SIZE
+#define CY_FLASH_AREA_WRITE_STAGE_SIZE     (4096u)
+#endif
+
+static uint8_t cy_flash_area_write_stage[CY_FLASH_AREA_WRITE_STAGE_SIZE];
+
+/* Failure of the write in progress, reported by cy_flash_area_write_complete() */
+static volatile cy_rslt_t cy_flash_area_write_stage_result;
+#endif
+
 /* This is not actually used by mcuboot's code but can be used by apps
  * when attempting to read/write a trailer.
     struct image_trailer {
@@ -164,6 +189,9 @@ struct cy_mcuboot_swap_state
 /* size of the boot_image_magic in mcuboot slot */
 #define CY_MCUBOOT_MAGIC_SZ   (sizeof(boot_img_magic))
 
+/* swap_info, copy_done, image_ok and magic, the contiguous end of the trailer */
+#define CY_MCUBOOT_TRAILER_TAIL_SZ   ((3u * BOOT_TRAILER_ALIGN) + CY_MCUBOOT_MAGIC_SZ)
+
 uint8_t cy_flash_area_erased_val(const struct flash_area *fap);
 
 /* Define DEBUG_PRINT_OPEN_AREA to print flash area info when area is opened */
@@ -262,6 +290,12 @@ int8_t cy_flash_area_read(const struct flash_area *fa, uint32_t off, void *dst,
     cy_rslt_t result = CY_RSLT_SUCCESS;
     size_t addr = 0;
 
+    /* Rows of a write started by cy_flash_area_write_begin() may still be programming */
+    if(cy_flash_area_write_complete() != 0)
+    {
+        return -1;
+    }
+
     /* check if requested offset not less then flash area (fa) start */
     if((NULL == fa) || (NULL == dst) || ((off > fa->fa_size) || (len > fa->fa_size) || ((off + len) > fa->fa_size)))
     {
@@ -302,18 +336,104 @@ int8_t cy_flash_area_read(const struct flash_area *fa, uint32_t off, void *dst,
     return 0;
 }
 
+/*< Returns a counter that changes whenever flash is written or erased through this backend */
+uint32_t cy_flash_area_get_write_gen(void)
+{
+    return cy_flash_area_write_gen;
+}
+
+#ifdef CY_FLASH_AREA_WRITE_ASYNC
+static void cy_flash_area_write_done(cy_rslt_t result, void *cb_arg)
+{
+    (void)cb_arg;
+    if(result != CY_RSLT_SUCCESS)
+    {
+        cy_flash_area_write_stage_result = result;
+    }
+}
+#endif
+
+/*< Waits for the write started by cy_flash_area_write_begin() and returns its result */
+int8_t cy_flash_area_write_complete(void)
+{
+#ifdef CY_FLASH_AREA_WRITE_ASYNC
+    cy_rslt_t result;
+
+    result = cy_ota_mem_complete();
+    if(result == CY_RSLT_SUCCESS)
+    {
+        result = cy_flash_area_write_stage_result;
+    }
+    cy_flash_area_write_stage_result = CY_RSLT_SUCCESS;
+
+    if(result != CY_RSLT_SUCCESS)
+    {
+        cy_ota_bootloader_abstraction_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "Flash area write error, result = [0x%X]", (uint32_t)result);
+        return -1;
+    }
+#endif
+    return 0;
+}
+
+/*< Starts writing `len` bytes of flash memory at `off`, the buffer at `src` can be reused on return */
+int8_t cy_flash_area_write_begin(const struct flash_area *fa, uint32_t off, const void *src, uint32_t len)
+{
+#ifdef CY_FLASH_AREA_WRITE_ASYNC
+    cy_rslt_t result;
+
+    /* One write in progress at a time, the stage buffer is reused */
+    if(cy_flash_area_write_complete() != 0)
+    {
+        return -1;
+    }
+
+    if((NULL == fa) || (fa->fa_device_id != CY_FLASH_DEVICE_INTERNAL_FLASH) || (len > sizeof(cy_flash_area_write_stage)))
+    {
+        return cy_flash_area_write(fa, off, src, len);
+    }
+
+    if((NULL == src) || ((off > fa->fa_size) || (len > fa->fa_size) || ((off + len) > fa->fa_size)))
+    {
+        return CY_MCUBOOT_ERR_BADARGS;
+    }
+
+    cy_flash_area_write_gen++;
+
+    (void)memcpy(cy_flash_area_write_stage, src, len);
+    result = cy_ota_mem_write_begin(CY_OTA_MEM_TYPE_INTERNAL_FLASH, fa->fa_off + off, cy_flash_area_write_stage, len,
+                                    cy_flash_area_write_done, NULL);
+    if(result != CY_RSLT_SUCCESS)
+    {
+        cy_flash_area_write_stage_result = CY_RSLT_SUCCESS;
+        cy_ota_bootloader_abstraction_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "Flash area write error, result = [0x%X]", (uint32_t)result);
+        return -1;
+    }
+
+    return 0;
+#else
+    return cy_flash_area_write(fa, off, src, len);
+#endif
+}
+
 /*< Writes `len` bytes of flash memory at `off` from the buffer at `src` */
 int8_t cy_flash_area_write(const struct flash_area *fa, uint32_t off, const void *src, uint32_t len)
 {
     cy_rslt_t result = CY_RSLT_SUCCESS;
     size_t addr = 0;
 
+    if(cy_flash_area_write_complete() != 0)
+    {
+        return -1;
+    }
+
     /* check if requested offset not less then flash area (fa) start */
     if((NULL == fa) || (NULL == src) || ((off > fa->fa_size) || (len > fa->fa_size) || ((off + len) > fa->fa_size)))
     {
         return CY_MCUBOOT_ERR_BADARGS;
     }
 
+    cy_flash_area_write_gen++;
+
     /* Add base of flash area and offset within the flash area */
     addr = fa->fa_off + off;
 
@@ -354,6 +474,11 @@ int8_t cy_flash_area_erase(const struct flash_area *fa, uint32_t off, uint32_t l
     cy_rslt_t result = CY_RSLT_SUCCESS;
     size_t addr = 0;
 
+    if(cy_flash_area_write_complete() != 0)
+    {
+        return -1;
+    }
+
     /* check if requested offset not less then flash area (fa) start */
     if(NULL == fa)
     {
@@ -365,6 +490,8 @@ int8_t cy_flash_area_erase(const struct flash_area *fa, uint32_t off, uint32_t l
         return (CY_MCUBOOT_ERR_BADARGS);
     }
 
+    cy_flash_area_write_gen++;
+
     /* Add base of flash area and offset within the flash area */
     addr = fa->fa_off + off;
 
@@ -520,22 +647,12 @@ int8_t cy_boot_write_magic(const struct flash_area *fap)
 
 bool cy_bootutil_buffer_is_filled(const void *buffer, uint8_t fill, size_t len)
 {
-    uint8_t *p;
-
     if(buffer == NULL || len == 0)
     {
         return false;
     }
 
-    for(p = (uint8_t *)buffer; len-- > 0; p++)
-    {
-        if(*p != fill)
-        {
-            return false;
-        }
-    }
-
-    return true;
+    return cy_ota_buffer_is_filled(buffer, fill, len);
 }
 
 bool cy_bootutil_buffer_is_erased(const struct flash_area *area,
@@ -571,6 +688,16 @@ static int boot_magic_decode(const uint8_t *magic)
     return CY_MCUBOOT_MAGIC_BAD;
 }
 
+/* Decode a trailer flag byte as read from flash */
+static uint8_t boot_flag_from_flash(const struct flash_area *fap, uint8_t flag)
+{
+    if(flag == cy_flash_area_erased_val(fap))
+    {
+        return CY_MCUBOOT_FLAG_UNSET;
+    }
+    return (uint8_t)boot_flag_decode(flag);
+}
+
 static int8_t boot_read_flag(const struct flash_area *fap, uint8_t *flag, uint32_t off)
 {
     int8_t rc;
@@ -580,14 +707,7 @@ static int8_t boot_read_flag(const struct flash_area *fap, uint8_t *flag, uint32
     {
         return CY_MCUBOOT_ERR_FLASH;
     }
-    if(*flag == cy_flash_area_erased_val(fap))
-    {
-        *flag = CY_MCUBOOT_FLAG_UNSET;
-    }
-    else
-    {
-        *flag = boot_flag_decode(*flag);
-    }
+    *flag = boot_flag_from_flash(fap, *flag);
 
     return 0;
 }
@@ -597,11 +717,6 @@ int cy_boot_read_image_ok(const struct flash_area *fap, uint8_t *image_ok)
     return boot_read_flag(fap, image_ok, boot_image_ok_off(fap));
 }
 
-static inline int boot_read_copy_done(const struct flash_area *fap, uint8_t *copy_done)
-{
-    return boot_read_flag(fap, copy_done, boot_copy_done_off(fap));
-}
-
 int8_t cy_boot_write_image_ok(const struct flash_area *fap)
 {
     uint32_t off;
@@ -643,6 +758,59 @@ int8_t cy_boot_write_swap_info(const struct flash_area *fap, uint8_t swap_type,
     return 0;
 }
 
+/**
+ * Program the end of the image trailer (swap_info, copy_done, image_ok and magic) with one write.
+ * The current contents are read once and the new fields are composed in RAM, the other bytes
+ * are written back unchanged. Nothing is written when the trailer already holds these values.
+ *
+ * @param fap               Flash area of the slot
+ * @param image_ok          Set the image_ok flag
+ * @param set_swap_info     Write swap_info
+ * @param swap_info         swap_info value, see BOOT_SET_SWAP_INFO()
+ *
+ * @return                  0 on success; nonzero on failure.
+ */
+static int8_t cy_boot_write_trailer_tail(const struct flash_area *fap, bool image_ok, bool set_swap_info, uint8_t swap_info)
+{
+    uint8_t tail[CY_MCUBOOT_TRAILER_TAIL_SZ];
+    uint8_t current[CY_MCUBOOT_TRAILER_TAIL_SZ];
+    uint32_t off;
+    int8_t rc;
+
+    off = boot_swap_info_off(fap);
+    rc = cy_flash_area_read(fap, off, current, sizeof(current));
+    if(rc != 0)
+    {
+        return CY_MCUBOOT_ERR_FLASH;
+    }
+    memcpy(tail, current, sizeof(tail));
+
+    /* boot_img_magic may be stored in external flash for XIP builds, it is copied to RAM here */
+    memcpy(&tail[boot_magic_off(fap) - off], &(boot_img_magic[0]), CY_MCUBOOT_MAGIC_SZ);
+    if(image_ok)
+    {
+        tail[boot_image_ok_off(fap) - off] = CY_MCUBOOT_FLAG_SET;
+    }
+    if(set_swap_info)
+    {
+        tail[boot_swap_info_off(fap) - off] = swap_info;
+    }
+
+    if(memcmp(tail, current, sizeof(tail)) == 0)
+    {
+        return 0;
+    }
+
+    rc = cy_flash_area_write(fap, off, tail, sizeof(tail));
+    cy_ota_bootloader_abstraction_log_msg(CYLF_MIDDLEWARE, CY_LOG_DEBUG, "%s() fap->off 0x%lx off 0x%lx rc %d\n", __func__, fap->fa_off, off, rc);
+    if(rc != 0)
+    {
+        return CY_MCUBOOT_ERR_FLASH;
+    }
+
+    return 0;
+}
+
 /**
  * Marks the image in the secondary slot as pending.  On the next reboot,
  * the system will perform a one-time boot of the the secondary slot image.
@@ -658,42 +826,30 @@ int8_t cy_flash_area_boot_set_pending(uint8_t image, uint8_t permanent)
 {
     const struct flash_area *fap;
     int8_t rc = 0;
+    bool image_ok = false;
+    bool set_swap_info = false;
+    uint8_t swap_info = 0;
 
-    rc = cy_flash_area_open(CY_FLASH_UPGRADE_AREA(CY_INACTIVE_SLOT, 0), &fap);
+    rc = cy_flash_area_open(CY_FLASH_UPGRADE_AREA(CY_INACTIVE_SLOT, image), &fap);
     if(rc == 0)
     {
-        rc = cy_boot_write_magic(fap);
-        cy_ota_bootloader_abstraction_log_msg(CYLF_MIDDLEWARE, CY_LOG_DEBUG, "%s() cy_boot_write_magic(fap) returned %d\n", __func__, rc);
-
         /*
          * Writing trailer flags doesn't work properly for internal flash. That's OK
          * because writing the magic does work and that's enough to trigger the update.
          */
         if( (fap->fa_device_id & CY_FLASH_DEVICE_EXTERNAL_FLAG) == CY_FLASH_DEVICE_EXTERNAL_FLAG)
         {
-            if((rc == 0) && permanent)
-            {
-                rc = cy_boot_write_image_ok(fap);
-                cy_ota_bootloader_abstraction_log_msg(CYLF_MIDDLEWARE, CY_LOG_DEBUG, "%s() cy_boot_write_image_ok(fap) returned %d\n", __func__, rc);
-            }
+            image_ok = (permanent != 0u);
 #if(CY_ENC_IMG != 1)
-            uint8_t swap_type = 0;
-            if(rc == 0)
-            {
-                if(permanent)
-                {
-                    swap_type = CY_MCUBOOT_SWAP_TYPE_PERM;
-                }
-                else
-                {
-                    swap_type = CY_MCUBOOT_SWAP_TYPE_TEST;
-                }
-                rc = cy_boot_write_swap_info(fap, swap_type, 0);
-                cy_ota_bootloader_abstraction_log_msg(CYLF_MIDDLEWARE, CY_LOG_DEBUG, "%s() cy_boot_write_swap_info(fap) returned %d\n", __func__, rc);
-            }
+            set_swap_info = true;
+            BOOT_SET_SWAP_INFO(swap_info, image, (permanent != 0u) ? CY_MCUBOOT_SWAP_TYPE_PERM : CY_MCUBOOT_SWAP_TYPE_TEST);
 #endif
         }
 
+        /* Magic, image_ok and swap_info in one program operation */
+        rc = cy_boot_write_trailer_tail(fap, image_ok, set_swap_info, swap_info);
+        cy_ota_bootloader_abstraction_log_msg(CYLF_MIDDLEWARE, CY_LOG_DEBUG, "%s() cy_boot_write_trailer_tail(fap) returned %d\n", __func__, rc);
+
         cy_flash_area_close(fap);
     }
 
@@ -736,20 +892,21 @@ int8_t cy_flash_area_boot_unset_pending(uint8_t image)
 
 int cy_boot_read_swap_state(const struct flash_area *fap, struct cy_mcuboot_swap_state *state)
 {
-    uint8_t magic[CY_MCUBOOT_MAGIC_SZ];
+    uint8_t tail[CY_MCUBOOT_TRAILER_TAIL_SZ];
+    uint8_t *magic;
     uint32_t off;
     uint8_t swap_info;
     int rc;
 
-    memset(&magic, 0x00, CY_MCUBOOT_MAGIC_SZ);
-
-    off = boot_magic_off(fap);
-    rc = cy_flash_area_read(fap, off, magic, CY_MCUBOOT_MAGIC_SZ);
+    /* One flash read for the whole trailer end, the fields are decoded from RAM */
+    off = boot_swap_info_off(fap);
+    rc = cy_flash_area_read(fap, off, tail, sizeof(tail));
     if(rc != 0)
     {
         return CY_MCUBOOT_ERR_FLASH;
     }
 
+    magic = &tail[boot_magic_off(fap) - off];
     if(cy_bootutil_buffer_is_erased(fap, magic, CY_MCUBOOT_MAGIC_SZ))
     {
         state->magic = CY_MCUBOOT_MAGIC_UNSET;
@@ -759,12 +916,7 @@ int cy_boot_read_swap_state(const struct flash_area *fap, struct cy_mcuboot_swap
         state->magic = boot_magic_decode(magic);
     }
 
-    off = boot_swap_info_off(fap);
-    rc = cy_flash_area_read(fap, off, &swap_info, sizeof swap_info);
-    if(rc != 0)
-    {
-        return CY_MCUBOOT_ERR_FLASH;
-    }
+    swap_info = tail[boot_swap_info_off(fap) - off];
 
     /* Extract the swap type and image number */
     state->swap_type = BOOT_GET_SWAP_TYPE(swap_info);
@@ -777,13 +929,139 @@ int cy_boot_read_swap_state(const struct flash_area *fap, struct cy_mcuboot_swap
         state->image_num = 0;
     }
 
-    rc = boot_read_copy_done(fap, &state->copy_done);
-    if (rc != 0)
+    state->copy_done = boot_flag_from_flash(fap, tail[boot_copy_done_off(fap) - off]);
+    state->image_ok  = boot_flag_from_flash(fap, tail[boot_image_ok_off(fap) - off]);
+
+    return 0;
+}
+
+/*
+ * The commit journal of a multi-image update is kept in the padding of the copy_done field of
+ * the first secondary slot trailer. MCUboot only reads the first byte of the field. The bytes
+ * are erased with the slot when a download starts, and then only have bits cleared.
+ */
+#define CY_BOOT_JOURNAL_MAGIC           (0xA5u)
+#define CY_BOOT_JOURNAL_OPEN            (0x3Cu)
+#define CY_BOOT_JOURNAL_CLOSED          (0x0Cu)     /* CY_BOOT_JOURNAL_OPEN with bits cleared */
+
+#define CY_BOOT_JOURNAL_MAGIC_IDX       (1u)
+#define CY_BOOT_JOURNAL_IMAGES_IDX      (2u)
+#define CY_BOOT_JOURNAL_CHECK_IDX       (3u)        /* ~images */
+#define CY_BOOT_JOURNAL_PERMANENT_IDX   (4u)
+#define CY_BOOT_JOURNAL_STATE_IDX       (5u)
+#define CY_BOOT_JOURNAL_TODO_IDX        (6u)        /* Bit cleared once the trailer of the image is written */
+
+/**
+ * Reads the commit journal and which of its images still have a pending trailer.
+ *
+ * @param journal           Journal read
+ *
+ * @return                  0 on success; CY_MCUBOOT_ERR_BADSTATUS when there is no journal.
+ */
+int8_t cy_flash_area_boot_read_journal(cy_flash_area_boot_journal_t *journal)
+{
+    const struct flash_area *fap;
+    struct cy_mcuboot_swap_state state;
+    uint8_t field[BOOT_TRAILER_ALIGN];
+    uint8_t image;
+    int8_t rc;
+
+    if(journal == NULL)
+    {
+        return CY_MCUBOOT_ERR_BADARGS;
+    }
+    memset(journal, 0x00, sizeof(*journal));
+
+    if(cy_flash_area_open(CY_FLASH_UPGRADE_AREA(CY_INACTIVE_SLOT, 0), &fap) != 0)
+    {
+        return CY_MCUBOOT_ERR_FLASH;
+    }
+    rc = cy_flash_area_read(fap, boot_copy_done_off(fap), field, sizeof(field));
+    cy_flash_area_close(fap);
+    if(rc != 0)
     {
         return CY_MCUBOOT_ERR_FLASH;
     }
 
-    return cy_boot_read_image_ok(fap, &state->image_ok);
+    if((field[CY_BOOT_JOURNAL_MAGIC_IDX] != CY_BOOT_JOURNAL_MAGIC) ||
+       ((uint8_t)(field[CY_BOOT_JOURNAL_IMAGES_IDX] ^ field[CY_BOOT_JOURNAL_CHECK_IDX]) != 0xFFu) ||
+       ((field[CY_BOOT_JOURNAL_STATE_IDX] != CY_BOOT_JOURNAL_OPEN) && (field[CY_BOOT_JOURNAL_STATE_IDX] != CY_BOOT_JOURNAL_CLOSED)))
+    {
+        return CY_MCUBOOT_ERR_BADSTATUS;
+    }
+
+    journal->images    = field[CY_BOOT_JOURNAL_IMAGES_IDX];
+    journal->committed = journal->images & (uint8_t)~field[CY_BOOT_JOURNAL_TODO_IDX];
+    journal->permanent = field[CY_BOOT_JOURNAL_PERMANENT_IDX];
+    journal->open      = (field[CY_BOOT_JOURNAL_STATE_IDX] == CY_BOOT_JOURNAL_OPEN) ? 1u : 0u;
+
+    for(image = 0; image < MCUBOOT_IMAGE_NUMBER; image++)
+    {
+        if(((journal->images & (1u << image)) != 0u) && (cy_flash_area_open(CY_FLASH_UPGRADE_AREA(CY_INACTIVE_SLOT, image), &fap) == 0))
+        {
+            if((cy_boot_read_swap_state(fap, &state) == 0) && (state.magic == CY_MCUBOOT_MAGIC_GOOD))
+            {
+                journal->pending |= (uint8_t)(1u << image);
+            }
+            cy_flash_area_close(fap);
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * Writes the commit journal. Until the slot is erased again, images can only be added to
+ * committed and a closed journal cannot be opened, the write is read back to check this.
+ *
+ * @param journal           Journal to write, pending is not stored
+ *
+ * @return                  0 on success; nonzero on failure.
+ */
+int8_t cy_flash_area_boot_write_journal(const cy_flash_area_boot_journal_t *journal)
+{
+    const struct flash_area *fap;
+    uint8_t field[BOOT_TRAILER_ALIGN];
+    uint8_t current[BOOT_TRAILER_ALIGN];
+    uint32_t off;
+    int8_t rc;
+
+    if(journal == NULL)
+    {
+        return CY_MCUBOOT_ERR_BADARGS;
+    }
+    if(cy_flash_area_open(CY_FLASH_UPGRADE_AREA(CY_INACTIVE_SLOT, 0), &fap) != 0)
+    {
+        return CY_MCUBOOT_ERR_FLASH;
+    }
+
+    off = boot_copy_done_off(fap);
+    rc = cy_flash_area_read(fap, off, current, sizeof(current));
+    if(rc == 0)
+    {
+        /* The copy_done flag itself is kept */
+        memcpy(field, current, sizeof(field));
+        field[CY_BOOT_JOURNAL_MAGIC_IDX]     = CY_BOOT_JOURNAL_MAGIC;
+        field[CY_BOOT_JOURNAL_IMAGES_IDX]    = journal->images;
+        field[CY_BOOT_JOURNAL_CHECK_IDX]     = (uint8_t)~journal->images;
+        field[CY_BOOT_JOURNAL_PERMANENT_IDX] = journal->permanent;
+        field[CY_BOOT_JOURNAL_STATE_IDX]     = (journal->open != 0u) ? CY_BOOT_JOURNAL_OPEN : CY_BOOT_JOURNAL_CLOSED;
+        field[CY_BOOT_JOURNAL_TODO_IDX]      = (uint8_t)~journal->committed;
+
+        if(memcmp(field, current, sizeof(field)) != 0)
+        {
+            rc = cy_flash_area_write(fap, off, field, sizeof(field));
+            if((rc == 0) &&
+               ((cy_flash_area_read(fap, off, current, sizeof(current)) != 0) || (memcmp(field, current, sizeof(field)) != 0)))
+            {
+                rc = CY_MCUBOOT_ERR_FLASH;
+            }
+        }
+    }
+    cy_flash_area_close(fap);
+
+    cy_ota_bootloader_abstraction_log_msg(CYLF_MIDDLEWARE, CY_LOG_DEBUG, "%s() images 0x%x committed 0x%x open %d rc %d\n", __func__, journal->images, journal->committed, journal->open, rc);
+    return (rc == 0) ? 0 : CY_MCUBOOT_ERR_FLASH;
 }
 
 /**
@@ -818,9 +1096,42 @@ int8_t cy_flash_area_boot_get_pending_status(uint8_t *boot_pending_status)
 }
 
 #ifdef CY_OTA_DIRECT_XIP
+#ifndef ENABLE_ON_THE_FLY_ENCRYPTION
+/**
+ * @brief Checks whether flash holding cur can be programmed to val without an erase.
+ *
+ * Programming only moves bits away from the erased state, so every bit that
+ * differs must still be in its erased state.
+ *
+ * @param cur       - current flash contents
+ * @param val       - requested contents
+ * @param len       - number of bytes to compare
+ * @param erase_val - flash erase value
+ *
+ * @return - true if a plain program produces val.
+ */
+static bool cy_boot_flag_programmable(const uint8_t *cur, const uint8_t *val, uint32_t len, uint8_t erase_val)
+{
+    uint32_t i;
+
+    for (i = 0U; i < len; i++)
+    {
+        if (((cur[i] ^ val[i]) & (cur[i] ^ erase_val)) != 0U)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+#endif
+
 /**
  * @brief Function sets img_ok flag value to primary image trailer.
  *
+ * The flag is programmed in place when that only clears bits, otherwise the
+ * trailer page is read, erased and rewritten.
+ *
  * @param address - address of img_ok flag in primary img trailer
  * @param value - value corresponding to img_ok set
  *
@@ -829,12 +1140,54 @@ int8_t cy_flash_area_boot_get_pending_status(uint8_t *boot_pending_status)
 static int cy_write_img_ok_value(cy_ota_mem_type_t mem_type, uint32_t address, uint8_t src)
 {
     cy_rslt_t result = CY_RSLT_SUCCESS;
+    uint8_t flag_buf[sizeof(uint64_t)];
+    uint8_t cur_buf[sizeof(uint64_t)];
 
     /* Accepting an arbitrary address */
     uint32_t row_mask = cy_ota_mem_get_erase_size(mem_type, address) - 1U;
     uint32_t erase_val = CY_BOOT_EXTERNAL_FLASH_ERASE_VALUE;
     uint32_t index = address & row_mask;
 
+    memset(flag_buf, (int)erase_val, sizeof(flag_buf));
+    flag_buf[0] = src;
+    cy_flash_area_write_gen++;
+
+#ifndef ENABLE_ON_THE_FLY_ENCRYPTION
+    /* Program the flag in place when it only moves bits away from the erased state */
+    result = cy_ota_mem_read(mem_type, address, cur_buf, sizeof(cur_buf));
+    if(result != CY_RSLT_SUCCESS)
+    {
+        cy_ota_bootloader_abstraction_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "\n cy_ota_mem_read failed with error 0x%lx \n", result);
+        return CY_MCUBOOT_ERR_FLASH;
+    }
+
+    if(memcmp(cur_buf, flag_buf, sizeof(flag_buf)) == 0)
+    {
+        return 0;
+    }
+
+    if(cy_boot_flag_programmable(cur_buf, flag_buf, sizeof(flag_buf), (uint8_t)erase_val))
+    {
+        result = cy_ota_mem_write(mem_type, address, (void *)flag_buf, sizeof(flag_buf));
+        cy_ota_bootloader_abstraction_log_msg(CYLF_MIDDLEWARE, CY_LOG_DEBUG, "cy_ota_mem_write() offset 0x%lx result %d\n", address, result);
+        if(result != CY_RSLT_SUCCESS)
+        {
+            cy_ota_bootloader_abstraction_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "\n cy_ota_mem_write failed with error 0x%lx \n", result);
+            return CY_MCUBOOT_ERR_FLASH;
+        }
+        return 0;
+    }
+#else
+    (void)cur_buf;
+#endif
+
+    /* The page copy below can only preserve a sector that fits in row_buff */
+    if(((row_mask + 1U) > sizeof(row_buff)) || ((index + sizeof(flag_buf)) > sizeof(row_buff)))
+    {
+        cy_ota_bootloader_abstraction_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "\n img_ok at 0x%lx needs an erase larger than the trailer page \n", address);
+        return CY_MCUBOOT_ERR_FLASH;
+    }
+
     result = cy_ota_mem_read(mem_type, (address & ~row_mask), row_buff, PLATFORM_MAX_TRAILER_PAGE_SIZE);
     if(result != CY_RSLT_SUCCESS)
     {
@@ -843,8 +1196,7 @@ static int cy_write_img_ok_value(cy_ota_mem_type_t mem_type, uint32_t address, u
     }
 
     /* Modifying the target byte */
-    memset(&row_buff[index], erase_val, sizeof(uint64_t));
-    row_buff[index] = src;
+    memcpy(&row_buff[index], flag_buf, sizeof(flag_buf));
 
     result = cy_ota_mem_erase(mem_type, (address & ~row_mask), PLATFORM_MAX_TRAILER_PAGE_SIZE);
     if(result != 0)
@@ -141,6 +141,10 @@
                                          FLASH_AREA_IMG_2_SECONDARY : \
                                          255)
 
+#define CY_FLASH_UPGRADE_AREA(x,y)    (((x) == 0) ?          \
+                                         CY_FLASH_AREA_IMAGE_PRIMARY(y) : \
+                                         CY_FLASH_AREA_IMAGE_SECONDARY(y))
+
 #else
 #warning "Image slot and flash area mapping is not defined"
 #endif
@@ -202,9 +206,18 @@ int8_t cy_flash_area_read(const struct flash_area *fa, uint32_t off, void *dst,
 /*< Writes `len` bytes of flash memory at `off` from the buffer at `src` */
 int8_t cy_flash_area_write(const struct flash_area *fa, uint32_t off, const void *src, uint32_t len);
 
+/*< Starts writing `len` bytes of flash memory at `off`, the buffer at `src` can be reused on return */
+int8_t cy_flash_area_write_begin(const struct flash_area *fa, uint32_t off, const void *src, uint32_t len);
+
+/*< Waits for the write started by cy_flash_area_write_begin() and returns its result */
+int8_t cy_flash_area_write_complete(void);
+
 /*< Erases `len` bytes of flash memory at `off` */
 int8_t cy_flash_area_erase(const struct flash_area *fa, uint32_t off, uint32_t len);
 
+/*< Returns a counter that changes whenever flash is written or erased through this backend */
+uint32_t cy_flash_area_get_write_gen(void);
+
 /* writes MAGIC, OK and swap_type */
 int8_t cy_flash_area_boot_set_pending(uint8_t image, uint8_t permanent);
 
@@ -220,4 +233,23 @@ int8_t cy_flash_area_boot_get_image_confirm_status(uint8_t *image_ok_status);
 /* Removes the Boot Magic of the image in the secondary slot. */
 int8_t cy_flash_area_boot_unset_pending(uint8_t image);
 
+/*
+ * Commit journal of a multi-image update, kept in the first secondary slot trailer.
+ * Bit n of each mask stands for image n.
+ */
+typedef struct cy_flash_area_boot_journal
+{
+    uint8_t images;     /* Images of the update */
+    uint8_t committed;  /* Images whose trailer has been written */
+    uint8_t pending;    /* Images whose secondary slot trailer is pending, read only */
+    uint8_t permanent;  /* permanent value of the trailers */
+    uint8_t open;       /* Nonzero until every trailer is written, or the written ones are cleared */
+} cy_flash_area_boot_journal_t;
+
+/* Reads the commit journal, fails with BADSTATUS when the first secondary slot has none */
+int8_t cy_flash_area_boot_read_journal(cy_flash_area_boot_journal_t *journal);
+
+/* Writes the commit journal */
+int8_t cy_flash_area_boot_write_journal(const cy_flash_area_boot_journal_t *journal);
+
 #endif /* __FLASH_MAP_BACKEND_H__ */
@@ -66,6 +66,8 @@
 #define CY_RSLT_SERIAL_FLASH_ERR_DMA         (cy_rslt_t)(CY_RSLT_CREATE(CY_RSLT_TYPE_ERROR, CY_RSLT_MODULE_BOARD_LIB_SERIAL_FLASH, 5))
 /** Read abort failed. QSPI block is busy. */
 #define CY_RSLT_SERIAL_FLASH_ERR_QSPI_BUSY   (cy_rslt_t)(CY_RSLT_CREATE(CY_RSLT_TYPE_ERROR, CY_RSLT_MODULE_BOARD_LIB_SERIAL_FLASH, 6))
+/** A previously started non-blocking operation is not yet complete */
+#define CY_RSLT_SERIAL_FLASH_ERR_OP_BUSY     (cy_rslt_t)(CY_RSLT_CREATE(CY_RSLT_TYPE_ERROR, CY_RSLT_MODULE_BOARD_LIB_SERIAL_FLASH, 7))
 
 /** \} group_ota_macros */
 
@@ -86,6 +88,42 @@ typedef enum
     CY_OTA_MEM_TYPE_NONE                     /**<  Default value.           */
 } cy_ota_mem_type_t;
 
+/**
+ * @brief Completion callback of the non-blocking memory operations.
+ *
+ * Called from cy_ota_mem_poll() or cy_ota_mem_complete() once the whole operation has finished.
+ *
+ * @param[in]   result     CY_RSLT_SUCCESS if the operation completed successfully, error code otherwise.
+ * @param[in]   cb_arg     Argument passed to cy_ota_mem_write_begin() or cy_ota_mem_erase_begin().
+ */
+typedef void (*cy_ota_mem_complete_cb_t)(cy_rslt_t result, void *cb_arg);
+
+/**
+ * @brief Commands used to read and program a memory.
+ *
+ * Widths are the number of data lines of the address and data phases: 1, 2, 4 or 8.
+ */
+typedef struct
+{
+    uint8_t     read_cmd;               /**< Read instruction                       */
+    uint8_t     read_addr_width;        /**< Data lines of the read address phase   */
+    uint8_t     read_data_width;        /**< Data lines of the read data phase      */
+    uint8_t     read_dummy_cycles;      /**< Dummy cycles between address and data  */
+    uint8_t     program_cmd;            /**< Program instruction                    */
+    uint8_t     program_addr_width;     /**< Data lines of the program address phase */
+    uint8_t     program_data_width;     /**< Data lines of the program data phase   */
+} cy_ota_mem_cmds_t;
+
+/**
+ * @brief Time of an erase, see @ref cy_ota_mem_get_erase_stats.
+ */
+typedef struct
+{
+    uint32_t    estimated_us;           /**< Sum of the expected times of the planned erase commands */
+    uint32_t    actual_us;              /**< Time the erase commands took, measured by status polling */
+    uint32_t    commands;               /**< Number of erase commands issued */
+} cy_ota_mem_erase_stats_t;
+
 /** \} group_ota_typedefs */
 
 /***********************************************************************
@@ -178,6 +216,126 @@ size_t cy_ota_mem_get_prog_size(cy_ota_mem_type_t mem_type, uint32_t addr);
  */
 size_t cy_ota_mem_get_erase_size(cy_ota_mem_type_t mem_type, uint32_t addr);
 
+/**
+ * @brief Start a session of memory operations
+ *
+ * With CY_XIP_SMIF_MODE_CHANGE, external flash program operations of a session share the
+ * XIP-off windows (at most CY_OTA_SMIF_XIP_OFF_MAX_US long) instead of each starting its own.
+ * Small writes are queued until the session ends or the memory is read or erased, so their
+ * errors may be reported by a later call. Sessions can be nested.
+ *
+ * @param[in]   mem_type   Memory type @ref cy_ota_mem_type_t
+ *
+ * @return  CY_RSLT_SUCCESS
+ */
+cy_rslt_t cy_ota_mem_session_begin(cy_ota_mem_type_t mem_type);
+
+/**
+ * @brief End a session of memory operations, programming the queued writes
+ *
+ * @param[in]   mem_type   Memory type @ref cy_ota_mem_type_t
+ *
+ * @return  CY_RSLT_SUCCESS on success
+ *          CY_RSLT_TYPE_ERROR if a queued write failed
+ */
+cy_rslt_t cy_ota_mem_session_end(cy_ota_mem_type_t mem_type);
+
+/**
+ * @brief Get the planned and measured time of the last erase of a memory type
+ *
+ * With CY_OTA_SMIF_ERASE_PLANNER external flash ranges are erased with a mix of the erase
+ * types the memory advertises in SFDP (and the commands of hybrid sector regions), picking the
+ * fastest combination for the range.
+ *
+ * @param[in]   mem_type   Memory type @ref cy_ota_mem_type_t
+ * @param[out]  stats      Erase statistics @ref cy_ota_mem_erase_stats_t
+ *
+ * @return  CY_RSLT_SUCCESS on success
+ *          CY_RSLT_TYPE_ERROR if erase planning is not used for the memory type
+ */
+cy_rslt_t cy_ota_mem_get_erase_stats(cy_ota_mem_type_t mem_type, cy_ota_mem_erase_stats_t *stats);
+
+/**
+ * @brief Get the commands used to read and program a memory type
+ *
+ * With CY_OTA_SMIF_FAST_CMDS external flash uses the widest read and program commands
+ * the memory advertises in SFDP, chosen by cy_ota_mem_init().
+ *
+ * @param[in]   mem_type   Memory type @ref cy_ota_mem_type_t
+ * @param[out]  cmds       Commands @ref cy_ota_mem_cmds_t
+ *
+ * @return  CY_RSLT_SUCCESS on success
+ *          CY_RSLT_SERIAL_FLASH_ERR_NOT_INITED if the memory is not initialized
+ *          CY_RSLT_TYPE_ERROR if the memory type is not command based
+ */
+cy_rslt_t cy_ota_mem_get_cmds(cy_ota_mem_type_t mem_type, cy_ota_mem_cmds_t *cmds);
+
+/**
+ * @brief Start a non-blocking write to flash, QSPI flash, or any other external memory type
+ *
+ * The operation is advanced by cy_ota_mem_poll() or cy_ota_mem_complete(). The data buffer
+ * must stay valid until the completion callback is called. Only one non-blocking operation
+ * can be in progress at a time. Backends without non-blocking support complete the write
+ * before returning and call the callback from this function. Blocking memory operations
+ * wait for the non-blocking operation in progress to complete first.
+ *
+ * @param[in]   mem_type   Memory type @ref cy_ota_mem_type_t
+ * @param[in]   addr       Starting address to write to.
+ * @param[in]   data       Pointer to the buffer containing the data to be written.
+ * @param[in]   len        Number of bytes to write.
+ * @param[in]   cb         Completion callback, can be NULL.
+ * @param[in]   cb_arg     Argument passed to the completion callback.
+ *
+ * @return  CY_RSLT_SUCCESS on success
+ *          CY_RSLT_SERIAL_FLASH_ERR_OP_BUSY if another non-blocking operation is in progress
+ *          CY_RSLT_TYPE_ERROR on failure
+ */
+cy_rslt_t cy_ota_mem_write_begin(cy_ota_mem_type_t mem_type, uint32_t addr, void *data, size_t len,
+                                 cy_ota_mem_complete_cb_t cb, void *cb_arg);
+
+/**
+ * @brief Start a non-blocking erase of flash, QSPI flash, or any other external memory type
+ *
+ * The operation is advanced by cy_ota_mem_poll() or cy_ota_mem_complete(). Only one
+ * non-blocking operation can be in progress at a time. Backends without non-blocking
+ * support complete the erase before returning and call the callback from this function.
+ *
+ * @param[in]   mem_type   Memory type @ref cy_ota_mem_type_t
+ * @param[in]   addr       Starting address to begin erasing.
+ * @param[in]   len        Number of bytes to erase.
+ * @param[in]   cb         Completion callback, can be NULL.
+ * @param[in]   cb_arg     Argument passed to the completion callback.
+ *
+ * @return  CY_RSLT_SUCCESS on success
+ *          CY_RSLT_SERIAL_FLASH_ERR_OP_BUSY if another non-blocking operation is in progress
+ *          CY_RSLT_TYPE_ERROR on failure
+ */
+cy_rslt_t cy_ota_mem_erase_begin(cy_ota_mem_type_t mem_type, uint32_t addr, size_t len,
+                                 cy_ota_mem_complete_cb_t cb, void *cb_arg);
+
+/**
+ * @brief Advance the non-blocking memory operation in progress
+ *
+ * Starts the next step of the operation once the current one has finished and calls the
+ * completion callback when the whole operation is done. The library itself only advances
+ * the operation inside its own flash calls. To keep it going in between, call this
+ * function periodically, for example from a timer callback or another task; PSoC 6 and
+ * XMC7000 internal flash update the operation state with interrupts masked.
+ *
+ * @return  CY_RSLT_SUCCESS if no operation is in progress (anymore)
+ *          CY_RSLT_SERIAL_FLASH_ERR_OP_BUSY if the operation is still in progress
+ *          CY_RSLT_TYPE_ERROR if the operation failed
+ */
+cy_rslt_t cy_ota_mem_poll(void);
+
+/**
+ * @brief Wait for the non-blocking memory operation in progress to complete
+ *
+ * @return  CY_RSLT_SUCCESS if no operation is in progress or it completed successfully
+ *          CY_RSLT_TYPE_ERROR if the operation failed
+ */
+cy_rslt_t cy_ota_mem_complete(void);
+
 /** \} group_ota_bootsupport_functions */
 
 /** \} group_ota_bootsupport */
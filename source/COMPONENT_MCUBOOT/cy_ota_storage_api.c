@@ -67,18 +67,70 @@
  *
  **********************************************************************/
 
+#if (defined (CY_OTA_IMAGE_VERIFICATION) || defined (CY_OTA_DIRECT_XIP))
+#ifdef MCUBOOT_IMAGE_NUMBER
+#define CY_OTA_SLOT_STATE_CACHE_IMAGES  MCUBOOT_IMAGE_NUMBER    /**< Images whose slot states are cached */
+#else
+#define CY_OTA_SLOT_STATE_CACHE_IMAGES  1                       /**< Images whose slot states are cached */
+#endif
+#endif /* (CY_OTA_IMAGE_VERIFICATION) || (CY_OTA_DIRECT_XIP) */
+
+#if (defined (CY_OTA_IMAGE_VERIFICATION) || defined (CY_OTA_DIRECT_XIP))
+#ifndef CY_OTA_TLV_SCAN_BUF_SIZE
+#define CY_OTA_TLV_SCAN_BUF_SIZE        64      /**< Stack buffer used to walk the TLV areas */
+#endif
+
+#if ((CY_OTA_TLV_SCAN_BUF_SIZE < 32) || (CY_OTA_TLV_SCAN_BUF_SIZE < CY_OTA_TLV_CUSTOM_DATA_SIZE))
+#error CY_OTA_TLV_SCAN_BUF_SIZE must hold an image header and CY_OTA_TLV_CUSTOM_DATA_SIZE bytes.
+#endif
+#endif /* (CY_OTA_IMAGE_VERIFICATION) || (CY_OTA_DIRECT_XIP) */
+
 /***********************************************************************
  *
  * Structures
  *
  **********************************************************************/
 
+#if (defined (CY_OTA_IMAGE_VERIFICATION) || defined (CY_OTA_DIRECT_XIP))
+/**
+ * @brief State of a single pass over an image's TLV areas.
+ */
+typedef struct cy_ota_tlv_reader
+{
+    const struct flash_area *fap;               /**< Slot being scanned                 */
+    uint32_t buf_off;                           /**< Area offset of buf[0]              */
+    uint32_t buf_len;                           /**< Valid bytes in buf                 */
+    uint8_t  buf[CY_OTA_TLV_SCAN_BUF_SIZE];     /**< Window of the slot                 */
+} cy_ota_tlv_reader_t;
+#endif /* (CY_OTA_IMAGE_VERIFICATION) || (CY_OTA_DIRECT_XIP) */
+
+#if (defined (CY_OTA_IMAGE_VERIFICATION) || defined (CY_OTA_DIRECT_XIP))
+/**
+ * @brief Cached state of one slot.
+ *
+ * The entry is valid while cy_flash_area_get_write_gen() still returns write_gen.
+ */
+typedef struct cy_ota_slot_state_cache
+{
+    bool                valid;      /**< Entry holds a state read from flash    */
+    uint32_t            write_gen;  /**< Flash write generation of the read     */
+    cy_ota_slot_state_t state;      /**< Slot state                             */
+} cy_ota_slot_state_cache_t;
+#endif /* (CY_OTA_IMAGE_VERIFICATION) || (CY_OTA_DIRECT_XIP) */
+
 /***********************************************************************
  *
  * Variables
  *
  **********************************************************************/
 
+#if (defined (CY_OTA_IMAGE_VERIFICATION) || defined (CY_OTA_DIRECT_XIP))
+/**
+ * @brief Slot states per image, indexed by image number and slot id.
+ */
+static cy_ota_slot_state_cache_t slot_state_cache[CY_OTA_SLOT_STATE_CACHE_IMAGES][2];
+#endif /* (CY_OTA_IMAGE_VERIFICATION) || (CY_OTA_DIRECT_XIP) */
+
 /***********************************************************************
  *
  * functions
@@ -99,6 +151,14 @@ cy_rslt_t cy_ota_storage_init(void)
 
     cy_ota_bootloader_abstraction_log_msg(CYLF_MIDDLEWARE, CY_LOG_DEBUG, "%s()\n", __func__);
     result = cy_ota_mem_init();
+    if(result == CY_RSLT_SUCCESS)
+    {
+        /* A failed recovery leaves no partial set pending, it does not stop a new download */
+        if(cy_ota_untar_recover_commit() != CY_RSLT_SUCCESS)
+        {
+            cy_ota_bootloader_abstraction_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "%s() interrupted TAR archive commit undone\n", __func__);
+        }
+    }
     return result;
 }
 
@@ -218,6 +278,14 @@ cy_rslt_t cy_ota_storage_close(cy_ota_storage_context_t *storage_ptr)
     {
         return CY_RSLT_OTA_ERROR_CLOSE_STORAGE;
     }
+
+    /* The last chunk may still be programming */
+    if(cy_flash_area_write_complete() != 0)
+    {
+        cy_ota_bootloader_abstraction_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "cy_flash_area_write_complete() failed\n");
+        cy_flash_area_close(fap);
+        return CY_RSLT_OTA_ERROR_CLOSE_STORAGE;
+    }
     cy_flash_area_close(fap);
 
     return CY_RSLT_SUCCESS;
@@ -240,6 +308,22 @@ cy_rslt_t cy_ota_storage_verify(cy_ota_storage_context_t *storage_ptr)
         return CY_RSLT_OTA_ERROR_VERIFY;
     }
 
+    if(cy_flash_area_write_complete() != 0)
+    {
+        cy_ota_bootloader_abstraction_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "cy_flash_area_write_complete() failed\n");
+        return CY_RSLT_OTA_ERROR_VERIFY;
+    }
+
+    if(storage_ptr->ota_is_tar_archive != 0)
+    {
+        /* The images of a TAR archive are validated, and marked pending, as one set */
+#ifdef CY_OTA_IMAGE_VERIFICATION
+        return cy_ota_untar_validate();
+#else
+        return cy_ota_untar_set_pending((storage_ptr->validate_after_reboot == 0));
+#endif
+    }
+
     cy_ota_bootloader_abstraction_log_msg(CYLF_MIDDLEWARE, CY_LOG_NOTICE, "Start boot_validate_slot_for_image_id() ... \n");
 
 #ifdef CY_OTA_IMAGE_VERIFICATION
@@ -321,6 +405,11 @@ cy_rslt_t cy_ota_storage_set_boot_pending(cy_ota_storage_context_t *storage_ptr)
         return CY_RSLT_OTA_ERROR_VERIFY;
     }
 
+    if(storage_ptr->ota_is_tar_archive != 0)
+    {
+        return cy_ota_untar_set_pending((storage_ptr->validate_after_reboot == 0));
+    }
+
     rc = cy_flash_area_boot_set_pending(0, (storage_ptr->validate_after_reboot == 0));
     if(rc != 0)
     {
@@ -407,113 +496,300 @@ cy_rslt_t cy_ota_storage_get_image_validate_status(uint16_t app_id, uint8_t *sta
     return CY_RSLT_SUCCESS;
 }
 
-cy_rslt_t cy_ota_storage_get_app_info(uint16_t slot_id, uint16_t image_num, cy_ota_app_info_t *app_info)
+#if (defined (CY_OTA_IMAGE_VERIFICATION) || defined (CY_OTA_DIRECT_XIP))
+/**
+ * @brief Return len bytes of the slot at off, refilling the scan buffer when needed
+ *
+ * @param[in]   reader  - TLV scan state
+ * @param[in]   off     - offset in the flash area
+ * @param[in]   len     - bytes needed, at most CY_OTA_TLV_SCAN_BUF_SIZE
+ * @param[out]  data    - pointer into the scan buffer
+ *
+ * @return  CY_RSLT_SUCCESS
+ *          CY_RSLT_OTA_ERROR_READ_STORAGE
+ */
+static cy_rslt_t cy_ota_tlv_reader_get(cy_ota_tlv_reader_t *reader, uint32_t off, uint32_t len, const uint8_t **data)
 {
-    cy_rslt_t result = CY_RSLT_SUCCESS;
+    uint32_t read_len;
 
-    cy_ota_bootloader_abstraction_log_msg(CYLF_MIDDLEWARE, CY_LOG_DEBUG, "%s \n", __func__);
+    if((len > CY_OTA_TLV_SCAN_BUF_SIZE) || (off > reader->fap->fa_size) || (len > (reader->fap->fa_size - off)))
+    {
+        return CY_RSLT_OTA_ERROR_READ_STORAGE;
+    }
 
-#if (defined (CY_OTA_IMAGE_VERIFICATION) || defined (CY_OTA_DIRECT_XIP))
-    const struct flash_area *fap;
-    struct image_version img_ver;
-    uint8_t *buffer = NULL;
-    uint16_t len = 0;
-    uint32_t off = 0;
-    int rc = 0;
+    if((off < reader->buf_off) || ((off + len) > (reader->buf_off + reader->buf_len)))
+    {
+        read_len = reader->fap->fa_size - off;
+        if(read_len > CY_OTA_TLV_SCAN_BUF_SIZE)
+        {
+            read_len = CY_OTA_TLV_SCAN_BUF_SIZE;
+        }
 
-    memset(&img_ver, 0x00, sizeof(img_ver));
-    rc = boot_get_image_version(image_num, slot_id, &img_ver);
-    if(rc == 0)
+        if(cy_flash_area_read(reader->fap, off, reader->buf, read_len) != 0)
+        {
+            cy_ota_bootloader_abstraction_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "cy_flash_area_read() failed at offset 0x%lx\n", off);
+            reader->buf_len = 0;
+            return CY_RSLT_OTA_ERROR_READ_STORAGE;
+        }
+        reader->buf_off = off;
+        reader->buf_len = read_len;
+    }
+
+    *data = &reader->buf[off - reader->buf_off];
+    return CY_RSLT_SUCCESS;
+}
+
+/**
+ * @brief Walk one TLV area and pick out the requested TLVs
+ *
+ * @param[in]       reader  - TLV scan state
+ * @param[in]       off     - offset of the TLV area info header
+ * @param[in]       magic   - expected TLV area magic
+ * @param[in,out]   info    - image information being filled
+ * @param[out]      next    - offset just past the TLV area
+ *
+ * @return  CY_RSLT_SUCCESS
+ *          CY_RSLT_OTA_ERROR_READ_STORAGE
+ *          CY_RSLT_OTA_ERROR_NO_IMAGE_INFO
+ */
+static cy_rslt_t cy_ota_tlv_scan_area(cy_ota_tlv_reader_t *reader, uint32_t off, uint16_t magic,
+                                      cy_ota_image_tlv_info_t *info, uint32_t *next)
+{
+    struct image_tlv_info tlv_info;
+    struct image_tlv tlv;
+    const uint8_t *data;
+    uint32_t end;
+    uint32_t copy_len;
+    cy_rslt_t result;
+    uint8_t i;
+
+    result = cy_ota_tlv_reader_get(reader, off, sizeof(tlv_info), &data);
+    if(result != CY_RSLT_SUCCESS)
     {
-        cy_ota_bootloader_abstraction_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR,"Image version %x.%x.%x\r\n", img_ver.iv_major, img_ver.iv_minor, img_ver.iv_build_num);
+        return result;
     }
-    else
+    memcpy(&tlv_info, data, sizeof(tlv_info));
+    if(tlv_info.it_magic != magic)
     {
-        cy_ota_bootloader_abstraction_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "boot_get_image_version failed\n");
         return CY_RSLT_OTA_ERROR_NO_IMAGE_INFO;
     }
 
-    app_info->app_id = image_num;
-    app_info->major = img_ver.iv_major;
-    app_info->minor = img_ver.iv_minor;
-    app_info->build = img_ver.iv_build_num;
-    app_info->revision = (img_ver.iv_revision >> 8);
-    app_info->slot = (img_ver.iv_revision & 0xFF);
+    end = off + tlv_info.it_tlv_tot;
+    off += sizeof(tlv_info);
 
-    /* Retrieve Company ID */
-    rc = boot_find_image_tlv_info(image_num, slot_id, CY_TLV_INDEX_COMPANY_ID, &len, &off);
-    if(rc == 0)
+    while((off + sizeof(tlv)) <= end)
     {
-        if(cy_flash_area_open(CY_FLASH_UPGRADE_AREA(slot_id, 0), &fap) != 0)
+        result = cy_ota_tlv_reader_get(reader, off, sizeof(tlv), &data);
+        if(result != CY_RSLT_SUCCESS)
         {
-            cy_ota_bootloader_abstraction_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "cy_flash_area_open failed\n");
-            return CY_RSLT_OTA_ERROR_OPEN_STORAGE;
+            return result;
         }
+        memcpy(&tlv, data, sizeof(tlv));
+        off += sizeof(tlv);
 
-        buffer = (uint8_t *)malloc(len);
-        if(buffer == NULL)
+        if((tlv.it_type == CY_TLV_INDEX_COMPANY_ID) || (tlv.it_type == CY_TLV_INDEX_PRODUCT_ID))
         {
-            return CY_RSLT_OTA_ERROR_OUT_OF_MEMORY;
+            if(tlv.it_len >= sizeof(uint16_t))
+            {
+                result = cy_ota_tlv_reader_get(reader, off, sizeof(uint16_t), &data);
+                if(result != CY_RSLT_SUCCESS)
+                {
+                    return result;
+                }
+                if(tlv.it_type == CY_TLV_INDEX_COMPANY_ID)
+                {
+                    info->app_info.company_id = (uint16_t)((data[0] << 8) | data[1]);
+                }
+                else
+                {
+                    info->app_info.product_id = (uint16_t)((data[0] << 8) | data[1]);
+                }
+            }
         }
-        memset(buffer, 0x00, len);
 
-        /* read TLV info into the buffer */
-        result = cy_flash_area_read(fap, off, (void *)buffer, len);
-        if(result != CY_RSLT_SUCCESS)
+        for(i = 0; i < info->custom_count; i++)
         {
-            cy_ota_bootloader_abstraction_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "cy_flash_area_read() failed with error 0x%lx for Company ID with offset : 0x%lx\n", off, (uint32_t)result);
-            result = CY_RSLT_OTA_ERROR_READ_STORAGE;
-        }
-        else
-        {
-            app_info->company_id = (uint16_t)((buffer[0] << 8) | buffer[1]);
+            if((info->custom[i].type == tlv.it_type) && (info->custom[i].len == 0))
+            {
+                info->custom[i].len = tlv.it_len;
+                copy_len = (tlv.it_len < CY_OTA_TLV_CUSTOM_DATA_SIZE) ? tlv.it_len : CY_OTA_TLV_CUSTOM_DATA_SIZE;
+                result = cy_ota_tlv_reader_get(reader, off, copy_len, &data);
+                if(result != CY_RSLT_SUCCESS)
+                {
+                    return result;
+                }
+                memcpy(info->custom[i].data, data, copy_len);
+            }
         }
-        free(buffer);
+
+        off += tlv.it_len;
     }
-    else
+
+    *next = end;
+    return CY_RSLT_SUCCESS;
+}
+#endif /* (CY_OTA_IMAGE_VERIFICATION) || (CY_OTA_DIRECT_XIP) */
+
+cy_rslt_t cy_ota_storage_get_image_tlv_info(uint16_t slot_id, uint16_t image_num, cy_ota_image_tlv_info_t *info)
+{
+    cy_rslt_t result = CY_RSLT_SUCCESS;
+
+    cy_ota_bootloader_abstraction_log_msg(CYLF_MIDDLEWARE, CY_LOG_DEBUG, "%s \n", __func__);
+
+    if((info == NULL) || (info->custom_count > CY_OTA_TLV_CUSTOM_MAX))
     {
-        app_info->company_id = 0xFFFF;
+        return CY_RSLT_OTA_ERROR_BADARG;
     }
 
-    /* Retrieve Product ID */
-    rc = boot_find_image_tlv_info(image_num, slot_id, CY_TLV_INDEX_PRODUCT_ID, &len, &off);
-    if(rc == 0)
+#if (defined (CY_OTA_IMAGE_VERIFICATION) || defined (CY_OTA_DIRECT_XIP))
+    cy_ota_tlv_reader_t reader;
+    struct image_header hdr;
+    const uint8_t *data;
+    uint32_t off = 0;
+    uint8_t fa_id;
+    uint8_t i;
+
+    memset(&info->app_info, 0x00, sizeof(info->app_info));
+    info->app_info.company_id = 0xFFFF;
+    info->app_info.product_id = 0xFFFF;
+    for(i = 0; i < info->custom_count; i++)
     {
-        if(cy_flash_area_open(CY_FLASH_UPGRADE_AREA(slot_id, 0), &fap) != 0)
-        {
-            cy_ota_bootloader_abstraction_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "cy_flash_area_open failed\n");
-            return CY_RSLT_OTA_ERROR_OPEN_STORAGE;
-        }
+        info->custom[i].len = 0;
+    }
 
-        buffer = (uint8_t *)malloc(len);
-        if(buffer == NULL)
-        {
-            return CY_RSLT_OTA_ERROR_OUT_OF_MEMORY;
-        }
-        memset(buffer, 0x00, len);
+    fa_id = (slot_id == 0) ? CY_FLASH_AREA_IMAGE_PRIMARY(image_num) : CY_FLASH_AREA_IMAGE_SECONDARY(image_num);
+    if(cy_flash_area_open(fa_id, &reader.fap) != 0)
+    {
+        cy_ota_bootloader_abstraction_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "cy_flash_area_open failed\n");
+        return CY_RSLT_OTA_ERROR_OPEN_STORAGE;
+    }
+    reader.buf_off = 0;
+    reader.buf_len = 0;
 
-        /* read TLV info into the buffer */
-        result = cy_flash_area_read(fap, off, (void *)buffer, len);
-        if(result != CY_RSLT_SUCCESS)
+    result = cy_ota_tlv_reader_get(&reader, 0, sizeof(hdr), &data);
+    if(result == CY_RSLT_SUCCESS)
+    {
+        memcpy(&hdr, data, sizeof(hdr));
+        if(hdr.ih_magic != IMAGE_MAGIC)
         {
-            cy_ota_bootloader_abstraction_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "cy_flash_area_read() failed with error 0x%lx for Product ID with offset : 0x%lx\n", off, (uint32_t)result);
-            result = CY_RSLT_OTA_ERROR_READ_STORAGE;
+            cy_ota_bootloader_abstraction_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "No image header in slot %d\n", slot_id);
+            result = CY_RSLT_OTA_ERROR_NO_IMAGE_INFO;
         }
-        else
+    }
+
+    if(result == CY_RSLT_SUCCESS)
+    {
+        cy_ota_bootloader_abstraction_log_msg(CYLF_MIDDLEWARE, CY_LOG_DEBUG, "Image version %x.%x.%x\r\n", hdr.ih_ver.iv_major, hdr.ih_ver.iv_minor, hdr.ih_ver.iv_build_num);
+        info->app_info.app_id = image_num;
+        info->app_info.major = hdr.ih_ver.iv_major;
+        info->app_info.minor = hdr.ih_ver.iv_minor;
+        info->app_info.build = hdr.ih_ver.iv_build_num;
+        info->app_info.revision = (hdr.ih_ver.iv_revision >> 8);
+        info->app_info.slot = (hdr.ih_ver.iv_revision & 0xFF);
+
+        /* Protected TLVs, when present, come first, followed by the unprotected TLVs */
+        off = (uint32_t)hdr.ih_hdr_size + hdr.ih_img_size;
+        if(hdr.ih_protect_tlv_size != 0)
         {
-            app_info->product_id = (uint16_t)((buffer[0] << 8) | buffer[1]);
+            result = cy_ota_tlv_scan_area(&reader, off, IMAGE_TLV_PROT_INFO_MAGIC, info, &off);
         }
-        free(buffer);
     }
-    else
+
+    if(result == CY_RSLT_SUCCESS)
     {
-        app_info->product_id = 0xFFFF;
+        result = cy_ota_tlv_scan_area(&reader, off, IMAGE_TLV_INFO_MAGIC, info, &off);
     }
+
+    cy_flash_area_close(reader.fap);
 #endif /* (CY_OTA_IMAGE_VERIFICATION) || (CY_OTA_DIRECT_XIP) */
 
     return result;
 }
 
+cy_rslt_t cy_ota_storage_get_app_info(uint16_t slot_id, uint16_t image_num, cy_ota_app_info_t *app_info)
+{
+    cy_rslt_t result = CY_RSLT_SUCCESS;
+
+    cy_ota_bootloader_abstraction_log_msg(CYLF_MIDDLEWARE, CY_LOG_DEBUG, "%s \n", __func__);
+
+#if (defined (CY_OTA_IMAGE_VERIFICATION) || defined (CY_OTA_DIRECT_XIP))
+    cy_ota_image_tlv_info_t info;
+
+    info.custom_count = 0;
+    result = cy_ota_storage_get_image_tlv_info(slot_id, image_num, &info);
+    if(result == CY_RSLT_SUCCESS)
+    {
+        *app_info = info.app_info;
+    }
+#endif /* (CY_OTA_IMAGE_VERIFICATION) || (CY_OTA_DIRECT_XIP) */
+
+    return result;
+}
+
+#if (defined (CY_OTA_IMAGE_VERIFICATION) || defined (CY_OTA_DIRECT_XIP))
+/**
+ * @brief Look up a cached slot state
+ *
+ * @param[in]   slot_id     - slot id
+ * @param[in]   image_num   - image number
+ * @param[out]  state       - cached state
+ *
+ * @return  true if state holds the current state of the slot
+ */
+static bool cy_ota_storage_get_cached_slot_state(uint16_t slot_id, uint16_t image_num, cy_ota_slot_state_t *state)
+{
+    cy_ota_slot_state_cache_t *entry;
+
+    if((image_num >= CY_OTA_SLOT_STATE_CACHE_IMAGES) || (slot_id > 1))
+    {
+        return false;
+    }
+
+    entry = &slot_state_cache[image_num][slot_id];
+    if((!entry->valid) || (entry->write_gen != cy_flash_area_get_write_gen()))
+    {
+        return false;
+    }
+
+    *state = entry->state;
+    return true;
+}
+
+/**
+ * @brief Remember a slot state read from flash
+ *
+ * @param[in]   slot_id     - slot id
+ * @param[in]   image_num   - image number
+ * @param[in]   write_gen   - flash write generation sampled before the read
+ * @param[in]   state       - state read
+ */
+static void cy_ota_storage_cache_slot_state(uint16_t slot_id, uint16_t image_num, uint32_t write_gen, cy_ota_slot_state_t state)
+{
+    cy_ota_slot_state_cache_t *entry;
+
+    if((image_num >= CY_OTA_SLOT_STATE_CACHE_IMAGES) || (slot_id > 1))
+    {
+        return;
+    }
+
+    entry = &slot_state_cache[image_num][slot_id];
+    entry->write_gen = write_gen;
+    entry->state     = state;
+    entry->valid     = true;
+}
+
+/**
+ * @brief Drop all cached slot states
+ *
+ * Used after trailer updates made by the bootloader library, which do not
+ * go through cy_flash_area_write().
+ */
+static void cy_ota_storage_invalidate_slot_states(void)
+{
+    memset(slot_state_cache, 0x00, sizeof(slot_state_cache));
+}
+#endif /* (CY_OTA_IMAGE_VERIFICATION) || (CY_OTA_DIRECT_XIP) */
+
 cy_rslt_t cy_ota_storage_get_slot_state(uint16_t slot_id, uint16_t image_num, cy_ota_slot_state_t *state)
 {
     cy_rslt_t result = CY_RSLT_SUCCESS;
@@ -523,8 +799,15 @@ cy_rslt_t cy_ota_storage_get_slot_state(uint16_t slot_id, uint16_t image_num, cy
 #if (defined (CY_OTA_IMAGE_VERIFICATION) || defined (CY_OTA_DIRECT_XIP))
     int rc = 0;
     boot_slot_state_t slot_state;
+    uint32_t write_gen;
+
+    if(cy_ota_storage_get_cached_slot_state(slot_id, image_num, state))
+    {
+        return CY_RSLT_SUCCESS;
+    }
 
     cy_ota_bootloader_abstraction_log_msg(CYLF_MIDDLEWARE, CY_LOG_DEBUG, "%s \n", __func__);
+    write_gen = cy_flash_area_get_write_gen();
     rc = boot_get_slot_state(image_num, slot_id, &slot_state);
     if(rc == 0)
     {
@@ -554,6 +837,11 @@ cy_rslt_t cy_ota_storage_get_slot_state(uint16_t slot_id, uint16_t image_num, cy
                 result = CY_RSLT_OTA_ERROR_UNSUPPORTED;
                 break;
         }
+
+        if(result == CY_RSLT_SUCCESS)
+        {
+            cy_ota_storage_cache_slot_state(slot_id, image_num, write_gen, *state);
+        }
     }
     else
     {
@@ -670,6 +958,8 @@ cy_rslt_t cy_ota_storage_set_slot_state(uint16_t slot_id, uint16_t image_num, cy
                 result = CY_RSLT_OTA_ERROR_UNSUPPORTED;
                 break;
         }
+
+        cy_ota_storage_invalidate_slot_states();
     }
     else
     {
@@ -67,6 +67,21 @@
  * defines & enums
  *
  **********************************************************************/
+/**
+ * \addtogroup group_ota_bootsupport_macros
+ * \{
+ */
+
+#ifndef CY_OTA_TLV_CUSTOM_MAX
+#define CY_OTA_TLV_CUSTOM_MAX           (4)     /**< Custom TLVs extracted by one cy_ota_storage_get_image_tlv_info() call. */
+#endif
+
+#ifndef CY_OTA_TLV_CUSTOM_DATA_SIZE
+#define CY_OTA_TLV_CUSTOM_DATA_SIZE     (32)    /**< Bytes kept from the value of each custom TLV. */
+#endif
+
+/** \} group_ota_bootsupport_macros */
+
 /**
  * \addtogroup group_ota_bootsupport_typedefs
  * \{
@@ -85,6 +100,26 @@ typedef enum
     CY_OTA_SLOT_STATE_UNKNOWN         /**<  Reserved. */
 } cy_ota_slot_state_t;
 
+/**
+ * @brief Custom TLV to extract with cy_ota_storage_get_image_tlv_info().
+ */
+typedef struct
+{
+    uint16_t type;                                  /**< [in] TLV type to look for. */
+    uint16_t len;                                   /**< [out] TLV length in the image, 0 if not found. */
+    uint8_t  data[CY_OTA_TLV_CUSTOM_DATA_SIZE];     /**< [out] First bytes of the TLV value. */
+} cy_ota_tlv_entry_t;
+
+/**
+ * @brief Image information filled by cy_ota_storage_get_image_tlv_info().
+ */
+typedef struct
+{
+    cy_ota_app_info_t   app_info;                   /**< [out] Version, company ID and product ID, as cy_ota_storage_get_app_info(). */
+    uint8_t             custom_count;               /**< [in] Number of entries used in custom. */
+    cy_ota_tlv_entry_t  custom[CY_OTA_TLV_CUSTOM_MAX];  /**< [in,out] Custom TLVs to extract. */
+} cy_ota_image_tlv_info_t;
+
 /** \} group_ota_typedefs */
 
 #define APP_INACTIVE_SLOT   (APP_ACTIVE_SLOT ^ 1)
@@ -148,6 +183,41 @@ cy_rslt_t cy_ota_storage_read(cy_ota_storage_context_t *storage_ptr, cy_ota_stor
  */
 cy_rslt_t cy_ota_storage_write(cy_ota_storage_context_t *storage_ptr, cy_ota_storage_write_info_t *chunk_info);
 
+/**
+ * @brief Validate every image the TAR archive wrote to a secondary slot
+ *
+ * @return      CY_RSLT_SUCCESS
+ *              CY_RSLT_OTA_ERROR_VERIFY
+ */
+cy_rslt_t cy_ota_untar_validate(void);
+
+/**
+ * @brief Validate, then set pending, all images of the TAR archive as one set
+ *
+ * No trailer is written unless every image validates. A commit journal in the
+ * image 0 secondary slot trailer records the pass, a failed trailer write
+ * clears the trailers already written. After such a rollback the archive has
+ * to be downloaded again.
+ *
+ * @param[in]   permanent       0 = run the images once, then confirm or revert
+ *                              1 = run the images forever
+ *
+ * @return      CY_RSLT_SUCCESS
+ *              CY_RSLT_OTA_ERROR_VERIFY
+ */
+cy_rslt_t cy_ota_untar_set_pending(uint8_t permanent);
+
+/**
+ * @brief Finish or undo a TAR archive commit interrupted by a reset
+ *
+ * Called from cy_ota_storage_init(). Acts only when the commit journal in the
+ * image 0 secondary slot trailer is still open.
+ *
+ * @return      CY_RSLT_SUCCESS
+ *              CY_RSLT_OTA_ERROR_VERIFY
+ */
+cy_rslt_t cy_ota_untar_recover_commit(void);
+
 /**
  * @brief Close Storage area for download
  *
@@ -239,6 +309,24 @@ cy_rslt_t cy_ota_storage_get_image_validate_status(uint16_t app_id, uint8_t *sta
  */
 cy_rslt_t cy_ota_storage_get_app_info(uint16_t slot_id, uint16_t image_num, cy_ota_app_info_t *app_info);
 
+/**
+ * @brief Get Application image information and custom TLVs
+ *
+ * Reads the image header and walks the protected and unprotected TLV areas once,
+ * through a fixed size stack buffer.
+ *
+ * @param[in]        slot_id         Memory slot ID.
+ * @param[in]        image_num       Image number.
+ * @param[in,out]    info            Custom TLV types to look for, filled with the image information.
+ *
+ * @return  CY_RSLT_SUCCESS
+ *          CY_RSLT_OTA_ERROR_BADARG
+ *          CY_RSLT_OTA_ERROR_OPEN_STORAGE
+ *          CY_RSLT_OTA_ERROR_READ_STORAGE
+ *          CY_RSLT_OTA_ERROR_NO_IMAGE_INFO
+ */
+cy_rslt_t cy_ota_storage_get_image_tlv_info(uint16_t slot_id, uint16_t image_num, cy_ota_image_tlv_info_t *info);
+
 /**
  * @brief Get Application slot state information
  *
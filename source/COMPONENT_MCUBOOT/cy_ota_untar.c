@@ -67,6 +67,7 @@
 #include "cy_result.h"
 #include "cy_json_parser.h"
 #include "cy_ota_bootloader_abstraction_log.h"
+#include "cy_ota_buffer_scan.h"
 
 /*************************************************************
  * Defines and enums
@@ -99,17 +100,7 @@
  ************************************************************/
 static uint8_t cy_untar_block_of_zeros( uint8_t *buffer, uint32_t size)
 {
-    while(size > 0)
-    {
-        if (*buffer != 0x00)
-        {
-            return 1;
-        }
-        buffer++;
-        size--;
-    }
-
-    return 0;
+    return (cy_ota_buffer_is_zero(buffer, size) ? 0 : 1);
 }
 
 static uint32_t cy_octal_string_to_u32(const char *octal_string)
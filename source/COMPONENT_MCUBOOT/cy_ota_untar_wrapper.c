@@ -49,6 +49,11 @@
 
 #include "cy_ota_untar.h"
 #include "cy_flash_map_backend.h"
+#include "cy_ota_flash.h"
+
+#ifdef CY_OTA_IMAGE_VERIFICATION
+#include "bootutil/bootutil.h"
+#endif
 
 /* define CY_TEST_APP_VERSION_IN_TAR to test the application version in the
  * TAR archive at start of OTA image download.
@@ -85,12 +90,37 @@
  *
  **********************************************************************/
 
+#if (MCUBOOT_IMAGE_NUMBER > 1)
+#define CY_OTA_UNTAR_MAX_IMAGES         (2)             /**< Images a tarball can update, NSPE is image 0, SPE is image 1 */
+#else
+#define CY_OTA_UNTAR_MAX_IMAGES         (1)             /**< Single-image build, only the NSPE image 0 has slots       */
+#endif
+
+#define CY_OTA_UNTAR_IMAGE_MAGIC        (0x96f3b83dUL)  /**< MCUboot image header magic                 */
+#define CY_OTA_UNTAR_TLV_INFO_MAGIC     (0x6907U)       /**< MCUboot unprotected TLV area magic         */
+#define CY_OTA_UNTAR_IMAGE_HDR_SIZE     (32)            /**< MCUboot image header size                  */
+#define CY_OTA_UNTAR_TLV_INFO_SIZE      (4)             /**< MCUboot TLV area info size                 */
+
 /***********************************************************************
  *
  * Structures
  *
  **********************************************************************/
 
+/**
+ * @brief Journal of the multi-image commit for the current tarball
+ *
+ * Bit n of each mask stands for image n.
+ */
+typedef struct cy_ota_untar_commit_journal
+{
+    uint8_t     written;        /**< Images written to their secondary slot by this session */
+    uint8_t     validated;      /**< Images whose secondary slot passed validation          */
+    uint8_t     committed;      /**< Images whose trailer has been written                  */
+    uint8_t     permanent;      /**< permanent value the committed trailers were written with */
+    uint32_t    write_gen;      /**< Flash write generation the journal was last updated at */
+} cy_ota_untar_commit_journal_t;
+
 /***********************************************************************
  *
  * Data & Variables
@@ -102,6 +132,11 @@
  */
 static cy_untar_context_t  ota_untar_context;
 
+/**
+ * @brief Commit journal for the images of the tar file
+ */
+static cy_ota_untar_commit_journal_t commit_journal;
+
 /**
  * @brief Structure for handling TAR Header for MTU Sizes less than 512
  */
@@ -154,7 +189,6 @@ static cy_untar_result_t ota_untar_write_callback(cy_untar_context_ptr ctxt, uin
     const struct flash_area *fap;
     cy_ota_storage_context_t *storage_ptr = (cy_ota_storage_context_t *)cb_arg;
 
-    (void)image;
     if((ctxt == NULL) || (buffer == NULL) || (storage_ptr == NULL))
     {
         return CY_UNTAR_ERROR;
@@ -183,13 +217,20 @@ static cy_untar_result_t ota_untar_write_callback(cy_untar_context_ptr ctxt, uin
         return CY_UNTAR_ERROR;
     }
 
+    if(image >= CY_OTA_UNTAR_MAX_IMAGES)
+    {
+        /* CY_FLASH_UPGRADE_AREA() would map the image back onto image 0's slot */
+        cy_ota_bootloader_abstraction_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "%s() image %d not in this build (MCUBOOT_IMAGE_NUMBER %d)\n", __func__, image, MCUBOOT_IMAGE_NUMBER);
+        return CY_UNTAR_ERROR;
+    }
+
     if(cy_flash_area_open(CY_FLASH_UPGRADE_AREA(APP_INACTIVE_SLOT, image), &fap) != 0)
     {
         cy_ota_bootloader_abstraction_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "%s() cy_flash_area_open(%d) failed\n", __func__, image);
         return CY_UNTAR_ERROR;
     }
 
-    if(cy_flash_area_write(fap, file_offset, buffer, chunk_size) != 0)
+    if(cy_flash_area_write_begin(fap, file_offset, buffer, chunk_size) != 0)
     {
         result = CY_RSLT_OTA_ERROR_WRITE_STORAGE;
     }
@@ -202,6 +243,7 @@ static cy_untar_result_t ota_untar_write_callback(cy_untar_context_ptr ctxt, uin
     }
 
     cy_flash_area_close(fap);
+    commit_journal.written |= (uint8_t)(1u << image);
 
     return CY_UNTAR_SUCCESS;
 }
@@ -219,45 +261,331 @@ static cy_untar_result_t cy_ota_untar_init_context(cy_ota_storage_context_t *sto
 {
     if(cy_untar_init( ctx_untar, ota_untar_write_callback, storage_ptr ) == CY_RSLT_SUCCESS)
     {
+        memset(&commit_journal, 0x00, sizeof(commit_journal));
         storage_ptr->ota_is_tar_archive  = 1;
         return CY_UNTAR_SUCCESS;
     }
     return CY_UNTAR_ERROR;
 }
 
-#if 0 /* keep if needed later */
 /**
- * @brief - set pending for the files contained in the TAR archive we just validated.
+ * @brief Check that an image landed completely in its secondary slot
  *
- * return   CY_UNTAR_SUCCESS
+ * Without CY_OTA_IMAGE_VERIFICATION this reads the image header and the TLV
+ * area info behind the image; a short or torn download leaves one of them
+ * without its magic.
+ *
+ * @param[in]   image   0 = NSPE, 1 = SPE
+ *
+ * @return  CY_RSLT_SUCCESS
+ *          CY_RSLT_OTA_ERROR_VERIFY
  */
-cy_untar_result_t cy_ota_untar_set_pending(void)
+static cy_rslt_t cy_ota_untar_validate_image(uint16_t image)
 {
-    uint16_t i;
-    uint16_t image = 0;
-    for (i = 0; i < ota_untar_context.num_files_in_json; i++ )
+#ifdef CY_OTA_IMAGE_VERIFICATION
+    fih_int fih_rc = 0;
+    FIH_CALL(boot_validate_slot_for_image_id, fih_rc, image, APP_INACTIVE_SLOT);
+    if(fih_rc != 0)
+    {
+        cy_ota_bootloader_abstraction_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "%s() boot_validate_slot_for_image_id(%d) failed\n", __func__, image);
+        return CY_RSLT_OTA_ERROR_VERIFY;
+    }
+    return CY_RSLT_SUCCESS;
+#else
+    const struct flash_area *fap;
+    uint8_t hdr[CY_OTA_UNTAR_IMAGE_HDR_SIZE];
+    uint8_t tlv[CY_OTA_UNTAR_TLV_INFO_SIZE];
+    uint32_t magic;
+    uint16_t hdr_size;
+    uint16_t prot_size;
+    uint32_t img_size;
+    uint16_t tlv_magic;
+    uint16_t tlv_tot;
+    uint32_t off;
+    cy_rslt_t result = CY_RSLT_OTA_ERROR_VERIFY;
+
+    if(cy_flash_area_open(CY_FLASH_UPGRADE_AREA(APP_INACTIVE_SLOT, image), &fap) != 0)
+    {
+        cy_ota_bootloader_abstraction_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "%s() cy_flash_area_open(%d) failed\n", __func__, image);
+        return CY_RSLT_OTA_ERROR_VERIFY;
+    }
+
+    /* ih_magic, ih_hdr_size, ih_protect_tlv_size and ih_img_size of struct image_header */
+    if(cy_flash_area_read(fap, 0, hdr, sizeof(hdr)) == 0)
+    {
+        memcpy(&magic, &hdr[0], sizeof(magic));
+        memcpy(&hdr_size, &hdr[8], sizeof(hdr_size));
+        memcpy(&prot_size, &hdr[10], sizeof(prot_size));
+        memcpy(&img_size, &hdr[12], sizeof(img_size));
+
+        if((magic == CY_OTA_UNTAR_IMAGE_MAGIC) && (img_size < fap->fa_size))
+        {
+            off = (uint32_t)hdr_size + prot_size + img_size;
+            if(((off + CY_OTA_UNTAR_TLV_INFO_SIZE) <= fap->fa_size) &&
+               (cy_flash_area_read(fap, off, tlv, sizeof(tlv)) == 0))
+            {
+                memcpy(&tlv_magic, &tlv[0], sizeof(tlv_magic));
+                memcpy(&tlv_tot, &tlv[2], sizeof(tlv_tot));
+                if((tlv_magic == CY_OTA_UNTAR_TLV_INFO_MAGIC) && ((off + tlv_tot) <= fap->fa_size))
+                {
+                    result = CY_RSLT_SUCCESS;
+                }
+            }
+        }
+    }
+    cy_flash_area_close(fap);
+
+    if(result != CY_RSLT_SUCCESS)
     {
-        if(strncmp(ota_untar_context.files[i].type, CY_FILE_TYPE_SPE, strlen(CY_FILE_TYPE_SPE)) == 0)
+        cy_ota_bootloader_abstraction_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "%s() image %d incomplete in secondary slot\n", __func__, image);
+    }
+    return result;
+#endif
+}
+
+/**
+ * @brief Validate every image of the tarball written to a secondary slot
+ *
+ * The result is kept in the commit journal and reused for as long as no flash
+ * write happens, so a retried commit does not read the images again.
+ *
+ * @return  CY_RSLT_SUCCESS
+ *          CY_RSLT_OTA_ERROR_VERIFY
+ */
+cy_rslt_t cy_ota_untar_validate(void)
+{
+    uint16_t image;
+
+    if(commit_journal.written == 0)
+    {
+        cy_ota_bootloader_abstraction_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "%s() no image written from the TAR archive\n", __func__);
+        return CY_RSLT_OTA_ERROR_VERIFY;
+    }
+
+    if(commit_journal.write_gen != cy_flash_area_get_write_gen())
+    {
+        commit_journal.validated = 0;
+    }
+
+    for(image = 0; image < CY_OTA_UNTAR_MAX_IMAGES; image++)
+    {
+        uint8_t bit = (uint8_t)(1u << image);
+
+        if(((commit_journal.written & bit) == 0) || ((commit_journal.validated & bit) != 0))
         {
-            image = 1;  /* The TFM code, cm0 */
+            continue;
         }
-        else if(strncmp(ota_untar_context.files[i].type, CY_FILE_TYPE_NSPE, strlen(CY_FILE_TYPE_NSPE)) == 0)
+        if(cy_ota_untar_validate_image(image) != CY_RSLT_SUCCESS)
         {
-            image = 0;  /* The application code, cm4 */
+            commit_journal.validated = 0;
+            return CY_RSLT_OTA_ERROR_VERIFY;
         }
-        else
+        commit_journal.validated |= bit;
+    }
+    commit_journal.write_gen = cy_flash_area_get_write_gen();
+
+    return CY_RSLT_SUCCESS;
+}
+
+/**
+ * @brief Clear the pending trailers of a commit and close its journal
+ *
+ * @param[in,out]   journal     journal of the commit, pending lists the trailers to clear
+ *
+ * @return  CY_RSLT_SUCCESS
+ *          CY_RSLT_OTA_ERROR_VERIFY
+ */
+static cy_rslt_t cy_ota_untar_undo_commit(cy_flash_area_boot_journal_t *journal)
+{
+    cy_rslt_t result = CY_RSLT_SUCCESS;
+    uint16_t image;
+
+    for(image = 0; image < CY_OTA_UNTAR_MAX_IMAGES; image++)
+    {
+        if(((journal->pending & (1u << image)) != 0) &&
+           (cy_flash_area_boot_unset_pending((uint8_t)image) != 0))
+        {
+            cy_ota_bootloader_abstraction_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "%s() cy_flash_area_boot_unset_pending(%d) failed\n", __func__, image);
+            result = CY_RSLT_OTA_ERROR_VERIFY;
+        }
+    }
+
+    journal->open = 0;
+    if(cy_flash_area_boot_write_journal(journal) != 0)
+    {
+        result = CY_RSLT_OTA_ERROR_VERIFY;
+    }
+    return result;
+}
+
+/**
+ * @brief Write the trailers of the images of the journal not committed yet
+ *
+ * The trailers are written from the highest image down, image 0 last. The journal
+ * in flash is updated after each trailer. Then the journal is closed.
+ *
+ * @param[in,out]   journal     open journal of the commit
+ *
+ * @return  CY_RSLT_SUCCESS
+ *          CY_RSLT_OTA_ERROR_VERIFY
+ */
+static cy_rslt_t cy_ota_untar_commit(cy_flash_area_boot_journal_t *journal)
+{
+    int16_t image;
+
+    for(image = (CY_OTA_UNTAR_MAX_IMAGES - 1); image >= 0; image--)
+    {
+        uint8_t bit = (uint8_t)(1u << image);
+
+        if(((journal->images & bit) == 0) || ((journal->committed & bit) != 0))
         {
-            /* unknown file type */
-            cy_ota_bootloader_abstraction_log_msg(CYLF_MIDDLEWARE, CY_LOG_DEBUG, "%d:%s BAD FILE TYPE %d: >%s<\n", __LINE__, __func__, i, ota_untar_context.files[i].type);
             continue;
         }
-        boot_set_pending(image, 0);
+        if(cy_flash_area_boot_set_pending((uint8_t)image, journal->permanent) != 0)
+        {
+            cy_ota_bootloader_abstraction_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "%s() cy_flash_area_boot_set_pending(%d) failed\n", __func__, image);
+            journal->pending |= bit;
+            return CY_RSLT_OTA_ERROR_VERIFY;
+        }
+        journal->committed |= bit;
+        journal->pending   |= bit;
+        if(cy_flash_area_boot_write_journal(journal) != 0)
+        {
+            return CY_RSLT_OTA_ERROR_VERIFY;
+        }
     }
 
-    return CY_UNTAR_SUCCESS;
+    /* Every trailer is written, a journal left open is closed by cy_ota_untar_recover_commit() */
+    journal->open = 0;
+    if(cy_flash_area_boot_write_journal(journal) != 0)
+    {
+        cy_ota_bootloader_abstraction_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "%s() closing the commit journal failed\n", __func__);
+    }
+    return CY_RSLT_SUCCESS;
+}
+
+/**
+ * @brief Set pending for all images of the TAR archive in one ordered pass
+ *
+ * Nothing is marked pending until every secondary slot written by this session
+ * has passed cy_ota_untar_validate(). The commit journal is then opened in the
+ * image 0 secondary slot trailer, and the trailers are written from the highest
+ * image down, so image 0, the one cy_ota_storage_get_boot_pending_status()
+ * reports, is written last and completes the commit. If a trailer write fails,
+ * every trailer of the set is cleared again and the journal is closed. A closed
+ * journal cannot be opened again until cy_ota_storage_open() erases the slot, so
+ * after a rollback the archive has to be downloaded again.
+ *
+ * @param[in]   permanent   0 = run the images once, then confirm or revert
+ *                          1 = run the images forever
+ *
+ * @return  CY_RSLT_SUCCESS
+ *          CY_RSLT_OTA_ERROR_VERIFY
+ */
+cy_rslt_t cy_ota_untar_set_pending(uint8_t permanent)
+{
+    cy_flash_area_boot_journal_t journal;
+    cy_rslt_t result;
 
+    result = cy_ota_untar_validate();
+    if(result != CY_RSLT_SUCCESS)
+    {
+        return result;
+    }
+
+    memset(&journal, 0x00, sizeof(journal));
+    journal.images    = commit_journal.written;
+    journal.committed = commit_journal.committed;
+    journal.pending   = commit_journal.committed;
+    journal.permanent = permanent;
+    journal.open      = 1;
+
+    /* The closed journal cannot be opened again to rewrite the trailers */
+    if((commit_journal.committed != 0) && (commit_journal.permanent != permanent))
+    {
+        cy_ota_bootloader_abstraction_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "%s() images already pending with permanent %d\n", __func__, commit_journal.permanent);
+        return CY_RSLT_OTA_ERROR_VERIFY;
+    }
+
+    /* Opened before the first trailer is written */
+    if((commit_journal.committed == 0) && (cy_flash_area_boot_write_journal(&journal) != 0))
+    {
+        cy_ota_bootloader_abstraction_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "%s() opening the commit journal failed\n", __func__);
+        return CY_RSLT_OTA_ERROR_VERIFY;
+    }
+    commit_journal.permanent = permanent;
+
+    result = cy_ota_untar_commit(&journal);
+    commit_journal.committed = journal.committed;
+    if(result != CY_RSLT_SUCCESS)
+    {
+        /* Roll back, no partial set of images is left pending */
+        (void)cy_ota_untar_undo_commit(&journal);
+        commit_journal.committed = 0;
+    }
+    /* Trailer writes do not touch the images, keep the validation */
+    commit_journal.write_gen = cy_flash_area_get_write_gen();
+
+    cy_ota_bootloader_abstraction_log_msg(CYLF_MIDDLEWARE, CY_LOG_DEBUG, "%s() written 0x%x committed 0x%x\n", __func__, commit_journal.written, commit_journal.committed);
+    return result;
+}
+
+/**
+ * @brief Finish or undo a TAR archive commit interrupted by a reset
+ *
+ * A commit journal left open in the image 0 secondary slot trailer means the
+ * trailer pass was cut short. When no image of the set has been installed by
+ * MCUboot yet, the images are validated again and the remaining trailers are
+ * written. When only part of the set was installed, or finishing fails, the
+ * trailers still pending are cleared; an image MCUboot already installed in test
+ * mode reverts at the next reset unless it is confirmed.
+ *
+ * @return  CY_RSLT_SUCCESS
+ *          CY_RSLT_OTA_ERROR_VERIFY
+ */
+cy_rslt_t cy_ota_untar_recover_commit(void)
+{
+    cy_flash_area_boot_journal_t journal;
+    cy_rslt_t result = CY_RSLT_SUCCESS;
+    uint8_t installed;
+    uint16_t image;
+
+    if((cy_flash_area_boot_read_journal(&journal) != 0) || (journal.open == 0))
+    {
+        return CY_RSLT_SUCCESS;
+    }
+    cy_ota_bootloader_abstraction_log_msg(CYLF_MIDDLEWARE, CY_LOG_NOTICE, "%s() images 0x%x committed 0x%x pending 0x%x\n", __func__, journal.images, journal.committed, journal.pending);
+
+    /* A committed image without a pending trailer has been installed by MCUboot */
+    installed = journal.committed & (uint8_t)~journal.pending;
+    if(installed == journal.images)
+    {
+        /* The whole set was committed before the journal could be closed */
+        journal.open = 0;
+        return (cy_flash_area_boot_write_journal(&journal) == 0) ? CY_RSLT_SUCCESS : CY_RSLT_OTA_ERROR_VERIFY;
+    }
+    if(installed != 0)
+    {
+        result = CY_RSLT_OTA_ERROR_VERIFY;
+    }
+    for(image = 0; (image < CY_OTA_UNTAR_MAX_IMAGES) && (result == CY_RSLT_SUCCESS); image++)
+    {
+        if((journal.images & (1u << image)) != 0)
+        {
+            result = cy_ota_untar_validate_image(image);
+        }
+    }
+    if(result == CY_RSLT_SUCCESS)
+    {
+        result = cy_ota_untar_commit(&journal);
+    }
+
+    if(result != CY_RSLT_SUCCESS)
+    {
+        (void)cy_ota_untar_undo_commit(&journal);
+    }
+    return result;
 }
-#endif
 
 /**
  * @brief Determine if tar or non-tar and call correct write function
@@ -268,7 +596,7 @@ cy_untar_result_t cy_ota_untar_set_pending(void)
  * @return  CY_UNTAR_SUCCESS
  *          CY_UNTAR_ERROR
  */
-cy_rslt_t cy_ota_storage_write(cy_ota_storage_context_t *storage_ptr, cy_ota_storage_write_info_t * const chunk_info)
+static cy_rslt_t cy_ota_storage_write_chunk(cy_ota_storage_context_t *storage_ptr, cy_ota_storage_write_info_t * const chunk_info)
 {
     cy_rslt_t result = CY_RSLT_SUCCESS;
     uint16_t copy_offset = 0;
@@ -452,7 +780,7 @@ cy_rslt_t cy_ota_storage_write(cy_ota_storage_context_t *storage_ptr, cy_ota_sto
 
         if(file_header.buffer_size)
         {
-            if(cy_flash_area_write(fap, 0, file_header.buffer, file_header.buffer_size) != 0)
+            if(cy_flash_area_write_begin(fap, 0, file_header.buffer, file_header.buffer_size) != 0)
             {
                 result = CY_RSLT_OTA_ERROR_WRITE_STORAGE;
             }
@@ -468,7 +796,8 @@ cy_rslt_t cy_ota_storage_write(cy_ota_storage_context_t *storage_ptr, cy_ota_sto
             }
         }
 
-        if(cy_flash_area_write(fap, chunk_info->offset, (chunk_info->buffer + copy_offset), chunk_info->size) != 0)
+        /* Programmed while the next chunk is received, cy_ota_storage_close() waits for the last one */
+        if(cy_flash_area_write_begin(fap, chunk_info->offset, (chunk_info->buffer + copy_offset), chunk_info->size) != 0)
         {
             result = CY_RSLT_OTA_ERROR_WRITE_STORAGE;
         }
@@ -484,3 +813,27 @@ cy_rslt_t cy_ota_storage_write(cy_ota_storage_context_t *storage_ptr, cy_ota_sto
 
     return CY_RSLT_SUCCESS;
 }
+
+/**
+ * @brief Write a chunk to storage, all flash writes of the chunk in one memory session
+ *
+ * @param[in]   storage_ptr     Pointer to the OTA Agent storage context @ref cy_ota_storage_context_t
+ * @param[in]   chunk_info      Pointer to chunk information
+ *
+ * @return  CY_RSLT_SUCCESS
+ *          CY_RSLT_OTA_ERROR_WRITE_STORAGE
+ */
+cy_rslt_t cy_ota_storage_write(cy_ota_storage_context_t *storage_ptr, cy_ota_storage_write_info_t * const chunk_info)
+{
+    cy_rslt_t result;
+
+    (void)cy_ota_mem_session_begin(CY_OTA_MEM_TYPE_EXTERNAL_FLASH);
+    result = cy_ota_storage_write_chunk(storage_ptr, chunk_info);
+    if((cy_ota_mem_session_end(CY_OTA_MEM_TYPE_EXTERNAL_FLASH) != CY_RSLT_SUCCESS) && (result == CY_RSLT_SUCCESS))
+    {
+        cy_ota_bootloader_abstraction_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "%s() WRITE FAILED\n", __func__);
+        result = CY_RSLT_OTA_ERROR_WRITE_STORAGE;
+    }
+
+    return result;
+}
@@ -0,0 +1,582 @@
+/*
+ * Copyright 2025, Cypress Semiconductor Corporation (an Infineon company) or
+ * an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+ *
+ * This software, including source code, documentation and related
+ * materials ("Software") is owned by Cypress Semiconductor Corporation
+ * or one of its affiliates ("Cypress") and is protected by and subject to
+ * worldwide patent protection (United States and foreign),
+ * United States copyright laws and international treaty provisions.
+ * Therefore, you may use this Software only as provided in the license
+ * agreement accompanying the software package from which you
+ * obtained this Software ("EULA").
+ * If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+ * non-transferable license to copy, modify, and compile the Software
+ * source code solely for use in connection with Cypress's
+ * integrated circuit products.  Any reproduction, modification, translation,
+ * compilation, or representation of this Software except as specified
+ * above is prohibited without the express written permission of Cypress.
+ *
+ * Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+ * reserves the right to make changes to the Software without notice. Cypress
+ * does not assume any liability arising out of the application or use of the
+ * Software or any product or circuit described in the Software. Cypress does
+ * not authorize its products for use in any products where a malfunction or
+ * failure of the Cypress product may reasonably be expected to result in
+ * significant property damage, injury or death ("High Risk Product"). By
+ * including Cypress's product in a High Risk Product, the manufacturer
+ * of such system or application assumes all risk of such use and in doing
+ * so agrees to indemnify Cypress against all liability.
+ */
+
+/*
+ * Deferred logging for the OTA bootloader abstraction library
+ *
+ * With ENABLE_OTA_BOOTLOADER_ABSTRACTION_DEFERRED_LOGS, log calls store the
+ * format string address, the raw arguments and copies of string arguments in a
+ * ring buffer. Formatting
+ * happens later, in cy_ota_bootloader_abstraction_log_flush() or on a host
+ * that reads the records.
+ */
+
+#include "cy_ota_bootloader_abstraction_log.h"
+
+#ifdef ENABLE_OTA_BOOTLOADER_ABSTRACTION_DEFERRED_LOGS
+
+#include <stdarg.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <string.h>
+
+/***********************************************************************
+ *
+ * Macros
+ *
+ **********************************************************************/
+
+#if ((CY_OTA_BOOTLOADER_ABSTRACTION_LOG_RING_SIZE & (CY_OTA_BOOTLOADER_ABSTRACTION_LOG_RING_SIZE - 1u)) != 0u)
+#error CY_OTA_BOOTLOADER_ABSTRACTION_LOG_RING_SIZE must be a power of 2.
+#endif
+
+#if ((CY_OTA_BOOTLOADER_ABSTRACTION_LOG_MAX_ARGS < 1u) || (CY_OTA_BOOTLOADER_ABSTRACTION_LOG_MAX_ARGS > 8u))
+#error CY_OTA_BOOTLOADER_ABSTRACTION_LOG_MAX_ARGS must be between 1 and 8.
+#endif
+
+#if ((CY_OTA_BOOTLOADER_ABSTRACTION_LOG_STRINGS_SIZE < 1u) || (CY_OTA_BOOTLOADER_ABSTRACTION_LOG_STRINGS_SIZE > 255u))
+#error CY_OTA_BOOTLOADER_ABSTRACTION_LOG_STRINGS_SIZE must be between 1 and 255.
+#endif
+
+#define CY_OTA_LOG_RING_MASK    (CY_OTA_BOOTLOADER_ABSTRACTION_LOG_RING_SIZE - 1u)
+
+/* Longest conversion specification replayed by cy_ota_bootloader_abstraction_log_flush() */
+#define CY_OTA_LOG_CONV_FMT_SIZE    (24u)
+
+/* Space for a '*' value written into a conversion specification, sign and terminator included */
+#define CY_OTA_LOG_INT_DIGITS       (12u)
+
+/***********************************************************************
+ *
+ * Structures
+ *
+ **********************************************************************/
+
+/**
+ * @brief Ring slot. state is 0 while a writer fills the slot, seq + 1 once the record is complete.
+ */
+typedef struct
+{
+    atomic_uint state;
+    cy_ota_bootloader_abstraction_log_record_t record;
+} cy_ota_log_slot_t;
+
+/**
+ * @brief Argument type of a conversion
+ */
+typedef enum
+{
+    CY_OTA_LOG_CONV_NONE = 0,   /* %n, long double or unknown, not replayed */
+    CY_OTA_LOG_CONV_PERCENT,    /* %%, no argument */
+    CY_OTA_LOG_CONV_INT,
+    CY_OTA_LOG_CONV_LONG,
+    CY_OTA_LOG_CONV_LLONG,
+    CY_OTA_LOG_CONV_PTR,
+    CY_OTA_LOG_CONV_STR,        /* Copied into the strings of the record */
+    CY_OTA_LOG_CONV_DOUBLE
+} cy_ota_log_conv_type_t;
+
+/**
+ * @brief One conversion of a format string
+ */
+typedef struct
+{
+    uint8_t type;               /* cy_ota_log_conv_type_t */
+    uint8_t stars;              /* '*' int arguments before the value */
+    bool    precision_star;     /* The last '*' is the precision */
+    int     precision;          /* Literal precision, -1 for none */
+} cy_ota_log_conv_t;
+
+/***********************************************************************
+ *
+ * Variables
+ *
+ **********************************************************************/
+
+static cy_ota_log_slot_t ota_log_ring[CY_OTA_BOOTLOADER_ABSTRACTION_LOG_RING_SIZE];
+
+/* Sequence number of the next record to write */
+static atomic_uint ota_log_head;
+
+/* Sequence number of the next record to read, only used by the reader */
+static uint32_t ota_log_tail;
+
+/* Records overwritten before they were read */
+static atomic_uint ota_log_dropped;
+
+/* Formatted message of cy_ota_bootloader_abstraction_log_flush(), only used by the reader */
+static char ota_log_line[CY_OTA_BOOTLOADER_ABSTRACTION_LOG_LINE_SIZE];
+
+/***********************************************************************
+ *
+ * functions
+ *
+ **********************************************************************/
+
+/**
+ * @brief Parse the conversion at fmt, which points past its '%'
+ *
+ * @param[in]   fmt     - conversion specification
+ * @param[out]  conv    - type, '*' and precision of the conversion
+ *
+ * @return  address past the conversion character
+ */
+static const char *cy_ota_log_parse_conv(const char *fmt, cy_ota_log_conv_t *conv)
+{
+    uint8_t longs = 0;
+    bool in_precision = false;
+
+    memset(conv, 0x00, sizeof(*conv));
+    conv->precision = -1;
+
+    /* flags, width and precision */
+    while((*fmt != '\0') && (strchr("-+ #0123456789.*", *fmt) != NULL))
+    {
+        if(*fmt == '.')
+        {
+            in_precision = true;
+            conv->precision = 0;
+        }
+        else if(*fmt == '*')
+        {
+            conv->stars++;
+            conv->precision_star = in_precision;
+        }
+        else if(in_precision && (*fmt >= '0') && (*fmt <= '9'))
+        {
+            conv->precision = (conv->precision * 10) + (*fmt - '0');
+        }
+        fmt++;
+    }
+
+    /* length modifiers, 'L' (long double) is not supported */
+    while((*fmt != '\0') && (strchr("hlLjzt", *fmt) != NULL))
+    {
+        if(*fmt == 'L')
+        {
+            return fmt;
+        }
+        if((*fmt == 'l') || (*fmt == 'j'))
+        {
+            longs++;
+        }
+        fmt++;
+    }
+
+    switch(*fmt)
+    {
+        case '%':
+            conv->type = CY_OTA_LOG_CONV_PERCENT;
+            break;
+
+        case 'd': case 'i': case 'u': case 'x': case 'X': case 'o': case 'c':
+            conv->type = (longs >= 2u) ? CY_OTA_LOG_CONV_LLONG : ((longs == 1u) ? CY_OTA_LOG_CONV_LONG : CY_OTA_LOG_CONV_INT);
+            break;
+
+        case 'p':
+            conv->type = CY_OTA_LOG_CONV_PTR;
+            break;
+
+        case 's':
+            conv->type = CY_OTA_LOG_CONV_STR;
+            break;
+
+        case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': case 'a': case 'A':
+            conv->type = CY_OTA_LOG_CONV_DOUBLE;
+            break;
+
+        default:
+            /* %n and unknown conversions are not replayed */
+            return fmt;
+    }
+
+    return fmt + 1;
+}
+
+/* Argument words taken by a value of the conversion type */
+static uint8_t cy_ota_log_conv_words(uint8_t type)
+{
+    switch(type)
+    {
+        case CY_OTA_LOG_CONV_PERCENT:
+            return 0u;
+        case CY_OTA_LOG_CONV_LONG:
+            return (uint8_t)((sizeof(long) + 3u) / 4u);
+        case CY_OTA_LOG_CONV_PTR:
+            return (uint8_t)((sizeof(void *) + 3u) / 4u);
+        case CY_OTA_LOG_CONV_LLONG:
+        case CY_OTA_LOG_CONV_DOUBLE:
+            return 2u;
+        default:
+            return 1u;
+    }
+}
+
+/**
+ * @brief Copy a %s argument into the string area of the record
+ *
+ * The copy is truncated to the precision of the conversion and to the space left.
+ *
+ * @param[in]   str         - string argument
+ * @param[in]   precision   - precision of the conversion, -1 for none
+ * @param[out]  record      - record being filled
+ *
+ * @return  offset of the copy in record->strings
+ */
+static uint32_t cy_ota_log_capture_string(const char *str, int precision, cy_ota_bootloader_abstraction_log_record_t *record)
+{
+    uint32_t offset = record->strings_used;
+    uint32_t len = 0;
+
+    if(str == NULL)
+    {
+        str = "(null)";
+    }
+    if(offset >= (sizeof(record->strings) - 1u))
+    {
+        /* No space left, the last byte is always the terminator */
+        return sizeof(record->strings) - 1u;
+    }
+
+    while((str[len] != '\0') && ((offset + len) < (sizeof(record->strings) - 1u)) &&
+          ((precision < 0) || (len < (uint32_t)precision)))
+    {
+        record->strings[offset + len] = str[len];
+        len++;
+    }
+    record->strings[offset + len] = '\0';
+    record->strings_used = (uint8_t)(offset + len + 1u);
+
+    return offset;
+}
+
+/**
+ * @brief Store the arguments of fmt as raw words
+ *
+ * Walks the conversions of fmt and takes each argument with its promoted type.
+ * Strings are copied into the record. Capture stops at a conversion that does not fit.
+ *
+ * @param[in]   fmt     - printf style format string
+ * @param[in]   ap      - arguments
+ * @param[out]  record  - record being filled
+ */
+static void cy_ota_log_capture_args(const char *fmt, va_list ap, cy_ota_bootloader_abstraction_log_record_t *record)
+{
+    cy_ota_log_conv_t conv;
+    uint8_t count = 0;
+    uint64_t value;
+    uint8_t index;
+
+    record->strings_used = 0;
+    record->strings[sizeof(record->strings) - 1u] = '\0';
+
+    while(*fmt != '\0')
+    {
+        if(*fmt++ != '%')
+        {
+            continue;
+        }
+
+        fmt = cy_ota_log_parse_conv(fmt, &conv);
+        if(conv.type == CY_OTA_LOG_CONV_NONE)
+        {
+            break;
+        }
+        if(((uint32_t)count + conv.stars + cy_ota_log_conv_words(conv.type)) > CY_OTA_BOOTLOADER_ABSTRACTION_LOG_MAX_ARGS)
+        {
+            break;
+        }
+
+        /* '*' takes an int argument, a negative precision is none */
+        for(index = 0; index < conv.stars; index++)
+        {
+            record->args[count] = (uint32_t)va_arg(ap, int);
+            if(conv.precision_star && (index == (conv.stars - 1u)))
+            {
+                conv.precision = (int)record->args[count];
+            }
+            count++;
+        }
+
+        switch(conv.type)
+        {
+            case CY_OTA_LOG_CONV_PERCENT:
+                continue;
+            case CY_OTA_LOG_CONV_INT:
+                value = (uint64_t)(unsigned int)va_arg(ap, int);
+                break;
+            case CY_OTA_LOG_CONV_LONG:
+                value = (uint64_t)(unsigned long)va_arg(ap, long);
+                break;
+            case CY_OTA_LOG_CONV_LLONG:
+                value = (uint64_t)va_arg(ap, long long);
+                break;
+            case CY_OTA_LOG_CONV_PTR:
+                value = (uint64_t)(uintptr_t)va_arg(ap, void *);
+                break;
+            case CY_OTA_LOG_CONV_STR:
+                value = cy_ota_log_capture_string(va_arg(ap, const char *), conv.precision, record);
+                break;
+            default:
+            {
+                double d = va_arg(ap, double);
+                memcpy(&value, &d, sizeof(value));
+                break;
+            }
+        }
+
+        /* Low word first */
+        for(index = 0; index < cy_ota_log_conv_words(conv.type); index++)
+        {
+            record->args[count++] = (uint32_t)value;
+            value >>= 32;
+        }
+    }
+
+    record->arg_count = count;
+}
+
+cy_rslt_t cy_ota_bootloader_abstraction_log_deferred(CY_LOG_FACILITY_T facility, CY_LOG_LEVEL_T level, const char *fmt, ...)
+{
+    cy_ota_log_slot_t *slot;
+    uint32_t seq;
+    va_list ap;
+
+    if((fmt == NULL) || (level > cy_log_get_facility_level(facility)))
+    {
+        return CY_RSLT_SUCCESS;
+    }
+
+    /* Claim a slot, the oldest record is overwritten when the ring is full */
+    seq = atomic_fetch_add_explicit(&ota_log_head, 1u, memory_order_relaxed);
+    slot = &ota_log_ring[seq & CY_OTA_LOG_RING_MASK];
+    atomic_store_explicit(&slot->state, 0u, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+
+    slot->record.seq      = seq;
+    slot->record.fmt      = fmt;
+    slot->record.facility = (uint8_t)facility;
+    slot->record.level    = (uint8_t)level;
+    va_start(ap, fmt);
+    cy_ota_log_capture_args(fmt, ap, &slot->record);
+    va_end(ap);
+
+    atomic_store_explicit(&slot->state, seq + 1u, memory_order_release);
+
+    return CY_RSLT_SUCCESS;
+}
+
+bool cy_ota_bootloader_abstraction_log_read(cy_ota_bootloader_abstraction_log_record_t *record)
+{
+    cy_ota_log_slot_t *slot;
+    uint32_t head;
+    uint32_t state;
+
+    if(record == NULL)
+    {
+        return false;
+    }
+
+    for(;;)
+    {
+        head = atomic_load_explicit(&ota_log_head, memory_order_acquire);
+        if(ota_log_tail == head)
+        {
+            return false;
+        }
+
+        /* Skip what writers have already lapped */
+        if((head - ota_log_tail) > CY_OTA_BOOTLOADER_ABSTRACTION_LOG_RING_SIZE)
+        {
+            atomic_fetch_add_explicit(&ota_log_dropped, (head - ota_log_tail) - CY_OTA_BOOTLOADER_ABSTRACTION_LOG_RING_SIZE, memory_order_relaxed);
+            ota_log_tail = head - CY_OTA_BOOTLOADER_ABSTRACTION_LOG_RING_SIZE;
+        }
+
+        slot = &ota_log_ring[ota_log_tail & CY_OTA_LOG_RING_MASK];
+        state = atomic_load_explicit(&slot->state, memory_order_acquire);
+        if(state == 0u)
+        {
+            /* A writer is still filling this slot */
+            return false;
+        }
+
+        memcpy(record, &slot->record, sizeof(*record));
+        atomic_thread_fence(memory_order_acquire);
+
+        if((state == (ota_log_tail + 1u)) &&
+           (atomic_load_explicit(&slot->state, memory_order_relaxed) == state))
+        {
+            ota_log_tail++;
+            return true;
+        }
+
+        /* Overwritten while being read, or not yet written for this lap */
+        if(state == (ota_log_tail + 1u - CY_OTA_BOOTLOADER_ABSTRACTION_LOG_RING_SIZE))
+        {
+            return false;
+        }
+        atomic_fetch_add_explicit(&ota_log_dropped, 1u, memory_order_relaxed);
+        ota_log_tail++;
+    }
+}
+
+/**
+ * @brief Format a record into ota_log_line
+ *
+ * Each conversion is formatted on its own with the argument rebuilt from its words,
+ * so 64-bit and double arguments keep their calling convention. The text from a
+ * conversion without captured arguments on is copied unformatted.
+ *
+ * @param[in]   record  - record to format
+ */
+static void cy_ota_log_format(const cy_ota_bootloader_abstraction_log_record_t *record)
+{
+    const char *fmt = record->fmt;
+    const char *spec;
+    cy_ota_log_conv_t conv;
+    char conv_fmt[CY_OTA_LOG_CONV_FMT_SIZE];
+    size_t pos = 0;
+    size_t conv_len;
+    uint8_t count = 0;
+    uint8_t index;
+    uint64_t value;
+    double d;
+    int len;
+
+    while((*fmt != '\0') && (pos < (sizeof(ota_log_line) - 1u)))
+    {
+        if(*fmt != '%')
+        {
+            ota_log_line[pos++] = *fmt++;
+            continue;
+        }
+
+        spec = fmt;
+        fmt = cy_ota_log_parse_conv(fmt + 1, &conv);
+        conv_len = 0;
+        if((conv.type != CY_OTA_LOG_CONV_NONE) &&
+           ((count + conv.stars + cy_ota_log_conv_words(conv.type)) <= record->arg_count))
+        {
+            /* Copy the specification with '*' replaced by its captured value */
+            while((spec < fmt) && (conv_len < (sizeof(conv_fmt) - CY_OTA_LOG_INT_DIGITS)))
+            {
+                if(*spec == '*')
+                {
+                    conv_len += (size_t)snprintf(&conv_fmt[conv_len], CY_OTA_LOG_INT_DIGITS, "%d", (int)record->args[count++]);
+                }
+                else
+                {
+                    conv_fmt[conv_len++] = *spec;
+                }
+                spec++;
+            }
+        }
+        if((conv_len == 0u) || (spec < fmt))
+        {
+            /* Not captured, the rest of the format is copied as is */
+            fmt = spec;
+            while((*fmt != '\0') && (pos < (sizeof(ota_log_line) - 1u)))
+            {
+                ota_log_line[pos++] = *fmt++;
+            }
+            break;
+        }
+        conv_fmt[conv_len] = '\0';
+
+        value = 0;
+        for(index = cy_ota_log_conv_words(conv.type); index > 0u; index--)
+        {
+            value <<= 32;
+            value |= record->args[count + index - 1u];
+        }
+        count += cy_ota_log_conv_words(conv.type);
+
+        switch(conv.type)
+        {
+            case CY_OTA_LOG_CONV_PERCENT:
+                len = snprintf(&ota_log_line[pos], sizeof(ota_log_line) - pos, "%%");
+                break;
+            case CY_OTA_LOG_CONV_INT:
+                len = snprintf(&ota_log_line[pos], sizeof(ota_log_line) - pos, conv_fmt, (unsigned int)value);
+                break;
+            case CY_OTA_LOG_CONV_LONG:
+                len = snprintf(&ota_log_line[pos], sizeof(ota_log_line) - pos, conv_fmt, (unsigned long)value);
+                break;
+            case CY_OTA_LOG_CONV_LLONG:
+                len = snprintf(&ota_log_line[pos], sizeof(ota_log_line) - pos, conv_fmt, (unsigned long long)value);
+                break;
+            case CY_OTA_LOG_CONV_PTR:
+                len = snprintf(&ota_log_line[pos], sizeof(ota_log_line) - pos, conv_fmt, (void *)(uintptr_t)value);
+                break;
+            case CY_OTA_LOG_CONV_STR:
+                len = snprintf(&ota_log_line[pos], sizeof(ota_log_line) - pos, conv_fmt, &record->strings[(uint32_t)value]);
+                break;
+            default:
+                memcpy(&d, &value, sizeof(d));
+                len = snprintf(&ota_log_line[pos], sizeof(ota_log_line) - pos, conv_fmt, d);
+                break;
+        }
+        if(len > 0)
+        {
+            pos += (size_t)len;
+        }
+    }
+
+    if(pos > (sizeof(ota_log_line) - 1u))
+    {
+        pos = sizeof(ota_log_line) - 1u;
+    }
+    ota_log_line[pos] = '\0';
+}
+
+uint32_t cy_ota_bootloader_abstraction_log_flush(uint32_t max_records)
+{
+    cy_ota_bootloader_abstraction_log_record_t record;
+    uint32_t printed = 0;
+
+    while((printed < max_records) && cy_ota_bootloader_abstraction_log_read(&record))
+    {
+        cy_ota_log_format(&record);
+        cy_log_msg((CY_LOG_FACILITY_T)record.facility, (CY_LOG_LEVEL_T)record.level, "%s", ota_log_line);
+        printed++;
+    }
+
+    return printed;
+}
+
+uint32_t cy_ota_bootloader_abstraction_log_dropped(void)
+{
+    return atomic_load_explicit(&ota_log_dropped, memory_order_relaxed);
+}
+
+#endif /* ENABLE_OTA_BOOTLOADER_ABSTRACTION_DEFERRED_LOGS */
@@ -0,0 +1,166 @@
+/*
+ * Copyright 2025, Cypress Semiconductor Corporation (an Infineon company) or
+ * an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+ *
+ * This software, including source code, documentation and related
+ * materials ("Software") is owned by Cypress Semiconductor Corporation
+ * or one of its affiliates ("Cypress") and is protected by and subject to
+ * worldwide patent protection (United States and foreign),
+ * United States copyright laws and international treaty provisions.
+ * Therefore, you may use this Software only as provided in the license
+ * agreement accompanying the software package from which you
+ * obtained this Software ("EULA").
+ * If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+ * non-transferable license to copy, modify, and compile the Software
+ * source code solely for use in connection with Cypress's
+ * integrated circuit products.  Any reproduction, modification, translation,
+ * compilation, or representation of this Software except as specified
+ * above is prohibited without the express written permission of Cypress.
+ *
+ * Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+ * reserves the right to make changes to the Software without notice. Cypress
+ * does not assume any liability arising out of the application or use of the
+ * Software or any product or circuit described in the Software. Cypress does
+ * not authorize its products for use in any products where a malfunction or
+ * failure of the Cypress product may reasonably be expected to result in
+ * significant property damage, injury or death ("High Risk Product"). By
+ * including Cypress's product in a High Risk Product, the manufacturer
+ * of such system or application assumes all risk of such use and in doing
+ * so agrees to indemnify Cypress against all liability.
+ */
+
+/*
+ *  Host benchmark for cy_ota_buffer_scan.h
+ *
+ *  Compares each helper against the byte-wise loop it replaced, on a
+ *  flash-row sized and a tar-block sized buffer. Host numbers only show the
+ *  relative gain; run on target for absolute figures.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "cy_ota_buffer_scan.h"
+
+#define BENCH_ITERATIONS    (200000u)
+
+/* Keeps the compiler from dropping the benchmarked calls */
+static volatile uint32_t bench_sink;
+
+static bool bytewise_is_filled(const uint8_t *buf, uint8_t fill, size_t len)
+{
+    size_t i;
+
+    for(i = 0u; i < len; i++)
+    {
+        if(buf[i] != fill)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool bytewise_differs(const uint8_t *buf_a, const uint8_t *buf_b, size_t len)
+{
+    size_t i;
+
+    for(i = 0u; i < len; i++)
+    {
+        if(buf_a[i] != buf_b[i])
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+static double bench_now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((double)ts.tv_sec * 1e9) + (double)ts.tv_nsec;
+}
+
+static void bench_report(const char *name, size_t len, double ref_ns, double new_ns)
+{
+    printf("%-10s %5zu bytes: byte-wise %8.1f ns, word-wise %8.1f ns, x%.1f\n",
+           name, len, ref_ns / BENCH_ITERATIONS, new_ns / BENCH_ITERATIONS, ref_ns / new_ns);
+}
+
+static void bench_len(size_t len)
+{
+    uint8_t *buf_a = malloc(len);
+    uint8_t *buf_b = malloc(len);
+    double start, ref_ns, new_ns;
+    uint32_t i;
+
+    if((buf_a == NULL) || (buf_b == NULL))
+    {
+        free(buf_a);
+        free(buf_b);
+        return;
+    }
+    memset(buf_a, 0xFF, len);
+    memset(buf_b, 0xFF, len);
+
+    /* Full scans: the buffers match, the worst case for every helper */
+    start = bench_now_ns();
+    for(i = 0u; i < BENCH_ITERATIONS; i++)
+    {
+        bench_sink += bytewise_is_filled(*(uint8_t * volatile *)&buf_a, 0xFFu, len);
+    }
+    ref_ns = bench_now_ns() - start;
+    start = bench_now_ns();
+    for(i = 0u; i < BENCH_ITERATIONS; i++)
+    {
+        bench_sink += cy_ota_buffer_is_filled(*(uint8_t * volatile *)&buf_a, 0xFFu, len);
+    }
+    new_ns = bench_now_ns() - start;
+    bench_report("is_filled", len, ref_ns, new_ns);
+
+    memset(buf_a, 0x00, len);
+    start = bench_now_ns();
+    for(i = 0u; i < BENCH_ITERATIONS; i++)
+    {
+        bench_sink += bytewise_is_filled(*(uint8_t * volatile *)&buf_a, 0x00u, len);
+    }
+    ref_ns = bench_now_ns() - start;
+    start = bench_now_ns();
+    for(i = 0u; i < BENCH_ITERATIONS; i++)
+    {
+        bench_sink += cy_ota_buffer_is_zero(*(uint8_t * volatile *)&buf_a, len);
+    }
+    new_ns = bench_now_ns() - start;
+    bench_report("is_zero", len, ref_ns, new_ns);
+
+    memset(buf_b, 0x00, len);
+    start = bench_now_ns();
+    for(i = 0u; i < BENCH_ITERATIONS; i++)
+    {
+        bench_sink += bytewise_differs(*(uint8_t * volatile *)&buf_a, buf_b, len);
+    }
+    ref_ns = bench_now_ns() - start;
+    start = bench_now_ns();
+    for(i = 0u; i < BENCH_ITERATIONS; i++)
+    {
+        bench_sink += cy_ota_buffer_differs(*(uint8_t * volatile *)&buf_a, buf_b, len);
+    }
+    new_ns = bench_now_ns() - start;
+    bench_report("differs", len, ref_ns, new_ns);
+
+    free(buf_a);
+    free(buf_b);
+}
+
+int main(void)
+{
+    bench_len(512u);    /* PSoC 6 / XMC7000 flash row, tar block */
+    bench_len(4096u);   /* external flash sector */
+    return EXIT_SUCCESS;
+}
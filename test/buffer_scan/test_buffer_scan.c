@@ -0,0 +1,209 @@
+/*
+ * Copyright 2025, Cypress Semiconductor Corporation (an Infineon company) or
+ * an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+ *
+ * This software, including source code, documentation and related
+ * materials ("Software") is owned by Cypress Semiconductor Corporation
+ * or one of its affiliates ("Cypress") and is protected by and subject to
+ * worldwide patent protection (United States and foreign),
+ * United States copyright laws and international treaty provisions.
+ * Therefore, you may use this Software only as provided in the license
+ * agreement accompanying the software package from which you
+ * obtained this Software ("EULA").
+ * If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+ * non-transferable license to copy, modify, and compile the Software
+ * source code solely for use in connection with Cypress's
+ * integrated circuit products.  Any reproduction, modification, translation,
+ * compilation, or representation of this Software except as specified
+ * above is prohibited without the express written permission of Cypress.
+ *
+ * Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+ * reserves the right to make changes to the Software without notice. Cypress
+ * does not assume any liability arising out of the application or use of the
+ * Software or any product or circuit described in the Software. Cypress does
+ * not authorize its products for use in any products where a malfunction or
+ * failure of the Cypress product may reasonably be expected to result in
+ * significant property damage, injury or death ("High Risk Product"). By
+ * including Cypress's product in a High Risk Product, the manufacturer
+ * of such system or application assumes all risk of such use and in doing
+ * so agrees to indemnify Cypress against all liability.
+ */
+
+/*
+ *  Host unit tests for cy_ota_buffer_scan.h
+ *
+ *  Every helper is checked against a byte-wise reference over all lengths up
+ *  to a few scan blocks, all source/destination alignments and every position
+ *  of a single differing byte.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "cy_ota_buffer_scan.h"
+
+#define TEST_MAX_LEN        (4u * CY_OTA_BUFFER_SCAN_BLOCK_SIZE + 7u)
+#define TEST_MAX_ALIGN      (CY_OTA_BUFFER_SCAN_WORD_SIZE)
+
+static unsigned int test_failures;
+static unsigned int test_checks;
+
+#define TEST_CHECK(cond, ...)                       \
+    do {                                            \
+        test_checks++;                              \
+        if(!(cond))                                 \
+        {                                           \
+            test_failures++;                        \
+            printf("FAIL %s:%d: ", __FILE__, __LINE__); \
+            printf(__VA_ARGS__);                    \
+            printf("\n");                           \
+        }                                           \
+    } while(0)
+
+static bool ref_is_filled(const uint8_t *buf, uint8_t fill, size_t len)
+{
+    size_t i;
+
+    for(i = 0u; i < len; i++)
+    {
+        if(buf[i] != fill)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void test_is_filled(void)
+{
+    static const uint8_t fills[] = { 0x00u, 0xFFu, 0x5Au };
+    uint8_t storage[TEST_MAX_LEN + TEST_MAX_ALIGN];
+    size_t f, align, len, pos;
+
+    for(f = 0u; f < sizeof(fills); f++)
+    {
+        for(align = 0u; align < TEST_MAX_ALIGN; align++)
+        {
+            uint8_t *buf = &storage[align];
+
+            for(len = 0u; len <= TEST_MAX_LEN; len++)
+            {
+                memset(storage, fills[f], sizeof(storage));
+                TEST_CHECK(cy_ota_buffer_is_filled(buf, fills[f], len),
+                           "is_filled fill 0x%02x align %zu len %zu", fills[f], align, len);
+
+                for(pos = 0u; pos < len; pos++)
+                {
+                    buf[pos] ^= 0x01u;
+                    TEST_CHECK(cy_ota_buffer_is_filled(buf, fills[f], len) == ref_is_filled(buf, fills[f], len),
+                               "is_filled fill 0x%02x align %zu len %zu diff at %zu", fills[f], align, len, pos);
+                    buf[pos] ^= 0x01u;
+                }
+
+                /* Bytes outside the range must not be looked at */
+                storage[0] ^= (align != 0u) ? 0x80u : 0x00u;
+                buf[len] ^= 0x80u;
+                TEST_CHECK(cy_ota_buffer_is_filled(buf, fills[f], len),
+                           "is_filled reads outside align %zu len %zu", align, len);
+            }
+        }
+    }
+}
+
+static void test_is_zero(void)
+{
+    uint8_t storage[TEST_MAX_LEN + TEST_MAX_ALIGN];
+    size_t align, len;
+
+    for(align = 0u; align < TEST_MAX_ALIGN; align++)
+    {
+        for(len = 1u; len <= TEST_MAX_LEN; len++)
+        {
+            memset(storage, 0x00, sizeof(storage));
+            TEST_CHECK(cy_ota_buffer_is_zero(&storage[align], len), "is_zero align %zu len %zu", align, len);
+            storage[align + len - 1u] = 0x80u;
+            TEST_CHECK(!cy_ota_buffer_is_zero(&storage[align], len), "is_zero last byte align %zu len %zu", align, len);
+        }
+    }
+}
+
+static void test_differs(void)
+{
+    uint8_t storage_a[TEST_MAX_LEN + TEST_MAX_ALIGN];
+    uint8_t storage_b[TEST_MAX_LEN + TEST_MAX_ALIGN];
+    size_t align_a, align_b, len, pos, i;
+
+    for(i = 0u; i < sizeof(storage_a); i++)
+    {
+        storage_a[i] = (uint8_t)(i * 7u + 3u);
+    }
+
+    for(align_a = 0u; align_a < TEST_MAX_ALIGN; align_a++)
+    {
+        for(align_b = 0u; align_b < TEST_MAX_ALIGN; align_b++)
+        {
+            uint8_t *buf_a = &storage_a[align_a];
+            uint8_t *buf_b = &storage_b[align_b];
+
+            for(len = 0u; len <= TEST_MAX_LEN; len++)
+            {
+                memset(storage_b, 0xA5, sizeof(storage_b));
+                memcpy(buf_b, buf_a, len);
+                TEST_CHECK(!cy_ota_buffer_differs(buf_a, buf_b, len),
+                           "differs equal align %zu/%zu len %zu", align_a, align_b, len);
+
+                for(pos = 0u; pos < len; pos++)
+                {
+                    buf_b[pos] ^= 0x10u;
+                    TEST_CHECK(cy_ota_buffer_differs(buf_a, buf_b, len),
+                               "differs align %zu/%zu len %zu diff at %zu", align_a, align_b, len, pos);
+                    buf_b[pos] ^= 0x10u;
+                }
+            }
+        }
+    }
+}
+
+static void test_copy(void)
+{
+    uint8_t src_storage[TEST_MAX_LEN + TEST_MAX_ALIGN];
+    uint8_t dst_storage[TEST_MAX_LEN + 2u * TEST_MAX_ALIGN];
+    size_t align_s, align_d, len, i;
+
+    for(i = 0u; i < sizeof(src_storage); i++)
+    {
+        src_storage[i] = (uint8_t)(i * 13u + 1u);
+    }
+
+    for(align_s = 0u; align_s < TEST_MAX_ALIGN; align_s++)
+    {
+        for(align_d = 0u; align_d < TEST_MAX_ALIGN; align_d++)
+        {
+            for(len = 0u; len <= TEST_MAX_LEN; len++)
+            {
+                uint8_t *dst = &dst_storage[align_d + 1u];
+
+                memset(dst_storage, 0xEE, sizeof(dst_storage));
+                cy_ota_buffer_copy(dst, &src_storage[align_s], len);
+                TEST_CHECK(memcmp(dst, &src_storage[align_s], len) == 0,
+                           "copy align %zu/%zu len %zu", align_s, align_d, len);
+                TEST_CHECK((dst[-1] == 0xEEu) && (dst[len] == 0xEEu),
+                           "copy writes outside align %zu/%zu len %zu", align_s, align_d, len);
+            }
+        }
+    }
+}
+
+int main(void)
+{
+    test_is_filled();
+    test_is_zero();
+    test_differs();
+    test_copy();
+
+    printf("%u checks, %u failures\n", test_checks, test_failures);
+    return (test_failures == 0u) ? EXIT_SUCCESS : EXIT_FAILURE;
+}